@@ -245,6 +245,7 @@ static short box_delete(BOXP* prm) {
   long i = 0L;
   long j = 0;
   long num_to_move = 0, length_diff = 0;
+  long num_deleted = 0L;
   short rc = 0;
   bool shadow_found = FALSE;
   bool advance_line_ptr = TRUE;
@@ -269,18 +270,20 @@ static short box_delete(BOXP* prm) {
              * delete from start column to end of line
              */
             if (prm->src_start_col < curr->length) {
-              add_to_recovery_list(curr->line, curr->length);
+              journal_change(MARK_FILE, prm->src_start_line, curr->line, curr->length, curr->line, prm->src_start_col);
               curr->length = prm->src_start_col;
             }
           } else if (i + 1 == prm->num_lines) { /* last line of stream block */
             if (curr->length > 0) {
-              add_to_recovery_list(curr->line, curr->length);
+              journal_change(MARK_FILE, prm->src_start_line + i - num_deleted, curr->line, curr->length, NULL, 0L);
               curr->length = (long) (prm->src_end_col < curr->length - 1) ? curr->length - prm->src_end_col - 1 : 0;
               for (j = 0; j < curr->length; j++) {
                 *(curr->line + (long)j) = *(curr->line + prm->src_end_col + j + 1);
               }
+              journal_changed_line(MARK_FILE, curr);
             }
           } else {
+            journal_delete(MARK_FILE, prm->src_start_line + i - num_deleted++, curr->line, curr->length);
             curr = delete_LINE(&MARK_FILE->first_line, &MARK_FILE->last_line, curr, DIRECTION_FORWARD, TRUE);
             MARK_FILE->number_lines--;
             advance_line_ptr = FALSE;
@@ -293,12 +296,13 @@ static short box_delete(BOXP* prm) {
             num_to_move = length_diff = 0;
           }
           if (length_diff != 0) {
-            add_to_recovery_list(curr->line, curr->length);
+            journal_change(MARK_FILE, prm->src_start_line + i, curr->line, curr->length, NULL, 0L);
             curr->length = (long) ((long) curr->length - (long) length_diff);
             for (j = 0; j < num_to_move; j++) {
               *(curr->line + (long) ((long) j + (long) MARK_VIEW->mark_start_col - 1L)) = *(curr->line + prm->src_start_col + j + prm->num_cols);
             }
             *(curr->line + curr->length) = '\0';        /* null terminate */
+            journal_changed_line(MARK_FILE, curr);
           }
         }
     }
@@ -313,7 +317,8 @@ static short box_delete(BOXP* prm) {
   if ((prm->mark_type == M_STREAM || prm->mark_type == M_CUA) && prm->src_start_line != prm->src_end_line && !shadow_found) {
     curr = prm->curr_src;
     if (curr->next->length > 0) {
-      curr->line = (uchar *) realloc((void *) curr->line, (curr->length + curr->next->length) * sizeof(uchar));
+      journal_change(MARK_FILE, prm->src_start_line, curr->line, curr->length, NULL, 0L);
+      curr->line = resize_LINE(curr, curr->length + curr->next->length + 1);
       if (curr->line == NULL) {
         display_error(30, (uchar *) "", FALSE);
         return (RC_OUT_OF_MEMORY);
@@ -325,7 +330,9 @@ static short box_delete(BOXP* prm) {
         curr->length = max_line_length;
       }
       *(curr->line + curr->length) = '\0';      /* do we need to do this anymore ? */
+      journal_changed_line(MARK_FILE, curr);
     }
+    journal_delete(MARK_FILE, prm->src_start_line + 1L, curr->next->line, curr->next->length);
     curr = delete_LINE(&MARK_FILE->first_line, &MARK_FILE->last_line, curr->next, DIRECTION_FORWARD, TRUE);
     MARK_FILE->number_lines--;
   }
@@ -336,6 +343,8 @@ static short box_move(BOXP *prm, bool boverlay, bool copy_to_temp) {
   LINE *save_src = NULL, *temp_src = NULL;
   long save_src_start_line = 0L;
   long save_src_start_col = 0;
+  long number_lines = 0L;
+  bool same_file = (bool) (prm->src_view->file_for_view == prm->dst_view->file_for_view);
 
   save_src_start_col = prm->src_start_col;
   save_src_start_line = prm->src_start_line;
@@ -346,9 +355,17 @@ static short box_move(BOXP *prm, bool boverlay, bool copy_to_temp) {
   if (prm->dst_start_col <= prm->src_start_col + prm->num_cols && prm->action == BOX_M) {
     temp_src = prm->curr_src;   /* save the LINE pointer to temp src lines */
     prm->curr_src = save_src;   /* point to file src lines */
+    number_lines = MARK_FILE->number_lines;
     box_delete(prm);
     prm->curr_src = temp_src;   /* point to temp src lines */
+    /*
+     * Lines deleted above the destination move it up.
+     */
+    if (same_file && prm->src_start_line < prm->dst_start_line) {
+      prm->dst_start_line -= number_lines - MARK_FILE->number_lines;
+    }
   }
+  number_lines = CURRENT_FILE->number_lines;
   if (copy_to_temp) {
     prm->src_start_line = 0L;
     prm->src_start_col = 0;
@@ -363,10 +380,14 @@ static short box_move(BOXP *prm, bool boverlay, bool copy_to_temp) {
   prm->src_start_col = save_src_start_col;
   prm->curr_src = save_src;
   /*
-   * Now delete the source for a MOVE
+   * Now delete the source for a MOVE; lines added above the source move it down.
    */
   if (prm->dst_start_col > prm->src_start_col + prm->num_cols && prm->action == BOX_M) {
+    if (same_file && prm->dst_start_line < prm->src_start_line) {
+      prm->src_start_line += MARK_FILE->number_lines - number_lines;
+    }
     box_delete(prm);
+    prm->src_start_line = save_src_start_line;
   }
 
   return (RC_OK);
@@ -436,6 +457,7 @@ static short box_copy_from_temp(BOXP *prm, bool boverlay) {
           return (RC_OUT_OF_MEMORY);
         }
         CURRENT_FILE->number_lines++;
+        journal_insert(CURRENT_FILE, dst_lineno, 1L);
         break;
       }
       dst_lineno++;
@@ -496,6 +518,7 @@ static short box_copy_stream_from_temp(BOXP *prm, bool boverlay) {
             return (RC_OUT_OF_MEMORY);
           }
           CURRENT_FILE->number_lines++;
+          journal_insert(CURRENT_FILE, dst_lineno, 1L);
           break;
         }
         dst_lineno++;
@@ -548,6 +571,7 @@ static short box_copy_stream_from_temp(BOXP *prm, bool boverlay) {
           return (RC_OUT_OF_MEMORY);
         }
         CURRENT_FILE->number_lines++;
+        journal_insert(CURRENT_FILE, dst_lineno, 1L);
         break;
       }
       dst_lineno++;
@@ -577,23 +601,24 @@ static short box_copy_stream_from_temp(BOXP *prm, bool boverlay) {
          */
         add_LINE(CURRENT_FILE->first_line, curr, (rec), rec_len, curr->select, TRUE);
         CURRENT_FILE->number_lines++;
+        journal_insert(CURRENT_FILE, dst_lineno + 1L, 1L);
         last_line = curr->next;
         /*
          * Get the current line back into rec so we can trim it at
          * the cursor position.
          */
-        pre_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, curr);
+        pre_process_line(CURRENT_VIEW, dst_lineno, curr);
         memset(rec + prm->dst_start_col, ' ', max_line_length - prm->dst_start_col);
         memcpy(rec + prm->dst_start_col, prm->curr_src->line, min(max_line_length - prm->dst_start_col, prm->curr_src->length));
         rec_len = prm->curr_src->length + prm->dst_start_col;
-        post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, curr, FALSE);
+        post_process_line(CURRENT_VIEW, dst_lineno, curr, FALSE);
         prm->curr_src = prm->curr_src->next;    /* this should NEVER go past the end */
         curr = prm->curr_dst;
       } else if (i + 1 == prm->num_lines) {     /* last line - prepend to "last_line" */
-        pre_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, last_line);
+        pre_process_line(CURRENT_VIEW, dst_lineno + prm->num_lines - 1L, last_line);
         meminsmem(rec, prm->curr_src->line, prm->curr_src->length, 0, max_line_length, last_line->length);
         rec_len = min(max_line_length, rec_len + prm->curr_src->length);
-        post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, last_line, FALSE);
+        post_process_line(CURRENT_VIEW, dst_lineno + prm->num_lines - 1L, last_line, FALSE);
         /*
          * Save the position at the end of the inserted stream block.
          */
@@ -608,6 +633,7 @@ static short box_copy_stream_from_temp(BOXP *prm, bool boverlay) {
         }
         prm->curr_src = prm->curr_src->next;    /* this should NEVER go past the end */
         CURRENT_FILE->number_lines++;
+        journal_insert(CURRENT_FILE, dst_lineno + i, 1L);
       }
     }
     pre_process_line(prm->dst_view, dst_lineno, prm->curr_dst);
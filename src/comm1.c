@@ -65,6 +65,8 @@ short All(uchar *params) {
   unsigned short x = 0, y = 0;
   bool save_scope = FALSE;
   long num_lines = 0L;
+  short *line_status = NULL;
+  long tested = 0L, next = 0L;
 
   if (strlen((char *) params) == 0) {
     if (CURRENT_FILE->number_lines == 0L) {
@@ -98,6 +100,12 @@ short All(uchar *params) {
     free_target(&target);
     return (RC_INVALID_OPERAND);
   }
+  line_status = (short *) malloc(min(SCAN_WINDOW_LINES, CURRENT_FILE->number_lines + 1L) * sizeof(short));
+  if (line_status == NULL) {
+    free_target(&target);
+    display_error(30, (uchar *) "", FALSE);
+    return (RC_OUT_OF_MEMORY);
+  }
   /*
    * Save the select levels for all lines in case no target is found.
    */
@@ -121,7 +129,14 @@ short All(uchar *params) {
    */
   target.all_tag_command = TRUE;
   for (line_number = 0L; curr->next != NULL; line_number++) {
-    status = find_rtarget_target(curr, &target, 0L, line_number, &num_lines);
+    /*
+     * The lines are tested a window at a time, possibly on several threads.
+     */
+    if (next == tested) {
+      tested = find_rtarget_lines(&target, curr, 0L, line_number, min(SCAN_WINDOW_LINES, CURRENT_FILE->number_lines + 1L - line_number), line_status, &num_lines);
+      next = 0L;
+    }
+    status = line_status[next++];
     if (status == RC_OK) {      /* target found */
       target_found = TRUE;
       curr->select = 1;
@@ -172,6 +187,7 @@ short All(uchar *params) {
       rc = status;
     }
   }
+  free(line_status);
   free_target(&target);
   return (rc);
 }
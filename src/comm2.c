@@ -774,7 +774,7 @@ short Get(uchar *params) {
   LINE *curr = NULL;
   LINE *save_curr = NULL;
   LINE *save_next = NULL;
-  long old_number_lines = 0L, true_line = 0L;
+  long old_number_lines = 0L, true_line = 0L, first_new_line = 0L;
   short rc = RC_OK;
   long fromline = 1L, numlines = 0L;
   uchar buffer[100];
@@ -848,8 +848,10 @@ short Get(uchar *params) {
   }
   true_line = get_true_line(TRUE);
   curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, true_line, CURRENT_FILE->number_lines);
+  first_new_line = true_line + 1L;
   if (curr->next == NULL) {     /* on bottom of file */
     curr = curr->prev;
+    first_new_line = true_line;
   }
   old_number_lines = CURRENT_FILE->number_lines;
   save_curr = curr;
@@ -868,6 +870,7 @@ short Get(uchar *params) {
     return (RC_ACCESS_DENIED);
   }
   fclose(fp);
+  journal_insert(CURRENT_FILE, first_new_line, CURRENT_FILE->number_lines - old_number_lines);
   pre_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL);
   /*
    * Fix the positioning of the marked block (if there is one and it is in the current view).
@@ -422,7 +422,7 @@ short Recover(uchar *params) {
   uchar strip[REC_PARAMS];
   uchar *word[REC_PARAMS + 1];
   unsigned short num_params = 0;
-  short num = 0;
+  long num = 0L;
 
   /*
    * Validate the parameters that have been supplied.
@@ -438,20 +438,20 @@ short Recover(uchar *params) {
       break;
     case 1:
       if (strcmp((char *) word[0], "*") == 0) {
-        num = 99;
+        num = MAX_LONG;
       } else {
         if (!valid_positive_integer(word[0])) {
           display_error(4, word[0], FALSE);
           return (RC_INVALID_OPERAND);
         }
-        num = atoi((char *) word[0]);
+        num = atol((char *) word[0]);
       }
       break;
     default:
       display_error(1, word[1], FALSE);
       return (RC_INVALID_OPERAND);
   }
-  get_from_recovery_list(num);
+  journal_recover(num);
   return (RC_OK);
 }
 
@@ -513,6 +513,13 @@ short Redit(uchar *params) {
   return (rc);
 }
 
+short Redo(uchar *params) {
+  short rc = RC_OK;
+
+  rc = execute_undo(params, TRUE);
+  return (rc);
+}
+
 short Redraw(uchar *params) {
   if (strcmp((char *) params, "") != 0) {
     display_error(1, params, FALSE);
@@ -643,6 +650,7 @@ short Replace(uchar *params) {
   LINE *curr = NULL;
   ushort current_select = 0;
   THELIST *name = NULL;
+  LINE_EXTRA *extra = NULL;
 
   post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL, TRUE);
   if (CURRENT_VIEW->hex) {
@@ -669,13 +677,11 @@ short Replace(uchar *params) {
   }
   curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, true_line, CURRENT_FILE->number_lines);
   current_select = curr->select;
-  add_to_recovery_list(curr->line, curr->length);
+  journal_change(CURRENT_FILE, true_line, curr->line, curr->length, params, len_params);
   /*
    * If the line has at least one name, save it to reinstate later...
    */
-  if (curr->first_name) {
-    name = curr->first_name;
-  }
+  name = LINE_FIRST_NAME(curr);
   /*
    * Delete the line, but don't delete the line names...
    */
@@ -691,7 +697,12 @@ short Replace(uchar *params) {
    * Put the line's name back if we had one...
    */
   if (name) {
-    curr->first_name = name;
+    if ((extra = lll_extra(curr, TRUE)) == NULL) {
+      ll_free(name, free);
+      display_error(30, (uchar *) "", FALSE);
+      return (RC_OUT_OF_MEMORY);
+    }
+    extra->first_name = name;
   }
   pre_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL);
   build_screen(current_screen);
@@ -127,6 +127,8 @@ short Tag(uchar *params) {
   int relative = TAG_REPLACE;
   unsigned short num_params = 0;
   uchar *save_params = NULL;
+  short *line_status = NULL;
+  long tested = 0L, next = 0L;
 
   strip[0] = STRIP_BOTH;
   strip[1] = STRIP_LEADING;
@@ -231,11 +233,24 @@ short Tag(uchar *params) {
        * Tell the target finding stuff we are the TAG command...
        */
       target.all_tag_command = TRUE;
+      line_status = (short *) malloc(min(SCAN_WINDOW_LINES, CURRENT_FILE->number_lines + 1L) * sizeof(short));
+      if (line_status == NULL) {
+        display_error(30, (uchar *) "", FALSE);
+        status = RC_OUT_OF_MEMORY;
+        break;
+      }
       curr = CURRENT_FILE->first_line;
       status = FALSE;
       /*CURRENT_VIEW->scope_all = TRUE; */
       for (line_number = 0L; curr->next != NULL; line_number++) {
-        status = find_rtarget_target(curr, &target, 0L, line_number, &num_lines);
+        /*
+         * The lines are tested a window at a time, possibly on several threads.
+         */
+        if (next == tested) {
+          tested = find_rtarget_lines(&target, curr, 0L, line_number, min(SCAN_WINDOW_LINES, CURRENT_FILE->number_lines + 1L - line_number), line_status, &num_lines);
+          next = 0L;
+        }
+        status = line_status[next++];
         if (status == RC_OK) {  /* target found */
           target_found = TRUE;
           if (relative == TAG_LESS) {
@@ -252,6 +267,7 @@ short Tag(uchar *params) {
         }
         curr = curr->next;
       }
+      free(line_status);
       break;
   }
   /*
@@ -551,7 +567,7 @@ short Toascii(uchar *params) {
         num_actual_lines++;
         break;
       default:
-        add_to_recovery_list(curr->line, curr->length);
+        journal_change(CURRENT_FILE, true_line + (long) (i * direction), curr->line, curr->length, NULL, 0L);
         if (MARK_VIEW && (MARK_VIEW->mark_type == M_STREAM || MARK_VIEW->mark_type == M_CUA)) {
           int mystart = 0, myend = curr->length - 1;
 
@@ -565,6 +581,7 @@ short Toascii(uchar *params) {
         } else {
           ebc2asc(curr->line, curr->length, start_col, end_col);
         }
+        journal_changed_line(CURRENT_FILE, curr);
         if (rc) {
           adjust_alt = TRUE;
           curr->flags.changed_flag = TRUE;
@@ -634,6 +651,13 @@ short Top(uchar *params) {
   return (rc);
 }
 
+short Undo(uchar *params) {
+  short rc = RC_OK;
+
+  rc = execute_undo(params, FALSE);
+  return (rc);
+}
+
 short Up(uchar *params) {
   short rc = RC_OK;
   long num_lines = 0L, true_line = 0L;
@@ -240,10 +240,11 @@ COMMAND command[] =
 {(uchar*) "quit",          4, (-1), Quit, TRUE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" }, /* comm4.c */
 {(uchar*) "query",         1, (-1), Query, FALSE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },      /* comm4.c */
 {(uchar*) "record",        6, (-1), THERecord, FALSE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, TRUE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },  /* comm4.c */
-{(uchar*) "recover",       3, KEY_F(8), Recover, FALSE, FALSE, FALSE, FALSE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_RESET_ALL, (uchar *) "" },        /* comm4.c */
+{(uchar*) "recover",       3, KEY_F(8), Recover, TRUE, FALSE, FALSE, FALSE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_RESET_ALL, (uchar *) "" },        /* comm4.c */
 {(uchar*) "readv",         5, (-1), Readv, TRUE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },       /* comm4.c */
 {(uchar*) "readonly",      8, (-1), THEReadonly, TRUE, TRUE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },       /* commset2.c */
 {(uchar*) "redit",         5, (-1), Redit, FALSE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },      /* comm4.c */
+{(uchar*) "redo",          4, (-1), Redo, TRUE, FALSE, FALSE, FALSE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_RESET_ALL, (uchar *) "" },  /* comm4.c */
 {(uchar*) "redraw",        6, KEY_C_r, Redraw, FALSE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" }, /* comm4.c */
 {(uchar*) "refresh",       7, (-1), THERefresh, FALSE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },       /* comm4.c */
 {(uchar*) "repeat",        4, (-1), Repeat, TRUE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },     /* comm4.c */
@@ -346,6 +347,7 @@ COMMAND command[] =
 {(uchar*) "top",           3, (-1), Top, TRUE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },   /* comm5.c */
 {(uchar*) "trailing",      8, (-1), Trailing, TRUE, TRUE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },  /* commset2.c */
 {(uchar*) "typeahead",     5, (-1), THETypeahead, TRUE, TRUE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },     /* commset2.c */
+{(uchar*) "undo",          4, (-1), Undo, TRUE, FALSE, FALSE, FALSE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_RESET_ALL, (uchar *) "" },  /* comm5.c */
 {(uchar*) "undoing",       7, (-1), Undoing, TRUE, TRUE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },    /* commset2.c */
 {(uchar*) "up",            1, (-1), Up, TRUE, FALSE, FALSE, TRUE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_NONE, (uchar *) "" },     /* comm5.c */
 {(uchar*) "uppercase",     3, (-1), Uppercase, TRUE, FALSE, FALSE, FALSE, FALSE, STRIP_BOTH, FALSE, FALSE, TRUE, CUA_RESET_BLOCK, THIGHLIGHT_RESET_ALL, (uchar *) "" }, /* comm5.c */
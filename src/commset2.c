@@ -251,8 +251,8 @@ short Pending(uchar *params) {
        * and that would stuff up the pending prefix command linked list.
        * Just set the pedning prefix command to processed and it will be cleaned up later.
        */
-      if (curr->pre) {
-        curr->pre->ppc_processed = TRUE;
+      if (LINE_PRE(curr)) {
+        LINE_PRE(curr)->ppc_processed = TRUE;
       }
       memset(pre_rec, ' ', MAX_PREFIX_WIDTH);
       pre_rec_len = 0;
@@ -1326,6 +1326,7 @@ short Statopt(uchar *params) {
   unsigned short num_params = 0;
   short rc = RC_OK;
   LINE *curr = NULL;
+  LINE_EXTRA *extra = NULL;
   int tail = 0, len = 0, col = 0, itemno = 0;
   uchar item_type = 0;
 
@@ -1414,18 +1415,18 @@ short Statopt(uchar *params) {
       }
       /*
        * Use the name member to store the option name so that lll_locate() can find it.
+       * An option that cannot be named is taken off the list again.
        */
-      curr->name = (uchar *) malloc((strlen((char *) word[1]) + 1) * sizeof(uchar));
-      if (curr->name == NULL) {
+      if ((extra = lll_extra(curr, TRUE)) == NULL || (extra->name = (uchar *) malloc((strlen((char *) word[1]) + 1) * sizeof(uchar))) == NULL) {
+        lll_del(&first_option, &last_option, curr, DIRECTION_FORWARD);
         display_error(30, (uchar *) "", FALSE);
         return (RC_OUT_OF_MEMORY);
       }
-      strcpy((char *) curr->name, (char *) make_upper(word[1]));
+      strcpy((char *) extra->name, (char *) make_upper(word[1]));
 
       curr->length = itemno;
       curr->select = (ushort) col - STATAREA_OFFSET - 1;
       curr->save_select = (ushort) len;
-      curr->pre = NULL;
       if (num_params > 4) {
         curr->line = (uchar *) malloc((strlen((char *) word[4]) + 1) * sizeof(uchar));
         if (curr->line == NULL) {
@@ -10,8 +10,10 @@
 
 static uchar *build_defined_key_definition(int, uchar *, DEFINE *, int);
 static void save_last_command(uchar *, uchar *);
+static short execute_command_line(uchar *, bool);
 void AdjustThighlight(int);
 static bool save_target(TARGET *);
+static void load_lines_for_command(short, bool);
 
 #define HEXVAL(c) (((c)>'9')?(tolower(c)-'a'+10):((c)-'0'))
 
@@ -284,6 +286,61 @@ uchar *get_key_definition(int key, int define_format, bool default_keys, bool mo
   return (temp_cmd);
 }
 
+/*
+ * Commands bound to keys by default that move about or edit near the focus
+ * line, so need no more of a file still being read than a screen or two
+ * past it.
+ */
+static short (*lazy_key_functions[]) (uchar *) = {
+  Backward, Cursor, DeleteLine, Duplicate, Enter, Forward, Insertmode, Join, Mark, Nextwindow, Qquit, Redraw, Reset, Retrieve, Split,
+  Sos_addline, Sos_cursoradj, Sos_delback, Sos_delchar, Sos_delend, Sos_delline, Sos_delword, Sos_makecurr, Sos_pastecmdline,
+  Sos_startendchar, Sos_tabf, Sos_tabwordb, Sos_tabwordf, Sos_undo, NULL
+};
+
+/*
+ * SET commands that walk the lines of the file.
+ */
+static short (*file_set_functions[]) (uchar *) = {
+  Display, Lineflag, Pending, Select, Tabsin, Trailing, NULL
+};
+
+static void load_lines_for_command(short i, bool default_key) {
+  short j = 0;
+
+  if (number_of_files == 0 || CURRENT_FILE->lazy_load == NULL) {
+    return;
+  }
+  /*
+   * Pending prefix commands, run by ENTER, may reach any line.
+   */
+  if (default_key && CURRENT_FILE->first_ppc == NULL) {
+    for (j = 0; lazy_key_functions[j] != NULL; j++) {
+      if (command[i].function == lazy_key_functions[j]) {
+        load_file_lines(CURRENT_FILE, max(CURRENT_VIEW->current_line, CURRENT_VIEW->focus_line) + 2 * CURRENT_SCREEN.rows[WINDOW_FILEAREA]);
+        return;
+      }
+    }
+  }
+  /*
+   * SET and SOS check the command they run themselves.
+   */
+  if (command[i].function == Set || command[i].function == Sos) {
+    return;
+  }
+  if (command[i].set_command) {
+    for (j = 0; file_set_functions[j] != NULL; j++) {
+      if (command[i].function == file_set_functions[j]) {
+        break;
+      }
+    }
+    if (file_set_functions[j] == NULL) {
+      return;
+    }
+  }
+  complete_file_load(CURRENT_FILE);
+  return;
+}
+
 static short execute_synonym(uchar *synonym, uchar *params) {
   DEFINE *curr = (DEFINE *) NULL;
   short rc = RC_FILE_NOT_FOUND;
@@ -364,6 +421,7 @@ static short execute_synonym(uchar *synonym, uchar *params) {
         if (CURRENT_VIEW->thighlight_on && CURRENT_VIEW->thighlight_active) {
           AdjustThighlight(command[curr->def_command].thighlight_behaviour);
         }
+        load_lines_for_command(curr->def_command, FALSE);
         rc = (*command[curr->def_command].function) ((uchar *) key_cmd);
       }
       free(key_cmd);
@@ -486,6 +544,7 @@ short function_key(int key, int option, bool mouse_details_present) {
           if (CURRENT_VIEW->thighlight_on && CURRENT_VIEW->thighlight_active) {
             AdjustThighlight(command[curr->def_command].thighlight_behaviour);
           }
+          load_lines_for_command(curr->def_command, FALSE);
           rc = (*command[curr->def_command].function) ((uchar *) key_cmd);
         }
         free(key_cmd);
@@ -613,6 +672,7 @@ short function_key(int key, int option, bool mouse_details_present) {
           if (CURRENT_VIEW->thighlight_on && CURRENT_VIEW->thighlight_active) {
             AdjustThighlight(command[i].thighlight_behaviour);
           }
+          load_lines_for_command(i, TRUE);
           rc = (*command[i].function) ((uchar *) key_cmd);
           free(key_cmd);
           break;
@@ -954,7 +1014,24 @@ int set_rexx_variables_for_all_keys(int key_type, int *number_keys_return) {
   return (RC_OK);
 }
 
+/*
+ * Executes a command line. The edits made by a command line entered by
+ * the user, including those of the macros it runs, are undone together.
+ */
 short command_line(uchar *cmd_line, bool command_only) {
+  static short command_depth = 0;
+  short rc = RC_OK;
+
+  if (command_depth == 0) {
+    journal_begin_command();
+  }
+  command_depth++;
+  rc = execute_command_line(cmd_line, command_only);
+  command_depth--;
+  return (rc);
+}
+
+static short execute_command_line(uchar *cmd_line, bool command_only) {
   bool valid_command = FALSE;
   bool target_found;
   bool linend_status = (number_of_files) ? CURRENT_VIEW->linend_status : LINEND_STATUSx;
@@ -1153,6 +1230,7 @@ short command_line(uchar *cmd_line, bool command_only) {
         /*
          * Now call the function associated with the supplied command string and the possibly stripped parameters.
          */
+        load_lines_for_command(i, FALSE);
         lastrc = rc = (*command[i].function) (cl_param);
         break;
       }
@@ -1185,6 +1263,7 @@ short command_line(uchar *cmd_line, bool command_only) {
     } else {
       display_parse_error = FALSE;
     }
+    complete_file_load(CURRENT_FILE);
     rc = execute_locate(cmd[j], display_parse_error, THE_NOT_SEARCH_SEMANTICS, &target_found);
     if (rc == RC_OK || rc == RC_TOF_EOF_REACHED || rc == RC_TARGET_NOT_FOUND || target_found) {
       lastrc = rc;
@@ -2165,7 +2244,11 @@ long find_prev_tab_col(long x) {
 #define STATE_NORMAL 0
 #define STATE_TAB    1
 
-short tabs_convert(LINE *curr, bool expand_tabs, bool use_tabs, bool add_to_recovery) {
+/*
+ * line_number is that of curr in the current file, for the journal,
+ * or 0 if the conversion is not journalled.
+ */
+short tabs_convert(LINE *curr, bool expand_tabs, bool use_tabs, long line_number) {
   long i, j;
   bool expanded = FALSE;
   bool tabs_exhausted = FALSE;
@@ -2218,10 +2301,10 @@ short tabs_convert(LINE *curr, bool expand_tabs, bool use_tabs, bool add_to_reco
      * If we expanded tabs, we need to reallocate memory for the line.
      */
     if (expanded) {
-      if (add_to_recovery) {
-        add_to_recovery_list(curr->line, curr->length);
+      if (line_number) {
+        journal_change(CURRENT_FILE, line_number, curr->line, curr->length, trec, j);
       }
-      curr->line = (uchar *) realloc((void *) curr->line, (j + 1) * sizeof(uchar));
+      curr->line = resize_LINE(curr, j + 1);
       if (curr->line == (uchar *) NULL) {
         display_error(30, (uchar *) "", FALSE);
         return (RC_OUT_OF_MEMORY);
@@ -2266,12 +2349,18 @@ short tabs_convert(LINE *curr, bool expand_tabs, bool use_tabs, bool add_to_reco
       }
     }
     if (expanded) {
+      if (line_number) {
+        journal_change(CURRENT_FILE, line_number, curr->line, curr->length, NULL, 0L);
+      }
       trec[j] = '\0';
       curr->length = j;
       for (i = 0, j--; j > (-1); i++, j--) {
         *(curr->line + i) = trec[j];
       }
       *(curr->line + curr->length) = '\0';
+      if (line_number) {
+        journal_changed_line(CURRENT_FILE, curr);
+      }
     }
   }
   return ((expanded) ? RC_FILE_CHANGED : RC_OK);
@@ -2570,6 +2659,7 @@ short execute_set_sos_command(bool set_command, uchar *params) {
     if (CURRENT_VIEW->thighlight_on && CURRENT_VIEW->thighlight_active) {
       AdjustThighlight(command[command_index].thighlight_behaviour);
     }
+    load_lines_for_command(command_index, FALSE);
     rc = (*command[command_index].function) (word[1]);
   }
   return (rc);
@@ -3005,6 +3095,7 @@ short execute_mouse_commands(int key) {
         if (CURRENT_VIEW->thighlight_on && CURRENT_VIEW->thighlight_active) {
           AdjustThighlight(command[curr->def_command].thighlight_behaviour);
         }
+        load_lines_for_command(curr->def_command, FALSE);
         rc = (*command[curr->def_command].function) ((uchar *) key_cmd);
       }
       free(key_cmd);
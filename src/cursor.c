@@ -1214,19 +1214,26 @@ short advance_current_line(long num_lines) {
     direction = DIRECTION_BACKWARD;
   }
   post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL, TRUE);
-  curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, CURRENT_VIEW->current_line, CURRENT_FILE->number_lines);
-  while (actual_lines > 0) {
-    if (direction == DIRECTION_BACKWARD) {
-      curr = curr->prev;
-    } else {
-      curr = curr->next;
-    }
-    if (curr == NULL) {
-      break;
-    }
-    CURRENT_VIEW->current_line += (long) direction;
-    if (CURRENT_VIEW->scope_all || IN_SCOPE(CURRENT_VIEW, curr)) {
-      actual_lines--;
+  if (CURRENT_VIEW->scope_all) {
+    /*
+     * Every line counts, so there is no need to walk to the new current line.
+     */
+    CURRENT_VIEW->current_line = max(0L, min(CURRENT_VIEW->current_line + num_lines, CURRENT_FILE->number_lines + 1L));
+  } else {
+    curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, CURRENT_VIEW->current_line, CURRENT_FILE->number_lines);
+    while (actual_lines > 0) {
+      if (direction == DIRECTION_BACKWARD) {
+        curr = curr->prev;
+      } else {
+        curr = curr->next;
+      }
+      if (curr == NULL) {
+        break;
+      }
+      CURRENT_VIEW->current_line += (long) direction;
+      if (IN_SCOPE(CURRENT_VIEW, curr)) {
+        actual_lines--;
+      }
     }
   }
   build_screen(current_screen);
@@ -797,6 +797,13 @@ short default_file_attributes(FILE_DETAILS *fd) {
   CURRENT_FILE->first_line = (LINE *) NULL;
   CURRENT_FILE->last_line = (LINE *) NULL;
   CURRENT_FILE->editv = (LINE *) NULL;
+  CURRENT_FILE->first_text_block = (TEXT_BLOCK *) NULL;
+  memset(&CURRENT_FILE->line_pool, 0, sizeof(LINE_POOL));
+  memset(&CURRENT_FILE->undo, 0, sizeof(JOURNAL));
+  memset(&CURRENT_FILE->redo, 0, sizeof(JOURNAL));
+  CURRENT_FILE->journal_altered = CURRENT_FILE->journal_recorded = 0L;
+  memset(&CURRENT_FILE->comment_cache, 0, sizeof(COMMENT_CACHE));
+  CURRENT_FILE->lazy_load = (LAZY_LOAD *) NULL;
   CURRENT_FILE->first_reserved = (RESERVED *) NULL;
   CURRENT_FILE->fmode = 0;
   CURRENT_FILE->modtime = 0;
@@ -852,10 +859,15 @@ void set_screen_defaults(void) {
         free((void *) screen[0].sl[i].highlight_type);
         screen[0].sl[i].highlight_type = NULL;
       }
+      if (screen[0].sl[i].shown.contents) {
+        free((void *) screen[0].sl[i].shown.contents);
+        screen[0].sl[i].shown.contents = NULL;
+      }
     }
     free(screen[0].sl);
     screen[0].sl = NULL;
   }
+  free_parsed_lines(0);
   if (screen[1].sl != NULL) {
     /*
      * Free up allocated pointers for each SHOW_LINE
@@ -865,10 +877,15 @@ void set_screen_defaults(void) {
         free((void *) screen[1].sl[i].highlight_type);
         screen[1].sl[i].highlight_type = NULL;
       }
+      if (screen[1].sl[i].shown.contents) {
+        free((void *) screen[1].sl[i].shown.contents);
+        screen[1].sl[i].shown.contents = NULL;
+      }
     }
     free(screen[1].sl);
     screen[1].sl = NULL;
   }
+  free_parsed_lines(1);
   /*
    * Set values that affect the placement of each screen depending on the position of the status line...
    */
@@ -42,6 +42,8 @@ int process_key(int key, bool mouse_details_present) {
   unsigned short x = 0, y = 0;
   short rc = RC_OK;
   uchar string_key[2];
+  WINDOW *loading_window = NULL;
+  uchar i = 0;
 
   string_key[1] = '\0';
   if (is_termresized()) {
@@ -52,7 +54,31 @@ int process_key(int key, bool mouse_details_present) {
     key = process_fifo_input(key);
   }
   if (key == (-1)) {
+    /*
+     * While a file is being read in the background, stop waiting for a key
+     * now and then to add the lines read so far and show its size.
+     */
+    if (file_loads_pending() && curses_started) {
+      loading_window = CURRENT_WINDOW;
+      wtimeout(loading_window, LAZY_LOAD_TICK);
+      errno = 0;
+    }
+    start_highlighting_ahead();
     key = my_getch(CURRENT_WINDOW);
+    complete_highlighting_ahead();
+    if (loading_window) {
+      wtimeout(loading_window, -1);
+      if (key == (-1) && update_file_loads()) {
+        getyx(CURRENT_WINDOW, y, x);
+        for (i = 0; i < display_screens; i++) {
+          if (SCREEN_WINDOW_IDLINE(i) != NULL) {
+            show_heading(i);
+          }
+        }
+        wmove(CURRENT_WINDOW, y, x);
+        wrefresh(CURRENT_WINDOW);
+      }
+    }
   }
   if (key != KEY_MOUSE) {
     if (!mouse_details_present) {
@@ -127,6 +153,7 @@ int process_key(int key, bool mouse_details_present) {
     write_macro(get_key_definition(key, THE_KEY_DEFINE_RAW, TRUE, (bool) ((key == KEY_MOUSE) ? TRUE : FALSE)));
   }
   save_for_repeat = 0;
+  journal_begin_command();
   rc = function_key(key, OPTION_NORMAL, mouse_details_present);
   save_for_repeat = 1;
   if (number_of_files == 0) {
@@ -302,6 +329,7 @@ short EditFile(uchar *fn, bool external_command_line) {
    * If startup values were specified on the command, line, move cursor there...
    */
   if (startup_line != 0 || startup_column != 0) {
+    load_file_lines(CURRENT_FILE, startup_line + CURRENT_SCREEN.rows[WINDOW_FILEAREA]);
     THEcursor_goto(startup_line, startup_column);
   }
   filetabs_start_view = NULL;
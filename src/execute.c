@@ -136,6 +136,8 @@ short execute_change_command(uchar *in_params, bool selective) {
   long num_file_lines = 0L;
   long len_old_str = 0, len_new_str = 0;
   TARGET target;
+  MEMFIND finder;
+  uchar *finder_needle = NULL;
   uchar message[100];
   bool lines_based_on_scope = FALSE;
   uchar *save_params = NULL;
@@ -266,6 +268,15 @@ short execute_change_command(uchar *in_params, bool selective) {
     post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL, TRUE);
   }
   last_true_line = true_line;
+  /*
+   * Prepare the string to be changed once, rather than for each search.
+   */
+  if ((finder_needle = (uchar *) alloca(len_old_str + 1)) == NULL) {
+    free_target(&target);
+    display_error(30, (uchar *) "", FALSE);
+    return (RC_OUT_OF_MEMORY);
+  }
+  memfind_compile(&finder, finder_needle, old_str, len_old_str, (bool) ((CURRENT_VIEW->case_change == CASE_IGNORE) ? TRUE : FALSE), CURRENT_VIEW->arbchar_status, CURRENT_VIEW->arbchar_single, CURRENT_VIEW->arbchar_multiple);
   curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, true_line, CURRENT_FILE->number_lines);
   for (i = 0L, num_actual_lines = 0L;; i++) {
     if (lines_based_on_scope) {
@@ -321,7 +332,7 @@ short execute_change_command(uchar *in_params, bool selective) {
             loc = 0;
             rec_len = real_start + 1;
           } else {
-            loc = memfind(rec + real_start, old_str, real_end - real_start + 1, len_old_str, (bool) ((CURRENT_VIEW->case_change == CASE_IGNORE) ? TRUE : FALSE), CURRENT_VIEW->arbchar_status, CURRENT_VIEW->arbchar_single, CURRENT_VIEW->arbchar_multiple, &str_length);
+            loc = memfind_run(&finder, rec + real_start, real_end - real_start + 1, &str_length);
           }
           if (loc != (-1)) {
             start_col = loc + real_start;
@@ -469,6 +480,7 @@ short insert_new_line(uchar curr_screen, VIEW_DETAILS *curr_view, uchar *line, l
       return (RC_OUT_OF_MEMORY);
     }
   }
+  journal_insert(curr_view->file_for_view, true_line + 1L, num_lines);
   /*
    * Fix the positioning of the marked block (if there is one and it is in the current view)
    * and any pending prefix commands.
@@ -715,14 +727,14 @@ short execute_shift_command(uchar curr_screen, VIEW_DETAILS *curr_view, bool shi
         if (actual_cols != 0) {
           adjust_alt = TRUE;
           /*
-           * Add the old line contents to the line recovery list.
+           * Journal the change to the line.
            */
-          add_to_recovery_list(curr->line, curr->length);
+          journal_change(curr_view->file_for_view, true_line + (long) (i * direction), curr->line, curr->length, trec, trec_len);
           /*
            * Realloc the dynamic memory for the line if the line is now longer.
            */
           if (trec_len > curr->length) {
-            curr->line = (uchar *) realloc((void *) curr->line, (trec_len + 1) * sizeof(uchar));
+            curr->line = resize_LINE(curr, trec_len + 1);
             if (curr->line == NULL) {
               display_error(30, (uchar *) "", FALSE);
               return (RC_OUT_OF_MEMORY);
@@ -828,9 +840,11 @@ short execute_set_lineflag(unsigned int new_flag, unsigned int changed_flag, uns
   }
   /*
    * Increment the alteration counters once if any line has changed...
+   * Only the flags of the lines have changed, so the journal still holds.
    */
   if (adjust_alt) {
     increment_alt(CURRENT_FILE);
+    journal_unchanged(CURRENT_FILE);
   }
   /*
    * Display the new screen...
@@ -905,7 +919,7 @@ short do_actual_change_case(long true_line, long num_lines, uchar which_case, bo
         num_actual_lines++;
         break;
       default:
-        add_to_recovery_list(curr->line, curr->length);
+        journal_change(CURRENT_FILE, true_line + (long) (i * direction), curr->line, curr->length, NULL, 0L);
         if (MARK_VIEW && (MARK_VIEW->mark_type == M_STREAM || MARK_VIEW->mark_type == M_CUA)) {
           int mystart = 0, myend = curr->length - 1;
 
@@ -923,6 +937,7 @@ short do_actual_change_case(long true_line, long num_lines, uchar which_case, bo
           adjust_alt = TRUE;
           curr->flags.changed_flag = TRUE;
         }
+        journal_changed_line(CURRENT_FILE, curr);
         num_actual_lines++;
         break;
     }
@@ -1019,9 +1034,10 @@ short rearrange_line_blocks(uchar command, uchar source, long start_line, long e
   bool dest_in_block = FALSE;
   short direction = 0;
   long num_lines = 0L, off = 0L, adjust_line = dest_line, num_actual_lines = 0L;
-  long i = 0L, num_pseudo_lines = 0L;
+  long i = 0L, num_pseudo_lines = 0L, num_added = 0L, num_deleted = 0L;
   LINE *curr_src = NULL, *curr_dst = NULL;
   LINE *save_curr_src = NULL, *save_curr_dst = NULL;
+  LINE_EXTRA *extra = NULL;
   FILE_DETAILS *src_file = NULL, *dst_file = NULL;
 
   src_file = src_view->file_for_view;
@@ -1078,7 +1094,7 @@ short rearrange_line_blocks(uchar command, uchar source, long start_line, long e
       for (k = 0; k < num_occ; k++) {
         curr_src = save_curr_src;
         curr_dst = save_curr_dst;
-        for (i = 0L, num_actual_lines = 0L;; i++) {
+        for (i = 0L, num_actual_lines = 0L, num_added = 0L;; i++) {
           if (lines_based_on_scope) {
             if (num_actual_lines == num_lines) {
               break;
@@ -1102,14 +1118,15 @@ short rearrange_line_blocks(uchar command, uchar source, long start_line, long e
                 display_error(30, (uchar *) "", FALSE);
                 return (RC_OUT_OF_MEMORY);
               }
+              journal_insert(dst_file, dest_line + 1L + ((direction == DIRECTION_FORWARD) ? num_added++ : 0L), 1L);
               /*
                * If moving lines within the same file, move any line
                * name with the line also.
                */
               if (command == COMMAND_MOVE_COPY_SAME) {
-                if (curr_src->first_name != (THELIST *) NULL) {
-                  curr_dst->first_name = curr_src->first_name;
-                  curr_src->first_name = (THELIST *) NULL;
+                if (LINE_FIRST_NAME(curr_src) != (THELIST *) NULL && (extra = lll_extra(curr_dst, TRUE)) != NULL) {
+                  extra->first_name = LINE_FIRST_NAME(curr_src);
+                  lll_extra(curr_src, FALSE)->first_name = (THELIST *) NULL;
                 }
               }
               if (direction == DIRECTION_BACKWARD) {
@@ -1177,9 +1194,10 @@ short rearrange_line_blocks(uchar command, uchar source, long start_line, long e
             }
             break;
           default:
-            if (command != COMMAND_MOVE_DELETE_SAME) {
-              add_to_recovery_list(curr_dst->line, curr_dst->length);
-            }
+            /*
+             * Lines deleted going forward move the rest up.
+             */
+            journal_delete(dst_file, start_line + ((direction == DIRECTION_FORWARD) ? i - num_deleted++ : -i), curr_dst->line, curr_dst->length);
             curr_dst = delete_LINE(&dst_file->first_line, &dst_file->last_line, curr_dst, direction, TRUE);
             num_actual_lines++;
         }
@@ -1374,6 +1392,7 @@ short execute_set_point(uchar curr_screen, VIEW_DETAILS *curr_view, uchar *name,
   long dummy = 0L;
   uchar *this_name;
   THELIST *curr_name;
+  LINE_EXTRA *extra = NULL;
 
   /*
    * Find a line that already has the same name.
@@ -1387,7 +1406,7 @@ short execute_set_point(uchar curr_screen, VIEW_DETAILS *curr_view, uchar *name,
      */
     curr_name = find_line_name(curr, name);
     if (curr_name) {
-      ll_del(&curr->first_name, NULL, curr_name, DIRECTION_FORWARD, free);
+      ll_del(&lll_extra(curr, FALSE)->first_name, NULL, curr_name, DIRECTION_FORWARD, free);
     }
   }
   if (point_on) {
@@ -1404,8 +1423,13 @@ short execute_set_point(uchar curr_screen, VIEW_DETAILS *curr_view, uchar *name,
       return (RC_OUT_OF_MEMORY);
     }
     strcpy((char *) this_name, (char *) name);
-    curr->first_name = ll_add(curr->first_name, NULL, sizeof(THELIST));
-    curr->first_name->data = (void *) this_name;
+    if ((extra = lll_extra(curr, TRUE)) == NULL) {
+      free(this_name);
+      display_error(30, (uchar *) "", FALSE);
+      return (RC_OUT_OF_MEMORY);
+    }
+    extra->first_name = ll_add(extra->first_name, NULL, sizeof(THELIST));
+    extra->first_name->data = (void *) this_name;
   }
   if (!point_on && curr == NULL) {
     /*
@@ -1514,6 +1538,7 @@ short execute_wrap_word(long col) {
     }
     curr = add_LINE(CURRENT_FILE->first_line, curr, buf, length_word + CURRENT_VIEW->margin_left - 1, curr->select, TRUE);
     CURRENT_FILE->number_lines++;
+    journal_insert(CURRENT_FILE, CURRENT_VIEW->focus_line + 1L, 1L);
   } else {
     post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL, TRUE);
     pre_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line + 1L, (LINE *) NULL);
@@ -1618,8 +1643,10 @@ short execute_split_join(short action, bool aligned, bool cursorarg) {
       }
       add_LINE(CURRENT_FILE->first_line, curr, (rec), rec_len, curr->select, TRUE);
       CURRENT_FILE->number_lines++;
+      journal_insert(CURRENT_FILE, true_line + 1L, 1L);
       if (CURRENT_VIEW->current_window == WINDOW_COMMAND || cursorarg == FALSE) {
         if (curr->length > col) {
+          journal_change(CURRENT_FILE, true_line, curr->line, curr->length, curr->line, col);
           curr->length = col;
           *(curr->line + (col)) = '\0';
           increment_alt(CURRENT_FILE);
@@ -1674,6 +1701,7 @@ short execute_split_join(short action, bool aligned, bool cursorarg) {
       meminsmem(rec, curr->next->line + num_cols, curr->next->length - num_cols, col, max_line_length, col);
       rec_len = col + curr->next->length - num_cols;
       post_process_line(CURRENT_VIEW, true_line, (LINE *) NULL, TRUE);
+      journal_delete(CURRENT_FILE, true_line + 1L, curr->next->line, curr->next->length);
       curr = delete_LINE(&CURRENT_FILE->first_line, &CURRENT_FILE->last_line, curr->next, DIRECTION_BACKWARD, TRUE);
       if (CURRENT_VIEW->current_window == WINDOW_COMMAND) {
         pre_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL);
@@ -2074,7 +2102,7 @@ short processable_line(VIEW_DETAILS *view, long true_line, LINE *curr) {
   return (LINE_SHADOW);
 }
 
-short execute_expand_compress(uchar *params, bool expand, bool inc_alt, bool use_tabs, bool add_to_recovery) {
+short execute_expand_compress(uchar *params, bool expand, bool inc_alt, bool use_tabs, bool journalled) {
   long i = 0L, num_actual_lines = 0L;
   long num_lines = 0L, true_line = 0L, num_file_lines = 0L;
   short direction = 0, rc = RC_OK;
@@ -2162,7 +2190,7 @@ short execute_expand_compress(uchar *params, bool expand, bool inc_alt, bool use
         num_actual_lines++;
         break;
       default:
-        rc = tabs_convert(curr, expand, use_tabs, add_to_recovery);
+        rc = tabs_convert(curr, expand, use_tabs, (journalled) ? true_line + (long) (i * direction) : 0L);
         if (rc == RC_FILE_CHANGED) {
           adjust_alt = TRUE;
         } else {
@@ -2188,6 +2216,9 @@ short execute_expand_compress(uchar *params, bool expand, bool inc_alt, bool use
   if (inc_alt && adjust_alt) {
     increment_alt(CURRENT_FILE);
   }
+  if (!journalled && adjust_alt) {
+    journal_discard(CURRENT_FILE);
+  }
   /*
    * If STAY is OFF, change the current and focus lines by the number of lines calculated from the target.
    */
@@ -2201,6 +2232,35 @@ short execute_expand_compress(uchar *params, bool expand, bool inc_alt, bool use
   return (rc);
 }
 
+short execute_undo(uchar *params, bool redo) {
+  long num = 1L;
+  short rc = RC_OK;
+
+  /*
+   * The only parameter is the number of commands to undo (or redo), or '*' for all of them.
+   * If no parameter is supplied, 1 is assumed.
+   */
+  params = strstrip(params, STRIP_BOTH, ' ');
+  if (strcmp((char *) params, "*") == 0) {
+    num = MAX_LONG;
+  } else if (strcmp((char *) params, "") != 0) {
+    if (!valid_positive_integer(params)) {
+      display_error(4, params, FALSE);
+      return (RC_INVALID_OPERAND);
+    }
+    num = atol((char *) params);
+  }
+  /*
+   * Changes to the focus line not yet in the file are the last edit to undo.
+   */
+  post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL, TRUE);
+  rc = journal_undo(redo, num);
+  pre_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL);
+  build_screen(current_screen);
+  display_screen(current_screen);
+  return (rc);
+}
+
 short execute_select(uchar *params, bool relative, short off) {
   long i = 0L, num_actual_lines = 0L;
   long num_lines = 0L, true_line = 0L;
@@ -2489,6 +2549,7 @@ long calculate_rec_len(short action, uchar *rec, long current_rec_len, long star
 static short set_editv(uchar *var, uchar *val, bool editv_file, bool rexx_var) {
   short rc = RC_OK;
   LINE *curr = NULL;
+  LINE_EXTRA *extra = NULL;
   int len_var = 0, len_val = 0;
   uchar *value = NULL;
   LINE *first = NULL;
@@ -2548,8 +2609,19 @@ static short set_editv(uchar *var, uchar *val, bool editv_file, bool rexx_var) {
     } else {
       editv = curr;
     }
+    /*
+     * Every variable in the list has a name, so a variable that cannot be completed is taken off again.
+     */
     curr->line = (uchar *) malloc((len_val + 1) * sizeof(uchar));
-    if (curr->line == NULL) {
+    if (curr->line == NULL || (extra = lll_extra(curr, TRUE)) == NULL || (extra->name = (uchar *) malloc((len_var + 1) * sizeof(uchar))) == NULL) {
+      if (curr->line != NULL) {
+        free(curr->line);
+      }
+      if (editv_file) {
+        lll_del(&(CURRENT_FILE->editv), NULL, curr, DIRECTION_FORWARD);
+      } else {
+        lll_del(&editv, NULL, curr, DIRECTION_FORWARD);
+      }
       if (rexx_var && value) {
         free(value);
       }
@@ -2558,15 +2630,7 @@ static short set_editv(uchar *var, uchar *val, bool editv_file, bool rexx_var) {
     }
     strcpy((char *) curr->line, (char *) value);
     curr->length = len_val;
-    curr->name = (uchar *) malloc((len_var + 1) * sizeof(uchar));
-    if (curr->name == NULL) {
-      if (rexx_var && value) {
-        free(value);
-      }
-      display_error(30, (uchar *) "", FALSE);
-      return (RC_OUT_OF_MEMORY);
-    }
-    strcpy((char *) curr->name, (char *) var);
+    strcpy((char *) extra->name, (char *) var);
   }
   if (rexx_var && value) {
     free(value);
@@ -2579,7 +2643,7 @@ static short set_editv(uchar *var, uchar *val, bool editv_file, bool rexx_var) {
 short execute_editv(short editv_type, bool editv_file, uchar *params) {
   uchar *word[EDITV_PARAMS + 1];
   uchar strip[EDITV_PARAMS];
-  uchar *p = NULL, *str = NULL;
+  uchar *p = NULL, *str = NULL, *name = NULL;
   unsigned short num_params = 0;
   LINE *curr = NULL, *first = NULL;
   int key = 0, lineno = 0, i, len_str, len_name, rem, x;
@@ -2640,13 +2704,14 @@ short execute_editv(short editv_type, bool editv_file, uchar *params) {
       }
       curr = first;
       while (curr) {
-        if (curr->name && strlen((char *) curr->name) > len_name && memcmpi(curr->name, params, len_name) == 0) {
+        name = LINE_NAME(curr);
+        if (name && strlen((char *) name) > len_name && memcmpi(name, params, len_name) == 0) {
           if (curr->line) {
             str = curr->line;
           } else {
             str = (uchar *) "";
           }
-          rc = set_rexx_variable(curr->name, str, strlen((char *) str), -1);
+          rc = set_rexx_variable(name, str, strlen((char *) str), -1);
           if (rc != RC_OK) {
             break;
           }
@@ -2664,14 +2729,15 @@ short execute_editv(short editv_type, bool editv_file, uchar *params) {
           } else {
             str = (uchar *) "";
           }
+          name = LINE_NAME(curr);
           attrset(A_BOLD);
-          mvaddstr(lineno, 0, (char *) curr->name);
+          mvaddstr(lineno, 0, (char *) name);
           attrset(A_NORMAL);
           /*
            * Calculate maximum length of string to display so we don't wrap.
            */
           if (curr) {
-            len_name = strlen((char *) curr->name);
+            len_name = strlen((char *) lll_extra(curr, FALSE)->name);
           } else {
             len_name = 0;
           }
@@ -2711,7 +2777,7 @@ short execute_editv(short editv_type, bool editv_file, uchar *params) {
            * Calculate maximum length of string to display so we don't wrap.
            */
           if (curr) {
-            len_name = strlen((char *) curr->name);
+            len_name = strlen((char *) lll_extra(curr, FALSE)->name);
           } else {
             len_name = 0;
           }
@@ -9,8 +9,11 @@
 
 #include <errno.h>
 
-static short write_line(uchar *, long, FILE *, short);
-static short write_char(uchar, FILE *);
+static short write_line(uchar *, long, SAVE_BUFFER *, short);
+static short write_char(uchar, SAVE_BUFFER *);
+static short write_bytes(uchar *, long, SAVE_BUFFER *);
+static short flush_bytes(SAVE_BUFFER *);
+static bool file_replaceable(struct stat *);
 
 LINE *dir_first_line = NULL;
 LINE *dir_last_line = NULL;
@@ -25,6 +28,45 @@ static short process_file_attributes(int restore_attributes, FILE_DETAILS *cf, u
   }
 }
 
+/*
+ * Returns TRUE if the file can be replaced by a new one that looks the
+ * same: it has no other links, and the new file can be given its owner
+ * and group.
+ */
+static bool file_replaceable(struct stat *st) {
+  gid_t *groups;
+  int i, num_groups;
+  bool result = FALSE;
+
+  if (st->st_nlink != 1) {
+    return (FALSE);
+  }
+  if (geteuid() == 0) {
+    return (TRUE);
+  }
+  if (st->st_uid != geteuid()) {
+    return (FALSE);
+  }
+  if (st->st_gid == getegid()) {
+    return (TRUE);
+  }
+  if ((num_groups = getgroups(0, NULL)) <= 0) {
+    return (FALSE);
+  }
+  if ((groups = (gid_t *) malloc(num_groups * sizeof(gid_t))) == NULL) {
+    return (FALSE);
+  }
+  num_groups = getgroups(num_groups, groups);
+  for (i = 0; i < num_groups; i++) {
+    if (groups[i] == st->st_gid) {
+      result = TRUE;
+      break;
+    }
+  }
+  free(groups);
+  return (result);
+}
+
 short get_file(uchar *filename) {
   LINE *curr = NULL;
   uchar *work_filename;
@@ -292,7 +334,7 @@ short get_file(uchar *filename) {
   /*
    * first_line is set to "Top of File"
    */
-  if ((CURRENT_FILE->first_line = add_LINE(CURRENT_FILE->first_line, NULL, TOP_OF_FILE, strlen((char *) TOP_OF_FILE), 0, FALSE)) == NULL) {
+  if ((CURRENT_FILE->first_line = add_pooled_LINE(CURRENT_FILE, NULL, TOP_OF_FILE, strlen((char *) TOP_OF_FILE), 0, FALSE)) == NULL) {
     if (CURRENT_FILE->disposition != FILE_NEW) {
       fclose(CURRENT_FILE->fp);
     }
@@ -381,6 +423,545 @@ short get_file(uchar *filename) {
 #define THE_LF '\n'
 #define DOSEOF 26
 
+static uchar *find_eol(uchar *ptr, uchar *end) {
+  unsigned long ones = ~0UL / 255;
+  unsigned long highs = ones * 0x80;
+  unsigned long word = 0, cr = 0, lf = 0;
+
+  /*
+   * Check a word at a time for a CR or LF byte, then find which byte it was.
+   */
+  for (; ptr + sizeof(word) <= end; ptr += sizeof(word)) {
+    memcpy(&word, ptr, sizeof(word));
+    cr = word ^ (ones * THE_CR);
+    lf = word ^ (ones * THE_LF);
+    if ((((cr - ones) & ~cr) | ((lf - ones) & ~lf)) & highs) {
+      break;
+    }
+  }
+  for (; ptr < end && *ptr != THE_CR && *ptr != THE_LF; ptr++);
+  return (ptr);
+}
+
+static void set_eolfirst(uchar *eol, uchar *end) {
+  if (*eol == THE_CR && eol + 1 < end && *(eol + 1) == THE_LF) {
+    CURRENT_FILE->eolfirst = EOLOUT_CRLF;
+  } else if (*eol == THE_CR) {
+    CURRENT_FILE->eolfirst = EOLOUT_CR;
+  } else {
+    CURRENT_FILE->eolfirst = EOLOUT_LF;
+  }
+  return;
+}
+
+static void *split_range(void *arg) {
+  LOAD_RANGE *range = (LOAD_RANGE *) arg;
+  uchar *line_start = range->start;
+  uchar *eol = NULL;
+  long len = 0;
+  LINE *curr = NULL;
+
+  while (line_start < range->end) {
+    eol = find_eol(line_start, range->end);
+    len = eol - line_start;
+    if (len > max_line_length) {
+      range->too_long = range->lines + 1;
+      return (NULL);
+    }
+    if ((curr = lll_new(&range->pool)) == NULL) {
+      range->no_memory = TRUE;
+      return (NULL);
+    }
+    curr->line = line_start;
+    if (range->trim) {
+      len = 1 + memrevne(line_start, ' ', len);
+    }
+    curr->length = len;
+    curr->flags.shared_flag = TRUE;
+    curr->prev = range->last;
+    if (range->last) {
+      range->last->next = curr;
+    } else {
+      range->first = curr;
+    }
+    range->last = curr;
+    if (len > range->maxlen) {
+      range->maxlen = len;
+    }
+    range->lines++;
+    line_start = eol + 1;
+    if (eol < range->end && *eol == THE_CR && eol + 1 < range->end && *(eol + 1) == THE_LF) {
+      line_start++;
+    }
+    *eol = '\0';
+    if (range->trim) {
+      *(curr->line + len) = '\0';
+    }
+  }
+  return (NULL);
+}
+
+static LINE *split_whole_file(uchar *text, uchar *end, LINE *curr, uchar *filename, int num_threads) {
+  LOAD_RANGE ranges[MAX_LOAD_THREADS];
+  pthread_t threads[MAX_LOAD_THREADS];
+  bool started[MAX_LOAD_THREADS];
+  uchar *eol = NULL;
+  long lines_read = 0L;
+  long maxlen = 0;
+  LINE *prev = curr;
+  LINE *next = curr->next;
+  int i = 0;
+
+  if ((eol = find_eol(text, end)) < end) {
+    set_eolfirst(eol, end);
+  }
+  /*
+   * Divide the file into equal ranges, moving the start of each range on to
+   * the start of a line. This is done before any thread writes to the file.
+   */
+  memset(ranges, 0, sizeof(ranges));
+  ranges[0].start = text;
+  for (i = 1; i < num_threads; i++) {
+    eol = find_eol(text + (end - text) / num_threads * i - 1, end);
+    if (eol < end && *eol == THE_CR && eol + 1 < end && *(eol + 1) == THE_LF) {
+      eol++;
+    }
+    ranges[i].start = min(eol + 1, end);
+    if (ranges[i].start < ranges[i - 1].start) {
+      ranges[i].start = ranges[i - 1].start;
+    }
+    ranges[i - 1].end = ranges[i].start;
+  }
+  ranges[num_threads - 1].end = end;
+  /*
+   * Split the first range on this thread, and if any other thread cannot
+   * be started, split its range here too.
+   */
+  for (i = 1; i < num_threads; i++) {
+    started[i] = (pthread_create(&threads[i], NULL, split_range, &ranges[i]) == 0);
+  }
+  split_range(&ranges[0]);
+  for (i = 1; i < num_threads; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    } else {
+      split_range(&ranges[i]);
+    }
+  }
+  /*
+   * Report the first range, in file order, that could not be split.
+   */
+  for (i = 0; i < num_threads; i++) {
+    if (ranges[i].too_long || ranges[i].no_memory) {
+      break;
+    }
+    lines_read += ranges[i].lines;
+  }
+  if (i < num_threads) {
+    if (ranges[i].too_long) {
+      sprintf((char *) trec, "Line %ld exceeds max. width of %ld. File: %s", lines_read + ranges[i].too_long, max_line_length, filename);
+      display_error(29, trec, FALSE);
+    }
+    for (i = 0; i < num_threads; i++) {
+      lll_free_pool(&ranges[i].pool);
+    }
+    CURRENT_FILE->first_line = CURRENT_FILE->last_line = lll_free(CURRENT_FILE->first_line);
+    return (NULL);
+  }
+  /*
+   * Join the lines from each range, in order, after the current line.
+   */
+  for (i = 0; i < num_threads; i++) {
+    lll_merge_pool(&CURRENT_FILE->line_pool, &ranges[i].pool);
+    if (ranges[i].first == NULL) {
+      continue;
+    }
+    prev->next = ranges[i].first;
+    ranges[i].first->prev = prev;
+    prev = ranges[i].last;
+    if (ranges[i].maxlen > maxlen) {
+      maxlen = ranges[i].maxlen;
+    }
+  }
+  prev->next = next;
+  if (next) {
+    next->prev = prev;
+  }
+  if (CURRENT_FILE->first_line->chunk) {
+    lll_reindex(CURRENT_FILE->first_line);
+  }
+  if (lines_read && curr->prev == NULL && CURRENT_VIEW && CURRENT_FILE->parser == NULL) {
+    find_auto_parser(CURRENT_FILE);
+  }
+  CURRENT_FILE->max_line_length = maxlen;
+  CURRENT_FILE->number_lines += lines_read;
+  return (prev);
+}
+
+/*
+ * Large files edited interactively are read a block at a time. read_file()
+ * reads and splits the first block itself, so the first screen can be shown
+ * at once, and a thread reads and splits the rest of the file into the
+ * same buffer, one range of lines per block. The ranges are added to the
+ * end of the file, before Bottom of File, only on the main thread: as the
+ * screen is built past the lines added so far, while waiting for a key, and
+ * before anything that could reach the rest of the file.
+ */
+
+static LAZY_LOAD *lazy_loads = NULL;
+
+static uchar *after_last_eol(uchar *start, uchar *end) {
+  uchar *ptr = end;
+
+  /*
+   * A CR at the end of what has been read may be the first half of a CRLF,
+   * so it does not end a line until the next byte is known.
+   */
+  if (ptr > start && *(ptr - 1) == THE_CR) {
+    ptr--;
+  }
+  for (; ptr > start && *(ptr - 1) != THE_LF && *(ptr - 1) != THE_CR; ptr--);
+  return (ptr);
+}
+
+static void read_block(LAZY_LOAD *load) {
+  long want = min(LAZY_LOAD_BLOCK, load->size - load->offset);
+  ssize_t num = 0;
+
+  /*
+   * Should the file have shrunk since its size was found, or be unreadable,
+   * it ends with what could be read.
+   */
+  while (want > 0) {
+    if ((num = pread(load->fd, load->text + load->offset, want, (off_t) load->offset)) == (-1) && errno == EINTR) {
+      continue;
+    }
+    if (num <= 0) {
+      load->size = load->offset;
+      break;
+    }
+    load->offset += num;
+    want -= num;
+  }
+  return;
+}
+
+static void *read_rest_of_file(void *arg) {
+  LAZY_LOAD *load = (LAZY_LOAD *) arg;
+  LOAD_RANGE *range = NULL;
+  uchar *start = load->ranges[0].end;
+  uchar *end = NULL;
+  long num_ranges = 1L;
+  bool last = FALSE, stop = FALSE;
+
+  /*
+   * The first block has been read and split by read_file(); the lines of
+   * each block after it that are complete make up a range.
+   */
+  read_block(load);
+  while (!stop) {
+    last = (load->offset == load->size);
+    end = load->text + load->offset;
+    if (last) {
+      for (; end > start && *(end - 1) == DOSEOF; end--);
+    } else {
+      end = after_last_eol(start, end);
+      if (end == start && load->text + load->offset - start <= max_line_length) {
+        read_block(load);
+        continue;
+      }
+      if (end == start) {
+        end = load->text + load->offset;
+      }
+    }
+    range = load->ranges + num_ranges;
+    range->start = start;
+    range->end = end;
+    range->trim = load->trim;
+    split_range(range);
+    start = end;
+    pthread_mutex_lock(&load->mutex);
+    load->num_ranges = ++num_ranges;
+    if (last || range->too_long || range->no_memory) {
+      load->finished = TRUE;
+    }
+    stop = (load->finished || load->stop);
+    pthread_cond_signal(&load->cond);
+    pthread_mutex_unlock(&load->mutex);
+    if (!stop) {
+      read_block(load);
+    }
+  }
+  return (NULL);
+}
+
+static LAZY_LOAD *new_lazy_load(int fd, long size, uchar *filename) {
+  LAZY_LOAD *load = NULL;
+
+  if ((load = (LAZY_LOAD *) malloc(sizeof(LAZY_LOAD))) == NULL) {
+    return (NULL);
+  }
+  memset(load, 0, sizeof(LAZY_LOAD));
+  /*
+   * Each range but the first ends in a block read after the previous one.
+   */
+  load->max_ranges = size / LAZY_LOAD_BLOCK + 2L;
+  if ((load->ranges = (LOAD_RANGE *) calloc(load->max_ranges, sizeof(LOAD_RANGE))) == NULL) {
+    free(load);
+    return (NULL);
+  }
+  if ((load->fd = dup(fd)) == (-1)) {
+    free(load->ranges);
+    free(load);
+    return (NULL);
+  }
+  if ((load->text = alloc_text(CURRENT_FILE, size)) == NULL) {
+    close(load->fd);
+    free(load->ranges);
+    free(load);
+    return (NULL);
+  }
+  load->file = CURRENT_FILE;
+  load->size = size;
+  load->trim = (CURRENT_FILE->trailing == TRAILING_OFF && display_length == 0);
+  strncpy((char *) load->filename, (char *) filename, MAX_FILE_NAME);
+  pthread_mutex_init(&load->mutex, NULL);
+  pthread_cond_init(&load->cond, NULL);
+  return (load);
+}
+
+static void free_lazy_load(LAZY_LOAD *load) {
+  LAZY_LOAD **prev = NULL;
+
+  for (prev = &lazy_loads; *prev != NULL && *prev != load; prev = &(*prev)->next);
+  if (*prev != NULL) {
+    *prev = load->next;
+  }
+  load->file->lazy_load = NULL;
+  for (; load->next_range < load->num_ranges; load->next_range++) {
+    lll_free_pool(&load->ranges[load->next_range].pool);
+  }
+  pthread_mutex_destroy(&load->mutex);
+  pthread_cond_destroy(&load->cond);
+  close(load->fd);
+  free(load->ranges);
+  free(load);
+  return;
+}
+
+static LINE *start_lazy_load(LAZY_LOAD *load, LINE *curr) {
+  LOAD_RANGE *range = load->ranges;
+  uchar *eol = NULL;
+
+  read_block(load);
+  if ((eol = find_eol(load->text, load->text + load->offset)) < load->text + load->offset) {
+    set_eolfirst(eol, load->text + load->offset);
+  }
+  /*
+   * Split the first block here; TRAILING OFF is applied to its lines by
+   * get_file(), as it is to a file read whole.
+   */
+  range->start = load->text;
+  range->end = load->text + load->offset;
+  if (load->offset == load->size) {
+    for (; range->end > range->start && *(range->end - 1) == DOSEOF; range->end--);
+  } else {
+    range->end = after_last_eol(range->start, range->end);
+  }
+  split_range(range);
+  load->next_range = load->num_ranges = 1L;
+  if (range->too_long || range->no_memory) {
+    if (range->too_long) {
+      sprintf((char *) trec, "Line %ld exceeds max. width of %ld. File: %s", range->too_long, max_line_length, load->filename);
+      display_error(29, trec, FALSE);
+    }
+    lll_free_pool(&range->pool);
+    free_lazy_load(load);
+    CURRENT_FILE->first_line = CURRENT_FILE->last_line = lll_free(CURRENT_FILE->first_line);
+    return (NULL);
+  }
+  lll_merge_pool(&CURRENT_FILE->line_pool, &range->pool);
+  if (range->first) {
+    lll_join(CURRENT_FILE->first_line, curr, range->first, range->last, range->lines);
+    curr = range->last;
+  }
+  CURRENT_FILE->max_line_length = range->maxlen;
+  CURRENT_FILE->number_lines += range->lines;
+  load->lines_read = range->lines;
+  /*
+   * If the thread cannot be started, the rest of the file is read here.
+   */
+  load->started = (pthread_create(&load->thread, NULL, read_rest_of_file, load) == 0);
+  if (!load->started) {
+    read_rest_of_file(load);
+  }
+  load->next = lazy_loads;
+  lazy_loads = load;
+  CURRENT_FILE->lazy_load = load;
+  return (curr);
+}
+
+static void finish_lazy_load(LAZY_LOAD *load) {
+  FILE_DETAILS *cf = load->file;
+  LOAD_RANGE *range = load->ranges + load->num_ranges - 1;
+
+  if (load->started) {
+    pthread_join(load->thread, NULL);
+  }
+  /*
+   * If a line could not be added, the file keeps the lines before it and
+   * is made readonly, so that it cannot be saved incomplete.
+   */
+  if (range->too_long) {
+    sprintf((char *) trec, "Line %ld exceeds max. width of %ld. File: %s", load->lines_read + 1, max_line_length, load->filename);
+    display_error(29, trec, FALSE);
+    cf->readonly = READONLY_ON;
+  } else if (range->no_memory) {
+    display_error(30, (uchar *) "", FALSE);
+    cf->readonly = READONLY_ON;
+  }
+  free_lazy_load(load);
+  return;
+}
+
+void load_file_lines(FILE_DETAILS *cf, long line_number) {
+  LAZY_LOAD *load = cf->lazy_load;
+  LOAD_RANGE *range = NULL;
+  long num_ranges = 0L;
+  bool finished = FALSE;
+
+  /*
+   * Add the ranges split so far to the end of the file, waiting for more
+   * until the file has line_number lines or all of its lines. A line_number
+   * of 0 adds whatever has been split without waiting.
+   */
+  while (load != NULL) {
+    pthread_mutex_lock(&load->mutex);
+    while (load->next_range == load->num_ranges && !load->finished && cf->number_lines < line_number) {
+      pthread_cond_wait(&load->cond, &load->mutex);
+    }
+    num_ranges = load->num_ranges;
+    finished = load->finished;
+    pthread_mutex_unlock(&load->mutex);
+    for (; load->next_range < num_ranges && (line_number == 0L || cf->number_lines < line_number); load->next_range++) {
+      range = load->ranges + load->next_range;
+      lll_merge_pool(&cf->line_pool, &range->pool);
+      if (range->first) {
+        lll_join(cf->first_line, cf->last_line->prev, range->first, range->last, range->lines);
+        cf->number_lines += range->lines;
+        load->lines_read += range->lines;
+        if (range->maxlen > cf->max_line_length) {
+          cf->max_line_length = range->maxlen;
+        }
+      }
+    }
+    if (finished && load->next_range == num_ranges) {
+      finish_lazy_load(load);
+      break;
+    }
+    if (line_number == 0L || cf->number_lines >= line_number) {
+      break;
+    }
+  }
+  return;
+}
+
+void complete_file_load(FILE_DETAILS *cf) {
+  load_file_lines(cf, MAX_LONG);
+  return;
+}
+
+bool update_file_loads(void) {
+  LAZY_LOAD *load = NULL, *next = NULL;
+  long num_ranges = 0L;
+  bool updated = FALSE;
+
+  /*
+   * Add the ranges split so far of each file being read, without waiting.
+   */
+  for (load = lazy_loads; load != NULL; load = next) {
+    next = load->next;
+    pthread_mutex_lock(&load->mutex);
+    num_ranges = load->num_ranges;
+    pthread_mutex_unlock(&load->mutex);
+    if (num_ranges > load->next_range) {
+      load_file_lines(load->file, 0L);
+      updated = TRUE;
+    }
+  }
+  return (updated);
+}
+
+bool file_loads_pending(void) {
+  return (lazy_loads != NULL);
+}
+
+void stop_file_load(FILE_DETAILS *cf) {
+  LAZY_LOAD *load = cf->lazy_load;
+
+  if (load == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&load->mutex);
+  load->stop = TRUE;
+  pthread_mutex_unlock(&load->mutex);
+  if (load->started) {
+    pthread_join(load->thread, NULL);
+  }
+  free_lazy_load(load);
+  return;
+}
+
+static LINE *read_whole_file(uchar *text, long size, LINE *curr, uchar *filename) {
+  uchar *end = text + size;
+  uchar *line_start = text;
+  uchar *eol = NULL;
+  long maxlen = 0;
+  long len = 0;
+  long lines_read = 0L;
+  int extra = 0;
+  LINE *temp = curr;
+  int num_threads = 0;
+
+  for (; end > text && *(end - 1) == DOSEOF; end--);
+  num_threads = min(load_threads, (end - text) / LOAD_THREAD_MINIMUM);
+  if (num_threads > 1) {
+    return (split_whole_file(text, end, curr, filename, num_threads));
+  }
+  while (line_start < end) {
+    eol = find_eol(line_start, end);
+    len = eol - line_start;
+    if (len > max_line_length) {
+      sprintf((char *) trec, "Line %ld exceeds max. width of %ld. File: %s", lines_read + 1, max_line_length, filename);
+      display_error(29, trec, FALSE);
+      CURRENT_FILE->first_line = CURRENT_FILE->last_line = lll_free(CURRENT_FILE->first_line);
+      return (NULL);
+    }
+    extra = 0;
+    if (eol < end) {
+      if (*eol == THE_CR && eol + 1 < end && *(eol + 1) == THE_LF) {
+        extra = 1;
+      }
+      if (lines_read == 0L) {
+        set_eolfirst(eol, end);
+      }
+    }
+    *eol = '\0';
+    if ((temp = add_stored_LINE(CURRENT_FILE, temp, line_start, len)) == NULL) {
+      CURRENT_FILE->first_line = CURRENT_FILE->last_line = lll_free(CURRENT_FILE->first_line);
+      return (NULL);
+    }
+    if (len > maxlen) {
+      maxlen = len;
+    }
+    lines_read++;
+    line_start = eol + 1 + extra;
+  }
+  CURRENT_FILE->max_line_length = maxlen;
+  CURRENT_FILE->number_lines += lines_read;
+  return (temp);
+}
+
 LINE *read_file(FILE *fp, LINE *curr, uchar *filename, long fromline, long numlines, bool called_from_get_command) {
   long i = 0L;
   long maxlen = 0;
@@ -394,7 +975,32 @@ LINE *read_file(FILE *fp, LINE *curr, uchar *filename, long fromline, long numli
   int extra = 0;
   long read_start = 0;
   long total_lines_read = 0L, actual_lines_read = 0L;
+  struct stat file_stat;
+  uchar *text = NULL;
+  long size = 0;
+  LAZY_LOAD *load = NULL;
 
+  /*
+   * When a whole regular file is being edited, read it in one go and split
+   * it into lines where it lies, rather than reading and copying each line.
+   */
+  if (!called_from_get_command && fromline == 1L && numlines == 0L && ftell(fp) == 0L) {
+    if (fstat(fileno(fp), &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+      size = (long) file_stat.st_size;
+      /*
+       * A very large file edited interactively is read in the background,
+       * so long as every line read is displayed.
+       */
+      if (size >= LAZY_LOAD_MINIMUM && !batch_only && !TABI_ONx && CURRENT_VIEW->display_low == 0) {
+        if ((load = new_lazy_load(fileno(fp), size, filename)) != NULL) {
+          return (start_lazy_load(load, curr));
+        }
+      }
+      if ((text = read_text(CURRENT_FILE, fileno(fp), &size)) != NULL) {
+        return (read_whole_file(text, size, curr, filename));
+      }
+    }
+  }
   temp = curr;
   /*
    * Reset the length of trec_len, as it may have been changed elsewhere.
@@ -478,7 +1084,7 @@ LINE *read_file(FILE *fp, LINE *curr, uchar *filename, long fromline, long numli
           if (total_line_length > maxlen) {
             maxlen = total_line_length;
           }
-          if ((temp = add_LINE(CURRENT_FILE->first_line, temp, trec + line_start, len, 0, FALSE)) == NULL) {
+          if ((temp = add_stored_LINE(CURRENT_FILE, temp, trec + line_start, len)) == NULL) {
             if (!called_from_get_command) {
               CURRENT_FILE->first_line = CURRENT_FILE->last_line = lll_free(CURRENT_FILE->first_line);
             }
@@ -508,7 +1114,7 @@ LINE *read_file(FILE *fp, LINE *curr, uchar *filename, long fromline, long numli
               return (NULL);
             }
           }
-          if ((temp = add_LINE(CURRENT_FILE->first_line, temp, trec + line_start, len, 0, FALSE)) == NULL) {
+          if ((temp = add_stored_LINE(CURRENT_FILE, temp, trec + line_start, len)) == NULL) {
             if (!called_from_get_command) {
               CURRENT_FILE->first_line = CURRENT_FILE->last_line = lll_free(CURRENT_FILE->first_line);
             }
@@ -555,7 +1161,7 @@ LINE *read_fixed_file(FILE *fp, LINE *curr, uchar *filename, long fromline, long
         break;
       }
       if (++total_lines_read >= fromline) {
-        if ((temp = add_LINE(CURRENT_FILE->first_line, temp, trec, chars_read, 0, FALSE)) == NULL) {
+        if ((temp = add_stored_LINE(CURRENT_FILE, temp, trec, chars_read)) == NULL) {
           CURRENT_FILE->first_line = CURRENT_FILE->last_line = lll_free(CURRENT_FILE->first_line);
           return (NULL);
         }
@@ -580,8 +1186,9 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
   long num_actual_lines = 0L;
   long my_num_file_lines = 0L;
   short direction = (in_lines < 0L ? DIRECTION_BACKWARD : DIRECTION_FORWARD);
+  uchar *temp_fname = NULL;
   LINE *curr = NULL;
-  FILE *fp = NULL;
+  SAVE_BUFFER *sb = NULL;
   long col = 0, newcol = 0;
   long off = 0L;
   uchar c = 0;
@@ -591,6 +1198,10 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
   uchar eol[2];
   int eol_len = 0;
   char buf[MAX_FILE_NAME + 1];
+  bool linked = FALSE;
+  bool in_place = (cf->backup == BACKUP_OFF || cf->backup == BACKUP_INPLACE);
+  mode_t mask = 0;
+  int fd = -1;
 
   /*
    * Do not attempt to autosave a pseudo file...
@@ -598,6 +1209,11 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
   if (cf->pseudo_file && (autosave || CURRENT_FILE->save_alt == 0) && blank_field(new_fname)) {
     return (RC_OK);
   }
+  /*
+   * The whole file is written, and may be written over where it is still
+   * being read, so wait for the rest of it to be read first.
+   */
+  complete_file_load(cf);
   switch (cf->eolout) {
     case EOLOUT_CRLF:
       eol[0] = (uchar) '\r';
@@ -742,6 +1358,13 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
           return (RC_ACCESS_DENIED);
         }
       }
+      /*
+       * A file that cannot be replaced without losing its other links or its
+       * ownership is overwritten in place, with its backup made as a copy.
+       */
+      if (!in_place && (stat((char *) write_fname, &stat_buf) != 0 || !file_replaceable(&stat_buf))) {
+        in_place = TRUE;
+      }
       /*
        * Rename the current file to filename[BACKUP_SUFFIXx].
        */
@@ -759,7 +1382,7 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
         new_filename(cf->fpath, cf->fname, bak_filename, BACKUP_SUFFIXx);
         if (cf->fp != NULL) {
           remove_file(bak_filename);
-          if (cf->backup == BACKUP_INPLACE) {
+          if (in_place) {
             /*
              * Copy the contents of the current file to the BACKUP_SUFFIXx file
              */
@@ -805,6 +1428,11 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
              * Restore any file attributes that can be restored to the backup file
              */
             process_file_attributes(1, cf, bak_filename);
+          } else if (!append && link((char *) write_fname, (char *) bak_filename) == 0) {
+            /*
+             * The file stays where it is until the new one replaces it.
+             */
+            linked = TRUE;
           } else {
             if (rename((char *) write_fname, (char *) bak_filename) != 0) {
               display_error(8, write_fname, FALSE);
@@ -821,16 +1449,56 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
       }
     }
   }
+  if ((sb = (SAVE_BUFFER *) malloc(sizeof(SAVE_BUFFER))) == NULL) {
+    display_error(30, (uchar *) "", FALSE);
+    if (bak_filename != (uchar *) NULL) {
+      free(bak_filename);
+    }
+    if (write_fname != (uchar *) NULL) {
+      free(write_fname);
+    }
+    return (RC_OUT_OF_MEMORY);
+  }
+  sb->iovcnt = 0;
+  sb->stage_start = sb->stage_used = 0;
   /*
    * Open the file we are writing to...
+   * When the file being edited is saved with BACKUP KEEP or TEMP, other than
+   * in place, it is written to a temporary file in the same directory which
+   * is then flushed to disk and replaces it, so that the file is never seen
+   * partly written.
    */
   if (append == TRUE) {
-    fp = fopen((char *) write_fname, "ab");
-  } else {
-    fp = fopen((char *) write_fname, "wb");
+    fd = open((char *) write_fname, O_WRONLY | O_CREAT | O_APPEND, 0666);
+  } else if (same_file && !in_place) {
+    if ((temp_fname = (uchar *) malloc(strlen((char *) write_fname) + 8)) != NULL) {
+      strcpy((char *) temp_fname, (char *) write_fname);
+      strcat((char *) temp_fname, ".XXXXXX");
+      if ((fd = mkstemp((char *) temp_fname)) != (-1)) {
+        mask = umask(0);
+        umask(mask);
+        fchmod(fd, 0666 & ~mask);
+      } else {
+        free(temp_fname);
+        temp_fname = NULL;
+      }
+    }
   }
-  if (fp == NULL) {
+  /*
+   * ...otherwise, or if no temporary file can be created, it is overwritten.
+   */
+  if (fd == (-1) && append == FALSE) {
+    fd = open((char *) write_fname, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  }
+  if (fd == (-1)) {
     display_error(8, (uchar *) "could not open for writing", FALSE);
+    if (linked) {
+      remove_file(bak_filename);
+    }
+    if (temp_fname != (uchar *) NULL) {
+      free(temp_fname);
+    }
+    free(sb);
     if (bak_filename != (uchar *) NULL) {
       free(bak_filename);
     }
@@ -839,6 +1507,7 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
     }
     return (RC_ACCESS_DENIED);
   }
+  sb->fd = fd;
   /*
    * Determine where to start writing from in the linked list.
    */
@@ -884,21 +1553,21 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
             while ((c = next_char(curr, &off, end_col + 1)) == ' ') {
               newcol++;
               if ((newcol % cf->tabsout_num) == 0) {
-                if ((rc = write_char((uchar) '\t', fp)) == RC_DISK_FULL) {
+                if ((rc = write_char((uchar) '\t', sb)) == RC_DISK_FULL) {
                   break;
                 }
                 col = newcol;
               }
             }
             for (; col < newcol; col++) {
-              if ((rc = write_char((uchar) ' ', fp)) == RC_DISK_FULL) {
+              if ((rc = write_char((uchar) ' ', sb)) == RC_DISK_FULL) {
                 break;
               }
             }
             if (off == (-1L)) { /* end of line */
               break;
             }
-            if ((rc = write_char((uchar) c, fp)) == RC_DISK_FULL) {
+            if ((rc = write_char((uchar) c, sb)) == RC_DISK_FULL) {
               break;
             }
             col++;
@@ -908,7 +1577,7 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
           }
         } else {
           if (start_col < curr->length) {
-            if ((rc = write_line(curr->line + start_col, min(curr->length - start_col, (end_col - start_col) + 1), fp, CURRENT_FILE->trailing)) == RC_DISK_FULL) {
+            if ((rc = write_line(curr->line + start_col, min(curr->length - start_col, (end_col - start_col) + 1), sb, CURRENT_FILE->trailing)) == RC_DISK_FULL) {
               break;
             }
           } else {
@@ -916,7 +1585,7 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
              * No characters to write, but we need to call this
              * so we can handle trailing blanks for TRAILING_EMPTY setting properly
              */
-            if ((rc = write_line((uchar *) "", 0, fp, CURRENT_FILE->trailing)) == RC_DISK_FULL) {
+            if ((rc = write_line((uchar *) "", 0, sb, CURRENT_FILE->trailing)) == RC_DISK_FULL) {
               break;
             }
           }
@@ -924,7 +1593,7 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
         if (rc) {
           break;
         }
-        if ((rc = write_line(eol, eol_len, fp, TRAILING_ON)) == RC_DISK_FULL) {
+        if ((rc = write_line(eol, eol_len, sb, TRAILING_ON)) == RC_DISK_FULL) {
           break;
         }
         num_actual_lines++;
@@ -956,21 +1625,38 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
     CURRENT_VIEW->scope_all = save_scope_all;
   }
 
-  if (fflush(fp) == EOF) {
+  if (rc == RC_OK) {
+    rc = flush_bytes(sb);
+  }
+  if (rc == RC_OK && temp_fname != (uchar *) NULL && fsync(fd) != 0) {
+    display_error(57, (uchar *) "", FALSE);
     rc = RC_DISK_FULL;
-    rewind(fp);
   }
-  if (fclose(fp) == EOF) {
+  if (close(fd) != 0 && rc == RC_OK) {
+    display_error(57, (uchar *) "", FALSE);
     rc = RC_DISK_FULL;
   }
+  free(sb);
+  if (rc == RC_OK && temp_fname != (uchar *) NULL) {
+    if (rename((char *) temp_fname, (char *) write_fname) != 0) {
+      display_error(8, write_fname, FALSE);
+      rc = RC_ACCESS_DENIED;
+    }
+  }
   /*
    * If an error occurred in writing the file (usuallly a result of a disk full error),
    * get the files back to the way they were before this attempt to write them.
    */
   if (rc) {
     /* remove 'new' file (the one that couldn't be written) */
-    remove_file(write_fname);
-    if (same_file) {
+    if (temp_fname != (uchar *) NULL) {
+      remove_file(temp_fname);
+    } else {
+      remove_file(write_fname);
+    }
+    if (linked) {
+      remove_file(bak_filename);
+    } else if (same_file) {
       if (rename((char *) bak_filename, (char *) write_fname) != 0) {
         display_error(8, write_fname, FALSE);
         if (bak_filename != (uchar *) NULL) {
@@ -984,7 +1670,7 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
     }
   } else {
     if (same_file) {
-      if (cf->backup != BACKUP_INPLACE) {
+      if (!in_place) {
         if (cf->fmode != 0) {
           chmod((char *) write_fname, cf->fmode);
         }
@@ -1012,6 +1698,9 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
      * If a new filename was not supplied, free up temporary memory.
      */
   }
+  if (temp_fname != (uchar *) NULL) {
+    free(temp_fname);
+  }
   if (bak_filename != (uchar *) NULL) {
     free(bak_filename);
   }
@@ -1021,16 +1710,77 @@ short save_file(FILE_DETAILS *cf, uchar *new_fname, bool force, long in_lines, l
   return (rc);
 }
 
-static short write_char(uchar chr, FILE *fp) {
-  if (fputc(chr, fp) == chr && ferror(fp) == 0) {
+static short flush_bytes(SAVE_BUFFER *sb) {
+  struct iovec *iov = sb->iov;
+  ssize_t written = 0;
+
+  if (sb->stage_used > sb->stage_start) {
+    sb->iov[sb->iovcnt].iov_base = sb->stage + sb->stage_start;
+    sb->iov[sb->iovcnt].iov_len = sb->stage_used - sb->stage_start;
+    sb->iovcnt++;
+  }
+  /*
+   * Write all the gathered pieces, carrying on after a partial write.
+   */
+  while (sb->iovcnt > 0) {
+    if ((written = writev(sb->fd, iov, sb->iovcnt)) == (-1)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      display_error(57, (uchar *) "", FALSE);
+      return (RC_DISK_FULL);
+    }
+    for (; sb->iovcnt > 0 && written >= (ssize_t) iov->iov_len; iov++, sb->iovcnt--) {
+      written -= iov->iov_len;
+    }
+    if (sb->iovcnt > 0) {
+      iov->iov_base = (uchar *) iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+  sb->stage_start = sb->stage_used = 0;
+  return (RC_OK);
+}
+
+static short write_bytes(uchar *bytes, long len, SAVE_BUFFER *sb) {
+  short rc = RC_OK;
+
+  if (len == 0) {
+    return (RC_OK);
+  }
+  /*
+   * Short pieces are copied together; longer pieces are written from where
+   * they lie, so must not change until they have been flushed.
+   */
+  if (len < SAVE_DIRECT_MINIMUM) {
+    if (sb->stage_used + len > SAVE_STAGE_SIZE && (rc = flush_bytes(sb)) != RC_OK) {
+      return (rc);
+    }
+    memcpy(sb->stage + sb->stage_used, bytes, len);
+    sb->stage_used += len;
     return (RC_OK);
   }
-  clearerr(fp);
-  display_error(57, (uchar *) "", FALSE);
-  return (RC_DISK_FULL);
+  if (sb->iovcnt + 2 >= SAVE_IOV_MAX && (rc = flush_bytes(sb)) != RC_OK) {
+    return (rc);
+  }
+  if (sb->stage_used > sb->stage_start) {
+    sb->iov[sb->iovcnt].iov_base = sb->stage + sb->stage_start;
+    sb->iov[sb->iovcnt].iov_len = sb->stage_used - sb->stage_start;
+    sb->iovcnt++;
+    sb->stage_start = sb->stage_used;
+  }
+  sb->iov[sb->iovcnt].iov_base = bytes;
+  sb->iov[sb->iovcnt].iov_len = len;
+  sb->iovcnt++;
+  return (RC_OK);
+}
+
+static short write_char(uchar chr, SAVE_BUFFER *sb) {
+  return (write_bytes(&chr, 1, sb));
 }
 
-static short write_line(uchar *line, long len, FILE *fp, short trailing) {
+static short write_line(uchar *line, long len, SAVE_BUFFER *sb, short trailing) {
+
   short rc = RC_OK;
   long newlen = len;
 
@@ -1049,18 +1799,17 @@ static short write_line(uchar *line, long len, FILE *fp, short trailing) {
   if (trailing != TRAILING_ON) {
     newlen = 1 + (long) memrevne(line, ' ', len);
   }
-  if (fwrite(line, sizeof(uchar), newlen, fp) != newlen) {
-    display_error(57, (uchar *) "", FALSE);
-    rc = RC_DISK_FULL;
+  if ((rc = write_bytes(line, newlen, sb)) != RC_OK) {
+    return (rc);
   }
   switch (trailing) {
     case TRAILING_EMPTY:
       if (newlen == 0) {
-        rc = write_char((uchar) ' ', fp);
+        rc = write_char((uchar) ' ', sb);
       }
       break;
     case TRAILING_SINGLE:
-      rc = write_char((uchar) ' ', fp);
+      rc = write_char((uchar) ' ', sb);
       break;
     default:
       break;
@@ -1069,6 +1818,7 @@ static short write_line(uchar *line, long len, FILE *fp, short trailing) {
 }
 
 void increment_alt(FILE_DETAILS *cf) {
+  journal_alteration(cf);
   cf->autosave_alt++;
   cf->save_alt++;
   /*
@@ -1330,6 +2080,10 @@ void free_a_view(void) {
 }
 
 short free_file_memory(bool free_file_lines) {
+  /*
+   * If the file is still being read in the background, stop...
+   */
+  stop_file_load(CURRENT_FILE);
   /*
    * If the file name is not NULL, free it...
    */
@@ -1391,6 +2145,7 @@ short free_file_memory(bool free_file_lines) {
    */
   if (free_file_lines) {
     CURRENT_FILE->first_line = CURRENT_FILE->last_line = lll_free(CURRENT_FILE->first_line);
+    free_text_blocks(CURRENT_FILE);
     switch (CURRENT_FILE->pseudo_file) {
       case PSEUDO_DIR:
         dir_first_line = dir_last_line = NULL;
@@ -1406,6 +2161,11 @@ short free_file_memory(bool free_file_lines) {
         break;
     }
   }
+  /*
+   * Free the journals of edits...
+   */
+  journal_discard(CURRENT_FILE);
+  free_comment_states(CURRENT_FILE);
   /*
    * Free the linked list of all pending prefix commands...
    */
@@ -18,6 +18,7 @@
 #define maxexp 999999999        // maximum exponent of a number (must fit into int)
 #define maxdigits 10000         // maximum allowable setting for NUMERIC DIGITS
 #define maxtracelen 500         // maximum length of a line of trace
+#define maxprogcache 16         // maximum number of tokenised programs kept
 #define traceindent 1           // Spaces per indentation level in traceback
 #define STDIN 0                 // = fileno(stdin)
 
@@ -362,6 +363,7 @@ typedef struct _varent {        // a variable table entry
   int less;                     // position of left child within tree
   int grtr;                     // position of right child within tree
   int namelen;                  // length of variable's name
+  unsigned hash;                // varhash() of variable's name
   int valalloc;                 // length allocated to variable's value
   int vallen;                   // actual length of variable's value
 } varent;
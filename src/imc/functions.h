@@ -93,6 +93,9 @@ char *tailsearch(char*, char*, int, int*);                   // Search for a tai
 char *valuesearch(char*, int, int*, int*, char**);           // Search for any variable
 void printtree(int);                                         // Print the entire variable table
 void update(int value, int, int);                            // Update the pointers for a variable level
+char *varvalue(varent*);                                     // Get the value held out of line for a variable
+void varassign(varent*, char*, int);                         // Assign a value held out of line to a variable
+void varfree(int);                                           // Free the values of the top variable levels
 void varcreate(char*, char*, char*, int, int, int);          // Create a simple symbol
 void stemcreate(char*, char*, char*, int, int, int);         // Create a stem
 void tailcreate(char*, char*, char*, char*, int, int, int);  // Create a tail in a stem
@@ -17,6 +17,7 @@ int lines;                      // number of lines in current source
 int stmts;                      // number of statements in current program
 char **source = 0;              // the source of the current program
 program *prog = 0;              // the current program, tokenised
+unsigned eprogline;             // length of the tokenised program text
 
 char *labelptr = cnull;         // start of label table
 int *varstk = inull;            // offsets to levels in variable table
@@ -14,6 +14,7 @@ extern int lines;               // number of lines in current source
 extern int stmts;               // number of statements in current program
 extern char **source;           // the source of the current program
 extern program *prog;           // the current program, tokenised
+extern unsigned eprogline;      // length of the tokenised program text
 
 extern char *labelptr;          // start of label table
 extern char *vartab;            // start of variable table
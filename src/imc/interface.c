@@ -68,6 +68,31 @@ static struct exitentry {
 static int exitlen = 0;
 static int exits = 0;
 
+/*
+ * Tokenised programs kept between calls of RexxStart, most recently used first.
+ * A program is found again by its file name, and is only reused while the file
+ * still holds exactly the source it was tokenised from.
+ */
+
+static struct progcache {
+  struct progcache *next;
+  char *name;                   // the file name found by which()
+  int line1;                    // whether the first line was skipped
+  char *loaded;                 // the source as loaded, before tokenising
+  char *input;                  // the source characters
+  int ilen;                     // and their length
+  program *prog;                // the statement table
+  int stmts;
+  char *text;                   // the tokenised program text
+  unsigned textlen;
+  char **source;                // the source line table
+  int lines;
+  char *labels;                 // the label table
+  unsigned lablen;
+} *progcache = 0;
+static int progcaches = 0;
+static char *progloaded = 0;    // the source being tokenised, as loaded
+
 char version[80];               // REXX version string
 char *psource;                  // the string parsed by PARSE SOURCE
 
@@ -75,6 +100,119 @@ char *psource;                  // the string parsed by PARSE SOURCE
 
 static int rexxdepth = 0;       // nesting level of RexxStart()
 
+/* Copy a tokenised program, pointing the copy's tables into the copy's own text */
+static void progdup(struct progcache *from, struct progcache *to) {
+  int i;
+
+  to->input = allocm(from->ilen + 1);
+  memcpy(to->input, from->input, from->ilen + 1);
+  to->ilen = from->ilen;
+  to->text = allocm(from->textlen);
+  memcpy(to->text, from->text, from->textlen);
+  to->textlen = from->textlen;
+  to->prog = (program *) allocm((from->stmts + 1) * sizeof(program));
+  memcpy(to->prog, from->prog, (from->stmts + 1) * sizeof(program));
+  for (i = 0; i <= from->stmts; i++) {
+    if (from->prog[i].source) {
+      to->prog[i].source = to->input + (from->prog[i].source - from->input);
+    }
+    if (from->prog[i].sourcend) {
+      to->prog[i].sourcend = to->input + (from->prog[i].sourcend - from->input);
+    }
+    to->prog[i].line = to->text + (from->prog[i].line - from->text);
+  }
+  to->stmts = from->stmts;
+  to->source = (char **) allocm((from->lines + 2) * sizeof(char *));
+  to->source[0] = cnull;
+  for (i = 1; i < from->lines + 2; i++) {
+    to->source[i] = to->input + (from->source[i] - from->input);
+  }
+  to->lines = from->lines;
+  to->labels = allocm(from->lablen);
+  memcpy(to->labels, from->labels, from->lablen);
+  to->lablen = from->lablen;
+}
+
+static void progfree(struct progcache *entry) {
+  free(entry->name);
+  free(entry->loaded);
+  free(entry->input);
+  free(entry->text);
+  free((char *) entry->prog);
+  free((char *) entry->source);
+  free(entry->labels);
+  free((char *) entry);
+}
+
+/*
+ * Load the program kept for the named file into the current program, given
+ * the source just loaded from the file.
+ * The return value is zero if there is none, or if the file has changed since.
+ */
+static int progfetch(char *name, int line1, char *input, int ilen) {
+  struct progcache **pp;
+  struct progcache *entry;
+  struct progcache current;
+
+  for (pp = &progcache; (entry = *pp) && strcmp(entry->name, name); pp = &entry->next) {
+    // search for the file name
+  }
+  if (!entry) {
+    return 0;
+  }
+  *pp = entry->next;
+  if (entry->line1 != line1 || entry->ilen != ilen || memcmp(entry->loaded, input, ilen)) {
+    progfree(entry), progcaches--;  // out of date
+    return 0;
+  }
+  entry->next = progcache, progcache = entry;
+  progdup(entry, &current);
+  prog = current.prog;
+  stmts = current.stmts;
+  source = current.source;
+  lines = current.lines;
+  labelptr = current.labels;
+  eprogline = current.textlen;
+  return 1;
+}
+
+/* Keep a copy of the program just tokenised from the named file, with the source in progloaded */
+static void progstore(char *name, int line1, int ilen) {
+  struct progcache **pp;
+  struct progcache *entry;
+  struct progcache current;
+  int l;
+  char *lptr;
+
+  if (progcaches >= maxprogcache) {  // forget the least recently used program
+    for (pp = &progcache; (*pp)->next; pp = &(*pp)->next) {
+      // find the last entry
+    }
+    progfree(*pp), *pp = 0, progcaches--;
+  }
+  for (lptr = labelptr; (l = *(int *) lptr); lptr += align(l + 1) + 2 * four) {
+    // find the end of the label table
+  }
+  current.input = source[1];
+  current.ilen = ilen;
+  current.prog = prog;
+  current.stmts = stmts;
+  current.text = prog[0].line;
+  current.textlen = eprogline;
+  current.source = source;
+  current.lines = lines;
+  current.labels = labelptr;
+  current.lablen = lptr - labelptr + four;
+  entry = (struct progcache *) allocm(sizeof(struct progcache));
+  progdup(&current, entry);
+  entry->name = allocm(strlen(name) + 1);
+  strcpy(entry->name, name);
+  entry->line1 = line1;
+  entry->loaded = progloaded, progloaded = 0;
+  entry->next = progcache, progcache = entry;
+  progcaches++;
+}
+
 /* Destroy the REXX data structures */
 static void rexxterm(struct status *old) {
   if (cstackptr) {
@@ -101,12 +239,13 @@ static void rexxterm(struct status *old) {
     free(labelptr), labelptr = 0;
   }
   if (rexxdepth == 0) {
-    if (varstk) {
-      free(varstk), varstk = 0;
-    }
     if (vartab) {
+      varfree(0);
       free(vartab), vartab = 0;
     }
+    if (varstk) {
+      free(varstk), varstk = 0;
+    }
     if (hashlen[2]) {
       hashfree();
       // This *shouldn't* close stdin, stdout or stderr,
@@ -148,6 +287,9 @@ static void rexxterm(struct status *old) {
     address0 = old->address0;
     address1 = old->address1;
     address2 = old->address2;
+    if (varstkptr > old->varlevel) {
+      varfree(old->varlevel + 1);  // levels pushed by this call
+    }
     varstkptr = old->varlevel;
     psource = old->psource;
     prog = old->prog;
@@ -195,6 +337,7 @@ long RexxStartProgram(char *argv0, long argc, PRXSTRING argv, char *name, char *
   char sourcestring[200];       // string for "parse source"
   char env[maxenviron + 1];     // a copy of the environment name
   struct status old;
+  int depth = rexxdepth;        // nesting level of this call
   int i, j;
   long n;
   // saved signal handlers
@@ -388,6 +531,7 @@ long RexxStartProgram(char *argv0, long argc, PRXSTRING argv, char *name, char *
     input = allocm(ilen = instore[0].strlength);
     memcpy(input, instore[0].strptr, ilen);
     strcpy(fname, name);
+    tokenise(input, ilen, 0, flags & RXOPTIONX);
   } else {
     // search for the file
     if (which(name, (flags & RXOPTIONX) || !(flags & RXMAIN), fname) != 1) {
@@ -396,8 +540,18 @@ long RexxStartProgram(char *argv0, long argc, PRXSTRING argv, char *name, char *
     if (!(input = load(fname, &ilen))) {
       errordata = fname, die(-3);  // error - could not load file
     }
+    if (progfetch(fname, flags & RXOPTIONX, input, ilen)) {
+      free(input);  // the kept program has its own copy
+    } else {
+      if (progloaded) {
+        free(progloaded);  // left by a program that failed to tokenise
+      }
+      progloaded = allocm(ilen);
+      memcpy(progloaded, input, ilen);  // tokenise() alters the source
+      tokenise(input, ilen, 0, flags & RXOPTIONX);
+      progstore(fname, flags & RXOPTIONX, ilen);
+    }
   }
-  tokenise(input, ilen, 0, flags & RXOPTIONX);
   source[0] = allocm(strlen(fname) + 1);
   strcpy(source[0], fname);
   // construct source string (one per invocation of RexxStart)
@@ -484,6 +638,7 @@ long RexxStartProgram(char *argv0, long argc, PRXSTRING argv, char *name, char *
   }
   i = 0;
 RexxEnd: // goto
+  rexxdepth = depth;  // not yet undone after an error in the program
   if (arglist) {
     free(arglist);
   }
@@ -954,7 +1109,7 @@ unsigned long RexxVariablePool(SHVBLOCK *request) {
               goto case_RXSHV_NEXTV;
             }
             vallen = thisvar->vallen;
-            valptr = (char *) (thisvar + 1) + align(thisvar->namelen);
+            valptr = varvalue(thisvar);
             nptr = workptr;
           } else {
             thisvar = nextvar;
@@ -990,7 +1145,7 @@ unsigned long RexxVariablePool(SHVBLOCK *request) {
             thisvar = (varent *) valuesearch(workptr, nlen, &lev, &i, &valptr);
           }
           workptr[0] &= 127;
-          valptr = (char *) (thisvar + 1) + align(thisvar->namelen);
+          valptr = varvalue(thisvar);
           vallen = thisvar->vallen;
           if (vallen < 0) {
             goto case_RXSHV_NEXTV;
@@ -2306,6 +2306,7 @@ int rxcall(int stmt, char *name, int argc, int lit, long calltype) {
   stmts = sptr->stmts;
   prog = (sptr->prg);
   if (type > 11) {  // reclaim procedural variables
+    varfree(varstkptr);
     varstkptr--;
   }
   curargs = oldcarg;
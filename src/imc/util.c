@@ -212,6 +212,8 @@ int exitcall(long fn, long sub, PEXIT parm) {
  * These routines maintain a multiple-level variable table, containing names and values of variables.
  * The names of simple symbols and stems are kept in a binary tree arrangement,
  *  in the format of a varent structure followed by a name (padded to a multiple of 4 bytes) and a value.
+ * The value of a simple symbol (or of a tail) is held out of line in a block of its own,
+ *  and only the address of that block follows the name; valalloc is then the size of the block.
  * Symbols which have been DROPped still exist, but have a value length of -1.
  * Symbols which are copies of variables in earlier levels have a negative "valalloc" value
  *  indicating the level number (starting at -1, which means level 0).
@@ -220,29 +222,43 @@ int exitcall(long fn, long sub, PEXIT parm) {
  *  (an allocated,length,value triple) followed by a binary tree of tails
  *  associated with values as in the main table
  * The binary tree structure should allow access in O(log n) time,
- *  except when the value pointers need to be updated (when lengthening or shortening a value).
- * However no fancy balancing tricks are used, so O(n) time is possible in the worst case.
- * A special order is imposed which should minimise the possibility of a very unbalanced tree.
- * In particular, assigning the letters a-i or the numbers 0-9 in order should produce an optimal depth tree
+ *  except when the value pointers need to be updated (when lengthening or shortening a stem).
+ * No balancing tricks are used; instead the tree is ordered on a hash of each name first
+ *  (kept in the varent, so that a search hashes only the name it wants),
+ *  so that its shape is that of a random tree whatever order the names arrive in.
+ * In particular, assigning line.1, line.2, ... in order produces a tree of logarithmic depth
  *  (whereas with the usual ordering a linear depth tree results).
  * The less and grtr fields contain offsets from the start of the level,
  *  and the next field contains the length of one variable entry.
- * When a variable is lengthened or shortened, its own next field is updated,
+ * When a stem is lengthened or shortened, its own next field is updated,
  *  and the less and grtr fields of all variables in the same level are updated.
  * All other pointers, except for the pointers to each level, remain the same.
  */
 
+/* the hash of a name of length len, on which the variable tree is ordered first */
+unsigned varhash(char *name, int len) {
+  unsigned h = 2166136261U;
+
+  while (len-- > 0) {
+    h = (h ^ (unsigned char) name++[0]) * 16777619U;
+  }
+  return h;
+}
+
 /*
- * the ordering - compare s1,len n1 with s2,len n2
+ * the ordering - compare s1,len n1 (whose hash is h1) with s2,len n2 (whose hash is h2)
  * return -ve (s1<s2), 0 (s1=s2) or +ve (s1>s2).
  */
-int less(char *s1, char *s2, int n1, int n2) {
+int less(char *s1, char *s2, int n1, int n2, unsigned h1, unsigned h2) {
   char x, y;
   int r;
 
   static char xlate[] =  // the translation table for ordering
     { 4, 7, 3, 11, 1, 5, 9, 13, 0, 2, 6, 8, 10, 12, 15, 14 };
 
+  if (h1 != h2) {
+    return h1 < h2 ? -1 : 1;  // order on hashes first (it keeps the tree shallow)
+  }
   if (n1 != n2) {
     return n1 - n2;  // order on lengths first (it's faster)
   }
@@ -273,6 +289,7 @@ int less(char *s1, char *s2, int n1, int n2) {
 char *varsearch(char *name, int len, int *level, int *exist) {
   char *data = varstk[*level] + vartab;
   char *ans = data;
+  unsigned h = varhash(name, len);
   int *slot;
   int c;
 
@@ -280,7 +297,7 @@ char *varsearch(char *name, int len, int *level, int *exist) {
   if (varstk[*level] == varstk[*level + 1]) {
     return cnull;
   }
-  while ((c = less(name, ans + sizeof(varent), len, ((varent *) ans)->namelen)) && (*(slot = &(((varent *) ans)->less) + (c > 0))) >= 0) {
+  while ((c = less(name, ans + sizeof(varent), len, ((varent *) ans)->namelen, h, ((varent *) ans)->hash)) && (*(slot = &(((varent *) ans)->less) + (c > 0))) >= 0) {
     ans = data + *slot;  // go down the tree
   }
   if (!c) {  // equality resulted from the compare
@@ -300,6 +317,7 @@ char *tailsearch(char *stem, char *name, int len, int *exist) {
   char *data = stem + sizeof(varent) + align(((varent *) stem)->namelen);
   char *tails = data + 2 * four + *(int *) data;  // start of tail information
   char *ans = tails;
+  unsigned h = varhash(name, len);
   int *slot;
   int c;
 
@@ -307,7 +325,7 @@ char *tailsearch(char *stem, char *name, int len, int *exist) {
   if (((varent *) stem)->vallen == tails - data) {
     return cnull;
   }
-  while ((c = less(name, ans + sizeof(varent), len, ((varent *) ans)->namelen)) && (*(slot = &(((varent *) ans)->less) + (c > 0))) >= 0) {
+  while ((c = less(name, ans + sizeof(varent), len, ((varent *) ans)->namelen, h, ((varent *) ans)->hash)) && (*(slot = &(((varent *) ans)->less) + (c > 0))) >= 0) {
     ans = tails + *slot;
   }
   if (c) {
@@ -434,6 +452,75 @@ void printtails(varent *stem) {
   }
 }
 
+/*
+ * Return the value of a simple symbol or tail entry.
+ * The address is copied out since the name only pads it to a multiple of 4 bytes.
+ */
+char *varvalue(varent *var) {
+  char *value;
+
+  memcpy(&value, (char *) (var + 1) + align(var->namelen), sizeof(char *));
+  return value;
+}
+
+/*
+ * Assign `value' of length `len' to a simple symbol or tail entry which is not exposed.
+ * The value's block grows by a quarter more than it needs,
+ *  and is freed if the variable is dropped.
+ */
+void varassign(varent *var, char *value, int len) {
+  char *old = varvalue(var);
+  char *new = old;
+  int ext;
+
+  if (len > var->valalloc || (len >= 0 && !old)) {  // need a bigger block
+    ext = len / 4;
+    if (ext < 20) {
+      ext = 20;
+    }
+    new = allocm(var->valalloc = align(len + ext));
+    if (len > 0) {
+      memcpy(new, value, len);
+    }
+    if (old) {
+      free(old);
+    }
+  } else if (len < 0 && var->valalloc > 10) {  // variable is being dropped - reclaim
+    free(old);
+    new = cnull;
+    var->valalloc = 0;
+  } else if (len > 0) {
+    memmove(new, value, len);
+  }
+  memcpy((char *) (var + 1) + align(var->namelen), &new, sizeof(char *));
+  var->vallen = len;
+}
+
+/* Free the values of all the variables in levels from `level' upwards, before discarding them */
+void varfree(int level) {
+  varent *var;
+  varent *tail;
+  char *data;
+  char *end;
+
+  for (var = (varent *) (vartab + varstk[level]); (char *) var < vartab + varstk[varstkptr + 1]; var = (varent *) ((char *) var + var->next)) {
+    if (var->valalloc <= 0) {
+      continue;  // exposed, or holds nothing
+    }
+    if (!(((char *) (var + 1))[0] & 128)) {
+      free(varvalue(var));
+      continue;
+    }
+    data = (char *) (var + 1) + align(var->namelen);
+    end = data + var->vallen;
+    for (tail = (varent *) (data + *(int *) data + 2 * four); (char *) tail < end; tail = (varent *) ((char *) tail + tail->next)) {
+      if (tail->valalloc > 0) {
+        free(varvalue(tail));
+      }
+    }
+  }
+}
+
 /*
  * Update all the less/grtr fields of level `level' by `amount'
  *  if greater than `value'; adjust the level pointers also.
@@ -467,7 +554,7 @@ long makeroom(int var, int amount, int level) {
   varent *k;
   long mtest_diff = 0;
 
-  dtest(vartab, vartablen, varstk[varstkptr + 1] + amount + 2, amount + 512, mtest_diff);
+  dtest(vartab, vartablen, varstk[varstkptr + 1] + amount + 2, amount + 512 + vartablen / 4, mtest_diff);
   k = ((varent *) (j = vartab + varstk[level] + var));  // the variable's address
   j += (k->next);  // the end of the variable
   for (i = vartab + varstk[varstkptr + 1] - 1; i >= j; i--) {
@@ -550,27 +637,6 @@ long tailroom(varent *stem, int var, int amount, int level) {
   return diff;
 }
 
-/*
- * Reduce the size of a tail element
- * var is a tail offset value
- */
-void tailreclaim(varent *stem, int var, int amount) {
-  register char *i;
-  register char *j;
-  varent *k;
-  char *data;
-
-  data = (char *) stem + sizeof(varent) + align(stem->namelen);
-  j = data + stem->vallen - amount;
-  data += *(int *) data + 2 * four;
-  k = (varent *) (data + var);
-  for (i = (char *) k + (k->next) - amount; i < j; i++) {
-    i[0] = i[amount];
-  }
-  k->next -= amount;
-  tailupdate(stem, var, -amount);
-}
-
 /*
  * hook up the tree structure within a stem
  * i.e. fill in the grtr & less fields in a list of tail elements
@@ -603,16 +669,16 @@ void tailhookup(varent *stem) {
  * If lev=1, place one level down.
  */
 void varcreate(char *varptr, char *name, char *value, int namelen, int len, int lev) {
-  int alloc = len / 4;
+  char *none = cnull;
+  long diff = 0;
   int ext;
   register char *i;
   register char *v;
 
-  if (alloc < 20) {
-    alloc = 20;  // the extra amount of space to allocate
+  dtest(vartab, vartablen, varstk[varstkptr + 1] + 1 + (ext = sizeof(varent) + align(namelen) + sizeof(char *)), namelen + 256 + vartablen / 4, diff);
+  if (varptr) {
+    varptr += diff;  // a null slot means the level was empty
   }
-  alloc += len, alloc = align(alloc);   // the total amount of space to allocate
-  dtest(vartab, vartablen, varstk[varstkptr + 1] + 1 + (ext = align(alloc + namelen + sizeof(varent))), namelen + alloc + 256, varptr);
   v = vartab + varstk[varstkptr + !lev];  // where to put the new variable
   if (lev) {  // move up the entire top level to make room
     for (i = vartab + varstk[varstkptr + 1]; i >= v; i--) {
@@ -624,14 +690,13 @@ void varcreate(char *varptr, char *name, char *value, int namelen, int len, int
   ((varent *) v)->less = -1;
   ((varent *) v)->grtr = -1;
   ((varent *) v)->namelen = namelen;
-  ((varent *) v)->valalloc = alloc;
-  ((varent *) v)->vallen = len;
+  ((varent *) v)->hash = varhash(name, namelen);
+  ((varent *) v)->valalloc = 0;
+  memcpy(v + sizeof(varent) + align(namelen), &none, sizeof(char *));
   if (varptr) {  // make the new variable a part of the tree
     *(int *) varptr = varstk[varstkptr + !lev] - varstk[varstkptr - lev];
   }
-  if (len > 0) {  // copy the new variable's value
-    memcpy(v + sizeof(varent) + align(namelen), value, len);
-  }
+  varassign((varent *) v, value, len);  // give the new variable its value
   varstk[varstkptr + 1] += ext; // and finally update the level pointers
   if (lev) {
     varstk[varstkptr] += ext;
@@ -645,10 +710,14 @@ void varcreate(char *varptr, char *name, char *value, int namelen, int len, int
  */
 void stemcreate(char *varptr, char *name, char *value, int namelen, int len, int lev) {
   int alloc = align(len * 5 / 4 + 256);
+  long diff = 0;
   int ext;
   register char *i, *v;
 
-  dtest(vartab, vartablen, varstk[varstkptr + 1] + 1 + (ext = align(alloc + namelen + sizeof(varent) + 2 * four)), namelen + alloc + 256, varptr);
+  dtest(vartab, vartablen, varstk[varstkptr + 1] + 1 + (ext = align(alloc + namelen + sizeof(varent) + 2 * four)), namelen + alloc + 256, diff);
+  if (varptr) {
+    varptr += diff;
+  }
   v = vartab + varstk[varstkptr + !lev];
   if (lev) {
     for (i = vartab + varstk[varstkptr + 1]; i >= v; i--) {
@@ -663,6 +732,7 @@ void stemcreate(char *varptr, char *name, char *value, int namelen, int len, int
   ((varent *) v)->less = -1;
   ((varent *) v)->grtr = -1;
   ((varent *) v)->namelen = namelen;
+  ((varent *) v)->hash = varhash(name, namelen);
   ((varent *) v)->valalloc = alloc;
   ((varent *) v)->vallen = (alloc = align(len)) + 2 * four;
   v += sizeof(varent) + align(namelen);
@@ -685,30 +755,24 @@ void stemcreate(char *varptr, char *name, char *value, int namelen, int len, int
  */
 void tailcreate(char *stem, char *tailptr, char *name, char *value, int namelen, int len, int level) {
   long diff;
-  int alloc = len / 4;
   int ext;
+  int grow;
+  char *none = cnull;
   char *v = stem + sizeof(varent) + align(((varent *) stem)->namelen);
   char *e = v + ((varent *) stem)->vallen;   // end of last tail
 
   v += *(int *) v + 2 * four;   // start of first tail
-  if (len < 0) {
-    alloc = 0;
-  } else {
-    if (alloc < 20) {
-      alloc = 20;
-    }
-    alloc = align(alloc + len);
-  }
-  if ((ext = alloc + align(namelen) + sizeof(varent)) + ((varent *) stem)->vallen > ((varent *) stem)->valalloc) {
-    if ((diff = makeroom(stem - vartab - varstk[level], ext + 256, level))) {
+  if ((ext = sizeof(varent) + align(namelen) + sizeof(char *)) + ((varent *) stem)->vallen > ((varent *) stem)->valalloc) {
+    grow = align(ext + 256 + ((varent *) stem)->vallen / 4);  // the stem grows by a quarter each time
+    if ((diff = makeroom(stem - vartab - varstk[level], grow, level))) {
       if (tailptr) {
         tailptr += diff;
       }
       stem += diff;
       e += diff;
-      v += diff;;
+      v += diff;
     }
-    ((varent *) stem)->valalloc += ext + 256;
+    ((varent *) stem)->valalloc += grow;
   }
   if (tailptr) {
     *(int *) (tailptr) = e - v;  // save the offset in the parent's slot
@@ -718,11 +782,10 @@ void tailcreate(char *stem, char *tailptr, char *name, char *value, int namelen,
   ((varent *) e)->less = -1;
   ((varent *) e)->grtr = -1;
   ((varent *) e)->namelen = namelen;
-  ((varent *) e)->valalloc = alloc;
-  ((varent *) e)->vallen = len;
-  if (len > 0) {
-    memcpy(e + sizeof(varent) + align(namelen), value, len);
-  }
+  ((varent *) e)->hash = varhash(name, namelen);
+  ((varent *) e)->valalloc = 0;
+  memcpy(e + sizeof(varent) + align(namelen), &none, sizeof(char *));
+  varassign((varent *) e, value, len);
   ((varent *) stem)->vallen += ext;
 }
 
@@ -731,7 +794,7 @@ void tailcreate(char *stem, char *tailptr, char *name, char *value, int namelen,
  *  equal to the value `value' which has length `len'
  */
 void varset(char *name, int varlen, char *value, int len) {
-  int varalloc, varoff, ext, newlen, exist;
+  int ext, exist;
   register char *i;
   register varent *v1, *v2;
   int level = varstkptr;
@@ -770,6 +833,8 @@ void varset(char *name, int varlen, char *value, int len) {
           v1->grtr = -1;
           v1->less = -1;
           v1 = (varent *) ((char *) v1 + v1->next);
+        } else if (v2->valalloc > 0) {  // it is cleared
+          free(varvalue(v2));
         }
         v2 = (varent *) ((char *) v2 + v2->next);
       }
@@ -802,27 +867,7 @@ void varset(char *name, int varlen, char *value, int len) {
   if (compound) {  // a compound symbol is being assigned to
     varptr = valuesearch(name, varlen, &level, &exist, &stemptr);
     if (exist) {  // change an existing compound variable
-      valptr = stemptr + sizeof(varent) + align(((varent *) stemptr)->namelen);
-      valptr += *(int *) valptr + 2 * four;
-      varoff = varptr - valptr; // now varoff contains the offset within stem
-      varalloc = ((varent *) varptr)->valalloc;
-      if (len > varalloc) {  // need some more memory
-        ext = len / 4;
-        if (ext < 20) {
-          ext = 20;
-        }
-        newlen = align(len + ext);  // the total amount of memory
-        ext = newlen - varalloc;  // the extra amount
-        varptr += tailroom((varent *) stemptr, varoff, ext, level);
-        ((varent *) varptr)->valalloc = newlen;
-      } else if (len < 0 && varalloc > 10) {  // variable is being dropped - reclaim
-        tailreclaim((varent *) stemptr, varoff, varalloc);
-        ((varent *) varptr)->valalloc = 0;
-      }
-      if (len > 0) {  // copy the value
-        memcpy(varptr + sizeof(varent) + align(((varent *) varptr)->namelen), value, len);
-      }
-      ((varent *) varptr)->vallen = len;  // and copy the length
+      varassign((varent *) varptr, value, len);
       return;
     }
     if (!stemptr) {  // the stem does not exist. Create then continue
@@ -845,25 +890,7 @@ void varset(char *name, int varlen, char *value, int len) {
   // so now it is a simple symbol.
   varptr = varsearch(name, varlen, &level, &exist);
   if (exist) {  // variable exists, so reset
-    varoff = varptr - vartab - varstk[level];
-    varalloc = ((varent *) varptr)->valalloc;
-    if (len > varalloc) {
-      ext = len / 4;
-      if (ext < 20) {
-        ext = 20;
-      }
-      newlen = align(len + ext);
-      ext = newlen - varalloc;
-      varptr += makeroom(varoff, ext, level);
-      ((varent *) varptr)->valalloc = newlen;
-    } else if (len < 0 && varalloc > 10) {  // variable is being dropped - reclaim
-      reclaim(varoff, varalloc, level);
-      ((varent *) varptr)->valalloc = 0;
-    }
-    if (len > 0) {
-      memcpy(varptr + sizeof(varent) + align(((varent *) varptr)->namelen), value, len);
-    }
-    ((varent *) varptr)->vallen = len;
+    varassign((varent *) varptr, value, len);
   } else if (len >= 0) {  // variable does not exist, so create
     varcreate(varptr, name, value, varlen, len, 0);
   }
@@ -895,7 +922,7 @@ char *varget(char *name, int varlen, int *len) {
     }
   }
   if ((*len = ((varent *) varptr)->vallen) >= 0) {  // exists
-    return varptr + align(((varent *) varptr)->namelen) + sizeof(varent);
+    return varvalue((varent *) varptr);
   } else {
     *len = 0;
     return cnull;
@@ -955,8 +982,8 @@ void varcopy(char *name, int varlen) {
         oldptr = name;
         name = 1 + strchr(name, '.');
         varlen -= name - oldptr;
-        ext = sizeof(varent) + align(varlen);
-        oldptr = vartab;
+        ext = sizeof(varent) + align(varlen) + sizeof(char *);
+        oldptr = cnull;
         if (((varent *) stemptr)->valalloc < ((varent *) stemptr)->vallen + ext) {
           if ((mtest_diff = makeroom(stemptr - vartab - varstk[varstkptr], ext + 256, varstkptr))) {
             if (varptr) {
@@ -975,10 +1002,12 @@ void varcopy(char *name, int varlen) {
           *(int *) varptr = endvar - i;
         }
         memcpy(endvar + sizeof(varent), name, varlen);
+        memcpy(endvar + sizeof(varent) + align(varlen), &oldptr, sizeof(char *));
         ((varent *) endvar)->next = ext;
         ((varent *) endvar)->less = -1;
         ((varent *) endvar)->grtr = -1;
         ((varent *) endvar)->namelen = varlen;
+        ((varent *) endvar)->hash = varhash(name, varlen);
         ((varent *) endvar)->valalloc = -(level + 1);
         ((varent *) endvar)->vallen = 0;
       }
@@ -997,11 +1026,16 @@ void varcopy(char *name, int varlen) {
   ext = varstkptr;
   varptr = varsearch(name, varlen, &ext, &l);
   if (!l) {  // not already exposed, so go ahead
-    dtest(vartab, vartablen, varstk[varstkptr + 1] + 1 + (ext = sizeof(varent) + align(varlen)), varlen + 256, varptr);
+    mtest_diff = 0;
+    dtest(vartab, vartablen, varstk[varstkptr + 1] + 1 + (ext = sizeof(varent) + align(varlen) + (isstem ? 0 : sizeof(char *))), varlen + 256, mtest_diff);
+    if (varptr) {
+      varptr += mtest_diff;
+    }
     ((varent *) (i = vartab + varstk[varstkptr + 1]))->less = -1;
     ((varent *) i)->grtr = -1;
     ((varent *) i)->next = ext;
     ((varent *) i)->namelen = varlen;
+    ((varent *) i)->hash = varhash(name, varlen);
     ((varent *) i)->valalloc = -(level + 1);
     ((varent *) i)->vallen = 0;
     if (varptr) {
@@ -1009,6 +1043,10 @@ void varcopy(char *name, int varlen) {
     }
     varstk[varstkptr + 1] += ext;
     memcpy(i + sizeof(varent), name, varlen);
+    if (!isstem) {
+      oldptr = cnull;
+      memcpy(i + sizeof(varent) + align(varlen), &oldptr, sizeof(char *));
+    }
   }
 }
 
@@ -1017,6 +1055,7 @@ void vardup() {
   int ext = varstk[varstkptr] - varstk[varstkptr - 1];
   int exist;
   int *slot;
+  char *none = cnull;
   register char *i, *j, *k;
 
   // test for memory. The new level requires no more memory than the previous one
@@ -1026,6 +1065,10 @@ void vardup() {
   j = k = vartab + varstk[varstkptr];
   while (i < j) {
     memcpy(k, i, ext = sizeof(varent) + align(((varent *) i)->namelen));
+    if (!(k[sizeof(varent)] & 128)) {  // a simple symbol holds no value of its own yet
+      memcpy(k + ext, &none, sizeof(char *));
+      ext += sizeof(char *);
+    }
     if (((varent *) k)->valalloc >= 0) {
       ((varent *) k)->valalloc = -varstkptr;
     }
@@ -1060,14 +1103,18 @@ void vardel(char *name, int len) {
   int *slot;
   int c;
   char *ans = vartab + varstk[varstkptr];
+  unsigned h = varhash(name, len);
 
   if (compound && !isstem) {
     die(Ebadexpr);
   }
-  while ((c = less(name, ans + sizeof(varent), len, ((varent *) ans)->namelen)) && (*(slot = (int *) ans + 1 + (c > 0))) >= 0) {
+  while ((c = less(name, ans + sizeof(varent), len, ((varent *) ans)->namelen, h, ((varent *) ans)->hash)) && (*(slot = (int *) ans + 1 + (c > 0))) >= 0) {
     ans = vartab + varstk[varstkptr] + *slot;
   }
   if (!c) {
+    if (!isstem && ((varent *) ans)->valalloc > 0) {
+      varassign((varent *) ans, cnull, -1);  // free its value
+    }
     ((varent *) ans)->valalloc = 0;
     if (isstem) {
       ans += tailroom((varent *) ans, -1, 2 * four, varstkptr);
@@ -1171,6 +1218,7 @@ void freestack(void *ptr, int i) {
     stmts = ((struct errorstack *) sptr)->stmts;
   }
   if (i == 12) {  // reclaim procedural variables
+    varfree(varstkptr);
     varstkptr--;
   }
   if (i >= 11 && i <= 14 && sgstack[interplev + 1].data) {  // reclaim condition data
@@ -1901,6 +1949,7 @@ void tokenise(char *input, int ilen, int interpret, int line1) {
   if (!interpret) {
     lines--;  // discount the new line started at the last '\n'; it will remain in the line table, however.
   }
+  eprogline = prgptr - prog[0].line;
   // now shrink all areas to their correct sizes
   if ((ptr = realloc((char *) prog, (1 + stmts) * sizeof(program)))) {
     prog = (program *) ptr;
@@ -1910,7 +1959,7 @@ void tokenise(char *input, int ilen, int interpret, int line1) {
   }
   if ((ptr = realloc(prog[0].line, prgptr - prog[0].line))) {
     if (ptr != prog[0].line) {
-      for (i = stmts; i--; prog[i].line += ptr - prog[0].line) {
+      for (i = stmts + 1; i--; prog[i].line += ptr - prog[0].line) {
         // Oops, the program moved!
       }
     }
@@ -0,0 +1,696 @@
+// SPDX-FileCopyrightText: 2013 Mark Hessling <mark@rexx.org>
+// SPDX-License-Identifier: GPL-2.0
+// SPDX-FileContributor: 2022 Ben Ravago
+
+#include "the.h"
+#include "proto.h"
+
+/*
+ * The journal of each file records the edits made to it, one entry for
+ * each line changed, inserted or deleted, as the change that undoes it.
+ * Lines moved among themselves (by SORT) are recorded together, as the
+ * line numbers they occupy and the order to put them back in.
+ * A changed line keeps only the bytes that differ, and all bytes kept are
+ * appended to one buffer, so that an edit costs the bytes it changed.
+ * Entries made by the same command share a sequence number, and UNDO and
+ * REDO take back the edits of a whole command at once, each recording in
+ * the other journal the change that takes them back again.
+ *
+ * Line numbers in the journal are only correct while every edit of the
+ * file is journalled; an edit that is not (SET UNDOING OFF, or a command
+ * that rearranges lines without going through these functions) empties
+ * the journals of the file.
+ */
+
+static long journal_sequence = 0L;
+static uchar *journal_line = NULL;
+static long journal_line_size = 0L;
+
+static void journal_clear(JOURNAL *);
+static long journal_size(FILE_DETAILS *);
+static void journal_limit(FILE_DETAILS *);
+static bool journal_add(JOURNAL *, long, uchar, long, long, long, uchar *, long);
+static bool journal_record(FILE_DETAILS *);
+static uchar *journal_room(long);
+static short journal_move(FILE_DETAILS *, JOURNAL *, long, JOURNAL_ENTRY *, uchar *);
+static short journal_apply(VIEW_DETAILS *, JOURNAL *, JOURNAL *, long, long *);
+static long journal_moved_line(JOURNAL *, JOURNAL_ENTRY *, long, bool);
+static uchar *journal_line_after(FILE_DETAILS *, long, long *);
+
+static void journal_clear(JOURNAL *jn) {
+  if (jn->entries) {
+    free(jn->entries);
+  }
+  if (jn->data) {
+    free(jn->data);
+  }
+  memset(jn, 0, sizeof(JOURNAL));
+}
+
+static long journal_size(FILE_DETAILS *cf) {
+  return ((cf->undo.num_entries + cf->redo.num_entries) * (long) sizeof(JOURNAL_ENTRY) + cf->undo.data_length + cf->redo.data_length);
+}
+
+/*
+ * Keeps the journals of a file within JOURNAL_MAX_SIZE by forgetting the
+ * oldest commands that can be undone. If the command being journalled is
+ * too big by itself, none of it can be undone.
+ */
+static void journal_limit(FILE_DETAILS *cf) {
+  JOURNAL *jn = &cf->undo;
+  long i = 0L, base = 0L;
+
+  if (journal_size(cf) <= JOURNAL_MAX_SIZE) {
+    return;
+  }
+  journal_clear(&cf->redo);
+  /*
+   * Forget whole commands until a quarter of the limit is free,
+   * so that the entries left are not moved for every edit.
+   */
+  while (i < jn->num_entries && jn->entries[i].sequence != journal_sequence && journal_size(cf) - i * (long) sizeof(JOURNAL_ENTRY) - jn->entries[i].data > JOURNAL_MAX_SIZE - (JOURNAL_MAX_SIZE / 4)) {
+    i++;
+    while (i < jn->num_entries && jn->entries[i].sequence == jn->entries[i - 1].sequence) {
+      i++;
+    }
+  }
+  if (i == jn->num_entries || journal_size(cf) - i * (long) sizeof(JOURNAL_ENTRY) - jn->entries[i].data > JOURNAL_MAX_SIZE) {
+    journal_clear(jn);
+    jn->overflow = journal_sequence;
+    return;
+  }
+  base = jn->entries[i].data;
+  memmove(jn->entries, jn->entries + i, (jn->num_entries - i) * sizeof(JOURNAL_ENTRY));
+  jn->num_entries -= i;
+  memmove(jn->data, jn->data + base, jn->data_length - base);
+  jn->data_length -= base;
+  for (i = 0L; i < jn->num_entries; i++) {
+    jn->entries[i].data -= base;
+  }
+}
+
+/*
+ * Appends an entry, merging it into the last one where they undo as one
+ * (lines inserted next to each other are deleted together).
+ */
+static bool journal_add(JOURNAL *jn, long sequence, uchar type, long line_number, long offset, long length, uchar *data, long data_length) {
+  JOURNAL_ENTRY *je = NULL;
+  void *grown = NULL;
+  long size = 0L;
+
+  if (type == JOURNAL_DELETE && jn->num_entries != 0) {
+    je = jn->entries + jn->num_entries - 1;
+    if (je->sequence == sequence && je->type == JOURNAL_DELETE && line_number >= je->line_number && line_number <= je->line_number + je->length) {
+      je->length += length;
+      return (TRUE);
+    }
+  }
+  if (jn->num_entries == jn->max_entries) {
+    size = (jn->max_entries) ? jn->max_entries * 2 : 64;
+    if ((grown = realloc(jn->entries, size * sizeof(JOURNAL_ENTRY))) == NULL) {
+      return (FALSE);
+    }
+    jn->entries = (JOURNAL_ENTRY *) grown;
+    jn->max_entries = size;
+  }
+  if (jn->data_length + data_length > jn->max_data) {
+    for (size = (jn->max_data) ? jn->max_data * 2 : 4096; size < jn->data_length + data_length; size *= 2);
+    if ((grown = realloc(jn->data, size)) == NULL) {
+      return (FALSE);
+    }
+    jn->data = (uchar *) grown;
+    jn->max_data = size;
+  }
+  je = jn->entries + jn->num_entries++;
+  je->sequence = sequence;
+  je->type = type;
+  je->line_number = line_number;
+  je->offset = offset;
+  je->length = length;
+  je->data = jn->data_length;
+  je->data_length = data_length;
+  je->recovered = FALSE;
+  if (data_length) {
+    memcpy(jn->data + jn->data_length, data, data_length);
+    jn->data_length += data_length;
+  }
+  return (TRUE);
+}
+
+/*
+ * Decides if an edit of the file is to be journalled. A new edit means
+ * there is nothing to redo.
+ */
+static bool journal_record(FILE_DETAILS *cf) {
+  if (cf->journal_altered > cf->journal_recorded && cf->journal_altered != journal_sequence) {
+    journal_discard(cf);
+  }
+  cf->journal_recorded = journal_sequence;
+  if (!cf->undoing) {
+    journal_discard(cf);
+    return (FALSE);
+  }
+  if (cf->redo.num_entries) {
+    journal_clear(&cf->redo);
+  }
+  if (cf->undo.overflow == journal_sequence) {
+    return (FALSE);
+  }
+  return (TRUE);
+}
+
+static uchar *journal_room(long size) {
+  uchar *grown = NULL;
+
+  if (size + 1 > journal_line_size) {
+    if ((grown = (uchar *) realloc(journal_line, size + 1)) == NULL) {
+      return (NULL);
+    }
+    journal_line = grown;
+    journal_line_size = size + 1;
+  }
+  return (journal_line);
+}
+
+/*
+ * Starts a new command; edits from here on are undone separately from
+ * those made before.
+ */
+void journal_begin_command(void) {
+  journal_sequence++;
+}
+
+/*
+ * Records that line_number is about to change from old to new. If new is
+ * NULL, the new contents are not known yet, all of old is kept, and
+ * journal_changed_line() can keep less once the line has been changed.
+ */
+void journal_change(FILE_DETAILS *cf, long line_number, uchar *old, long old_length, uchar *new, long new_length) {
+  long start = 0L, end = 0L;
+
+  invalidate_comment_states(cf, line_number);
+  if (!journal_record(cf)) {
+    return;
+  }
+  if (new == NULL) {
+    if (!journal_add(&cf->undo, journal_sequence, JOURNAL_CHANGE, line_number, 0L, -1L, old, old_length)) {
+      journal_discard(cf);
+    }
+    journal_limit(cf);
+    return;
+  }
+  for (start = 0L; start < old_length && start < new_length && old[start] == new[start]; start++);
+  for (end = 0L; end < old_length - start && end < new_length - start && old[old_length - end - 1] == new[new_length - end - 1]; end++);
+  if (!journal_add(&cf->undo, journal_sequence, JOURNAL_CHANGE, line_number, start, new_length - start - end, old + start, old_length - start - end)) {
+    journal_discard(cf);
+  }
+  journal_limit(cf);
+}
+
+/*
+ * Keeps only the bytes that differ for the last change journalled, now
+ * that the line has been changed in place.
+ */
+void journal_changed_line(FILE_DETAILS *cf, LINE *curr) {
+  JOURNAL *jn = &cf->undo;
+  JOURNAL_ENTRY *je = NULL;
+  uchar *old = NULL;
+  long start = 0L, end = 0L;
+
+  if (jn->num_entries == 0 || jn->entries[jn->num_entries - 1].sequence != journal_sequence || jn->entries[jn->num_entries - 1].type != JOURNAL_CHANGE || jn->entries[jn->num_entries - 1].length != (-1)) {
+    return;
+  }
+  je = jn->entries + jn->num_entries - 1;
+  old = jn->data + je->data;
+  for (start = 0L; start < je->data_length && start < curr->length && old[start] == curr->line[start]; start++);
+  for (end = 0L; end < je->data_length - start && end < curr->length - start && old[je->data_length - end - 1] == curr->line[curr->length - end - 1]; end++);
+  memmove(old, old + start, je->data_length - start - end);
+  je->offset = start;
+  je->length = curr->length - start - end;
+  je->data_length -= start + end;
+  jn->data_length = je->data + je->data_length;
+}
+
+/*
+ * Records that num_lines lines have been inserted from line_number.
+ */
+void journal_insert(FILE_DETAILS *cf, long line_number, long num_lines) {
+  invalidate_comment_states(cf, line_number);
+  if (!journal_record(cf)) {
+    return;
+  }
+  if (!journal_add(&cf->undo, journal_sequence, JOURNAL_DELETE, line_number, 0L, num_lines, NULL, 0L)) {
+    journal_discard(cf);
+  }
+  journal_limit(cf);
+}
+
+/*
+ * Records that line_number, with the given contents, is about to be deleted.
+ */
+void journal_delete(FILE_DETAILS *cf, long line_number, uchar *line, long length) {
+  invalidate_comment_states(cf, line_number);
+  if (!journal_record(cf)) {
+    return;
+  }
+  if (!journal_add(&cf->undo, journal_sequence, JOURNAL_INSERT, line_number, 0L, 0L, line, length)) {
+    journal_discard(cf);
+  }
+  journal_limit(cf);
+}
+
+/*
+ * Records that num_lines lines have been moved among themselves. slots
+ * holds the line numbers they occupy, in ascending order, followed by the
+ * index in slots of the line number each line now there is to go back to.
+ */
+void journal_permute(FILE_DETAILS *cf, long num_lines, long *slots) {
+  invalidate_comment_states(cf, slots[0]);
+  if (!journal_record(cf)) {
+    return;
+  }
+  if (!journal_add(&cf->undo, journal_sequence, JOURNAL_PERMUTE, slots[0], 0L, num_lines, (uchar *) slots, 2L * num_lines * (long) sizeof(long))) {
+    journal_discard(cf);
+  }
+  journal_limit(cf);
+}
+
+/*
+ * Called as the alteration count of a file is incremented. If the last
+ * command that altered the file journalled nothing, its edits were not
+ * journalled and the journal no longer matches the file.
+ */
+void journal_alteration(FILE_DETAILS *cf) {
+  if (cf->journal_altered != journal_sequence) {
+    if (cf->journal_altered > cf->journal_recorded) {
+      journal_discard(cf);
+      invalidate_comment_states(cf, 0L);
+    }
+    cf->journal_altered = journal_sequence;
+  }
+}
+
+/*
+ * Called by a command that alters the file without changing the contents
+ * or the number of its lines, so that the journal is kept.
+ */
+void journal_unchanged(FILE_DETAILS *cf) {
+  cf->journal_recorded = journal_sequence;
+}
+
+void journal_discard(FILE_DETAILS *cf) {
+  journal_clear(&cf->undo);
+  journal_clear(&cf->redo);
+}
+
+/*
+ * Moves the lines of a JOURNAL_PERMUTE entry back into their old order,
+ * recording in to the order that moves them again. The lines are relinked,
+ * so they keep their names, selection levels and flags.
+ */
+static short journal_move(FILE_DETAILS *cf, JOURNAL *to, long sequence, JOURNAL_ENTRY *je, uchar *data) {
+  long num = je->length;
+  long *slots = NULL, *back = NULL, *order = NULL;
+  LINE **lines = NULL, **prevs = NULL, **nexts = NULL;
+  LINE *curr = NULL;
+  long line_number, s;
+  short rc = RC_OK;
+
+  slots = (long *) malloc(3 * num * sizeof(long));
+  lines = (LINE **) malloc(3 * num * sizeof(LINE *));
+  if (slots == NULL || lines == NULL) {
+    if (slots) {
+      free(slots);
+    }
+    if (lines) {
+      free(lines);
+    }
+    return (RC_OUT_OF_MEMORY);
+  }
+  memcpy(slots, data, 2 * num * sizeof(long));
+  back = slots + num;
+  order = slots + (2 * num);
+  prevs = lines + num;
+  nexts = lines + (2 * num);
+  if (slots[0] < 1 || slots[num - 1] > cf->number_lines) {
+    rc = RC_INVALID_ENVIRON;
+  }
+  /*
+   * order[] is the index of the line to move into each slot.
+   */
+  for (s = 0L; rc == RC_OK && s < num; s++) {
+    order[s] = (-1L);
+  }
+  for (s = 0L; rc == RC_OK && s < num; s++) {
+    if (back[s] < 0 || back[s] >= num || order[back[s]] != (-1L)) {
+      rc = RC_INVALID_ENVIRON;
+    } else {
+      order[back[s]] = s;
+    }
+  }
+  if (rc == RC_OK) {
+    curr = lll_find(cf->first_line, cf->last_line, slots[0], cf->number_lines);
+    for (s = 0L, line_number = slots[0]; s < num; line_number++, curr = curr->next) {
+      if (line_number == slots[s]) {
+        lines[s] = curr;
+        prevs[s] = curr->prev;
+        nexts[s] = curr->next;
+        s++;
+      }
+    }
+    /*
+     * Recorded in to, the index each line moved goes to is the one it came from.
+     */
+    memcpy(back, order, num * sizeof(long));
+    if (!journal_add(to, sequence, JOURNAL_PERMUTE, slots[0], 0L, num, (uchar *) slots, 2L * num * (long) sizeof(long))) {
+      rc = RC_OUT_OF_MEMORY;
+    }
+  }
+  if (rc == RC_OK) {
+    /*
+     * A slot next to another takes its new neighbour from it; otherwise
+     * it keeps the neighbour of the line that was there, which did not move.
+     */
+    for (s = 0L; s < num; s++) {
+      curr = lines[order[s]];
+      curr->prev = (s > 0 && slots[s - 1] == slots[s] - 1) ? lines[order[s - 1]] : prevs[s];
+      curr->next = (s < num - 1 && slots[s + 1] == slots[s] + 1) ? lines[order[s + 1]] : nexts[s];
+      curr->prev->next = curr;
+      curr->next->prev = curr;
+    }
+    lll_reindex(cf->first_line);
+  }
+  free(slots);
+  free(lines);
+  return (rc);
+}
+
+/*
+ * Undoes the edits of the last command in from, recording in to the
+ * edits that take them back. Returns the line edited first.
+ */
+static short journal_apply(VIEW_DETAILS *view, JOURNAL *from, JOURNAL *to, long sequence, long *line_number) {
+  FILE_DETAILS *cf = view->file_for_view;
+  JOURNAL_ENTRY *je = NULL;
+  LINE *curr = NULL;
+  uchar *line = NULL;
+  long last = from->entries[from->num_entries - 1].sequence;
+  long offset, length, new_length, start, end, i;
+  short rc = RC_OK;
+
+  while (from->num_entries != 0 && from->entries[from->num_entries - 1].sequence == last) {
+    je = from->entries + from->num_entries - 1;
+    *line_number = je->line_number;
+    invalidate_comment_states(cf, je->line_number);
+    switch (je->type) {
+      case JOURNAL_CHANGE:
+        if (je->line_number < 1 || je->line_number > cf->number_lines) {
+          return (RC_INVALID_ENVIRON);
+        }
+        curr = lll_find(cf->first_line, cf->last_line, je->line_number, cf->number_lines);
+        offset = (je->length == (-1)) ? 0L : je->offset;
+        length = (je->length == (-1)) ? curr->length : je->length;
+        if (offset + length > curr->length) {
+          return (RC_INVALID_ENVIRON);
+        }
+        new_length = curr->length - length + je->data_length;
+        if ((line = journal_room(new_length)) == NULL) {
+          return (RC_OUT_OF_MEMORY);
+        }
+        memcpy(line, curr->line, offset);
+        memcpy(line + offset, from->data + je->data, je->data_length);
+        memcpy(line + offset + je->data_length, curr->line + offset + length, curr->length - offset - length);
+        for (start = 0L; start < curr->length && start < new_length && curr->line[start] == line[start]; start++);
+        for (end = 0L; end < curr->length - start && end < new_length - start && curr->line[curr->length - end - 1] == line[new_length - end - 1]; end++);
+        if (!journal_add(to, sequence, JOURNAL_CHANGE, je->line_number, start, new_length - start - end, curr->line + start, curr->length - start - end)) {
+          return (RC_OUT_OF_MEMORY);
+        }
+        if (new_length > curr->length) {
+          if ((curr->line = resize_LINE(curr, new_length + 1)) == NULL) {
+            return (RC_OUT_OF_MEMORY);
+          }
+        }
+        memcpy(curr->line, line, new_length);
+        curr->length = new_length;
+        curr->line[new_length] = '\0';
+        curr->flags.changed_flag = TRUE;
+        break;
+      case JOURNAL_INSERT:
+        if (je->line_number < 1 || je->line_number > cf->number_lines + 1L) {
+          return (RC_INVALID_ENVIRON);
+        }
+        if (!journal_add(to, sequence, JOURNAL_DELETE, je->line_number, 0L, 1L, NULL, 0L)) {
+          return (RC_OUT_OF_MEMORY);
+        }
+        curr = lll_find(cf->first_line, cf->last_line, je->line_number - 1L, cf->number_lines);
+        if (add_LINE(cf->first_line, curr, from->data + je->data, je->data_length, view->display_low, TRUE) == NULL) {
+          return (RC_OUT_OF_MEMORY);
+        }
+        cf->number_lines++;
+        adjust_marked_lines(TRUE, je->line_number - 1L, 1L);
+        adjust_pending_prefix(view, TRUE, je->line_number - 1L, 1L);
+        break;
+      case JOURNAL_DELETE:
+        if (je->line_number < 1 || je->line_number + je->length - 1L > cf->number_lines) {
+          return (RC_INVALID_ENVIRON);
+        }
+        curr = lll_find(cf->first_line, cf->last_line, je->line_number, cf->number_lines);
+        for (i = 0L; i < je->length; i++) {
+          if (!journal_add(to, sequence, JOURNAL_INSERT, je->line_number, 0L, 0L, curr->line, curr->length)) {
+            return (RC_OUT_OF_MEMORY);
+          }
+          curr = delete_LINE(&cf->first_line, &cf->last_line, curr, DIRECTION_FORWARD, TRUE);
+        }
+        cf->number_lines -= je->length;
+        adjust_marked_lines(FALSE, je->line_number, je->length);
+        adjust_pending_prefix(view, FALSE, je->line_number, je->length);
+        break;
+      case JOURNAL_PERMUTE:
+        if ((rc = journal_move(cf, to, sequence, je, from->data + je->data)) != RC_OK) {
+          return (rc);
+        }
+        break;
+    }
+    from->data_length = je->data;
+    from->num_entries--;
+  }
+  return (RC_OK);
+}
+
+/*
+ * Undoes (or redoes) the edits of the last num commands in the current file.
+ */
+short journal_undo(bool redo, long num) {
+  FILE_DETAILS *cf = CURRENT_FILE;
+  JOURNAL *from = (redo) ? &cf->redo : &cf->undo;
+  JOURNAL *to = (redo) ? &cf->undo : &cf->redo;
+  long line_number = 0L, i;
+  short rc = RC_OK;
+
+  /*
+   * If the last command to alter the file was not journalled, nothing can be undone.
+   */
+  if (cf->journal_altered > cf->journal_recorded) {
+    journal_discard(cf);
+  }
+  for (i = 0L; i < num && from->num_entries != 0; i++) {
+    journal_sequence++;
+    if ((rc = journal_apply(CURRENT_VIEW, from, to, journal_sequence, &line_number)) != RC_OK) {
+      /*
+       * Stop at an edit that does not fit the file; the journals are no use now.
+       */
+      journal_discard(cf);
+      if (rc == RC_OUT_OF_MEMORY) {
+        display_error(30, (uchar *) "", FALSE);
+      }
+      break;
+    }
+  }
+  cf->journal_altered = cf->journal_recorded = journal_sequence;
+  if (i != 0) {
+    increment_alt(cf);
+    cf->journal_altered = cf->journal_recorded = journal_sequence;
+    if (line_number > cf->number_lines) {
+      line_number = cf->number_lines;
+    }
+    CURRENT_VIEW->focus_line = CURRENT_VIEW->current_line = find_next_in_scope(CURRENT_VIEW, NULL, line_number, DIRECTION_FORWARD);
+  }
+  sprintf((char *) temp_cmd, "%ld command(s) %s", i, (redo) ? "redone" : "undone");
+  display_error(0, temp_cmd, TRUE);
+  return (rc);
+}
+
+/*
+ * Follows line_number through the lines moved by a JOURNAL_PERMUTE entry:
+ * back to where the entry moves it, or forward to where it was moved from.
+ */
+static long journal_moved_line(JOURNAL *jn, JOURNAL_ENTRY *je, long line_number, bool back) {
+  uchar *data = jn->data + je->data;
+  long num = je->length;
+  long low = 0L, high = num - 1, mid = 0L, slot = 0L, index = 0L;
+
+  while (low <= high) {
+    mid = (low + high) / 2;
+    memcpy(&slot, data + mid * sizeof(long), sizeof(long));
+    if (slot == line_number) {
+      break;
+    }
+    if (slot < line_number) {
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
+  }
+  if (low > high) {
+    return (line_number);
+  }
+  if (back) {
+    memcpy(&index, data + (num + mid) * sizeof(long), sizeof(long));
+  } else {
+    for (index = 0L; index < num; index++) {
+      memcpy(&slot, data + (num + index) * sizeof(long), sizeof(long));
+      if (slot == mid) {
+        break;
+      }
+    }
+  }
+  memcpy(&slot, data + index * sizeof(long), sizeof(long));
+  return (slot);
+}
+
+/*
+ * Returns the contents that the line changed by the given entry had just
+ * after that change: the contents the line has now, or had when a later
+ * command deleted it, with the later changes to it undone.
+ */
+static uchar *journal_line_after(FILE_DETAILS *cf, long entry, long *length) {
+  JOURNAL *jn = &cf->undo;
+  JOURNAL_ENTRY *je = NULL;
+  LINE *curr = NULL;
+  long line_number = jn->entries[entry].line_number;
+  long i, last, offset, replaced, line_length = 0L;
+  uchar *line = NULL, *base = NULL;
+
+  for (i = entry + 1; i < jn->num_entries; i++) {
+    je = jn->entries + i;
+    if (je->type == JOURNAL_DELETE && je->line_number <= line_number) {
+      line_number += je->length;
+    } else if (je->type == JOURNAL_INSERT && je->line_number < line_number) {
+      line_number--;
+    } else if (je->type == JOURNAL_INSERT && je->line_number == line_number) {
+      base = jn->data + je->data;
+      line_length = je->data_length;
+      break;
+    } else if (je->type == JOURNAL_PERMUTE) {
+      line_number = journal_moved_line(jn, je, line_number, FALSE);
+    }
+  }
+  if (base == NULL) {
+    if (line_number < 1 || line_number > cf->number_lines) {
+      return (NULL);
+    }
+    curr = lll_find(cf->first_line, cf->last_line, line_number, cf->number_lines);
+    base = curr->line;
+    line_length = curr->length;
+  }
+  if ((line = journal_room(line_length)) == NULL) {
+    return (NULL);
+  }
+  memcpy(line, base, line_length);
+  /*
+   * Undo the later changes to the line, last first, following its line number back.
+   */
+  for (last = i - 1; last > entry; last--) {
+    je = jn->entries + last;
+    if (je->type == JOURNAL_DELETE && je->line_number <= line_number) {
+      line_number -= je->length;
+    } else if (je->type == JOURNAL_INSERT && je->line_number <= line_number) {
+      line_number++;
+    } else if (je->type == JOURNAL_PERMUTE) {
+      line_number = journal_moved_line(jn, je, line_number, TRUE);
+    } else if (je->type == JOURNAL_CHANGE && je->line_number == line_number) {
+      offset = (je->length == (-1)) ? 0L : je->offset;
+      replaced = (je->length == (-1)) ? line_length : je->length;
+      if (offset + replaced > line_length || (line = journal_room(line_length - replaced + je->data_length)) == NULL) {
+        return (NULL);
+      }
+      memmove(line + offset + je->data_length, line + offset + replaced, line_length - offset - replaced);
+      memcpy(line + offset, jn->data + je->data, je->data_length);
+      line_length += je->data_length - replaced;
+    }
+  }
+  *length = line_length;
+  return (line);
+}
+
+/*
+ * Inserts after the focus line the old contents of the last num lines
+ * changed or deleted in the current file that have not been recovered.
+ */
+void journal_recover(long num) {
+  FILE_DETAILS *cf = CURRENT_FILE;
+  JOURNAL *jn = &cf->undo;
+  JOURNAL_ENTRY *je = NULL;
+  LINE *first = NULL, *last = NULL, *curr = NULL;
+  uchar *line = NULL;
+  long i, offset, replaced, length = 0L, num_retr = 0L;
+
+  post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL, TRUE);
+  if (cf->journal_altered > cf->journal_recorded) {
+    journal_discard(cf);
+  }
+  /*
+   * Collect the lines first, as inserting them adds to the journal.
+   */
+  for (i = jn->num_entries - 1; i >= 0 && num_retr < num; i--) {
+    je = jn->entries + i;
+    if (je->recovered || je->type == JOURNAL_DELETE || je->type == JOURNAL_PERMUTE) {
+      continue;
+    }
+    if (je->type == JOURNAL_INSERT) {
+      line = jn->data + je->data;
+      length = je->data_length;
+    } else {
+      if ((line = journal_line_after(cf, i, &length)) == NULL) {
+        continue;
+      }
+      offset = (je->length == (-1)) ? 0L : je->offset;
+      replaced = (je->length == (-1)) ? length : je->length;
+      if (offset + replaced > length || (line = journal_room(length - replaced + je->data_length)) == NULL) {
+        continue;
+      }
+      memmove(line + offset + je->data_length, line + offset + replaced, length - offset - replaced);
+      memcpy(line + offset, jn->data + je->data, je->data_length);
+      length += je->data_length - replaced;
+    }
+    if ((last = add_LINE(first, last, line, length, 0, FALSE)) == NULL) {
+      display_error(30, (uchar *) "", FALSE);
+      break;
+    }
+    if (first == NULL) {
+      first = last;
+    }
+    je->recovered = TRUE;
+    num_retr++;
+  }
+  for (curr = first; curr != NULL; curr = curr->next) {
+    insert_new_line(current_screen, CURRENT_VIEW, curr->line, curr->length, 1L, get_true_line(TRUE), TRUE, FALSE, FALSE, CURRENT_VIEW->display_low, TRUE, FALSE);
+  }
+  lll_free(first);
+  /*
+   * If one or more lines were retrieved, increment the alteration counts
+   */
+  if (num_retr) {
+    increment_alt(cf);
+  }
+  sprintf((char *) temp_cmd, "%ld line(s) recovered", num_retr);
+  display_error(0, temp_cmd, TRUE);
+}
+
+void journal_free(void) {
+  if (journal_line) {
+    free(journal_line);
+    journal_line = NULL;
+    journal_line_size = 0L;
+  }
+}
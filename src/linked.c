@@ -113,14 +113,408 @@ THELIST *ll_free(THELIST *first, THELIST_DEL delfunc) {
   return (THELIST *) NULL;
 }
 
-LINE *lll_add(LINE *first, LINE *curr, unsigned short size) {
+/*
+ * Line position index.
+ *
+ * A large LINE list is divided into chunks of consecutive lines and the
+ * line count of each chunk is kept in a Fenwick tree, so lll_find() can
+ * locate a line number by descending the tree and walking at most one chunk.
+ * lll_add() and lll_del() keep the counts current, as does lll_join() for
+ * a run of lines linked in at once; code that relinks lines directly must
+ * call lll_reindex() afterwards.
+ */
+
+static void lll_index_free(LINE_INDEX *index) {
+  long i = 0L;
+
+  for (i = 0L; i < index->num_chunks; i++) {
+    free(index->chunks[i]);
+  }
+  if (index->chunks) {
+    free(index->chunks);
+  }
+  if (index->tree) {
+    free(index->tree);
+  }
+  free(index);
+}
+
+static void lll_index_build_tree(LINE_INDEX *index) {
+  long i = 0L, j = 0L;
+
+  for (i = 1L; i <= index->num_chunks; i++) {
+    index->tree[i] = index->chunks[i - 1]->count;
+  }
+  for (i = 1L; i <= index->num_chunks; i++) {
+    j = i + (i & -i);
+    if (j <= index->num_chunks) {
+      index->tree[j] += index->tree[i];
+    }
+  }
+  index->dirty = FALSE;
+}
+
+static void lll_index_count(LINE_CHUNK *chunk, long delta) {
+  LINE_INDEX *index = chunk->index;
+  long i = 0L;
+
+  chunk->count += delta;
+  /*
+   * If the tree is to be rebuilt anyway, don't bother updating it.
+   */
+  if (!index->dirty) {
+    for (i = chunk->slot + 1L; i <= index->num_chunks; i += (i & -i)) {
+      index->tree[i] += delta;
+    }
+  }
+}
+
+static LINE_CHUNK *lll_index_insert_chunk(LINE_INDEX *index, long slot, LINE *head, long count) {
+  LINE_CHUNK *chunk = NULL;
+  LINE_CHUNK **chunks = NULL;
+  long *tree = NULL;
+  long i = 0L, max_chunks = 0L;
+
+  if (index->num_chunks == index->max_chunks) {
+    max_chunks = (index->max_chunks) ? index->max_chunks * 2L : 16L;
+    if ((chunks = (LINE_CHUNK **) realloc(index->chunks, max_chunks * sizeof(LINE_CHUNK *))) == NULL) {
+      return (NULL);
+    }
+    index->chunks = chunks;
+    if ((tree = (long *) realloc(index->tree, (max_chunks + 1L) * sizeof(long))) == NULL) {
+      return (NULL);
+    }
+    index->tree = tree;
+    index->max_chunks = max_chunks;
+  }
+  if ((chunk = (LINE_CHUNK *) malloc(sizeof(LINE_CHUNK))) == NULL) {
+    return (NULL);
+  }
+  chunk->head = head;
+  chunk->count = count;
+  chunk->index = index;
+  memmove(index->chunks + slot + 1, index->chunks + slot, (index->num_chunks - slot) * sizeof(LINE_CHUNK *));
+  index->chunks[slot] = chunk;
+  index->num_chunks++;
+  for (i = slot; i < index->num_chunks; i++) {
+    index->chunks[i]->slot = i;
+  }
+  index->dirty = TRUE;
+  return (chunk);
+}
+
+static void lll_index_remove_chunk(LINE_CHUNK *chunk) {
+  LINE_INDEX *index = chunk->index;
+  long i = 0L;
+
+  index->num_chunks--;
+  memmove(index->chunks + chunk->slot, index->chunks + chunk->slot + 1, (index->num_chunks - chunk->slot) * sizeof(LINE_CHUNK *));
+  for (i = chunk->slot; i < index->num_chunks; i++) {
+    index->chunks[i]->slot = i;
+  }
+  index->dirty = TRUE;
+  free(chunk);
+  if (index->num_chunks == 0L) {
+    lll_index_free(index);
+  }
+}
+
+static void lll_index_split(LINE_CHUNK *chunk) {
+  LINE_CHUNK *new_chunk = NULL;
+  LINE *curr = NULL;
+  long i = 0L;
+
+  if (chunk->count <= 2L * LINE_INDEX_STRIDE) {
+    return;
+  }
+  for (i = 0L, curr = chunk->head; i < LINE_INDEX_STRIDE; i++, curr = curr->next);
+  /*
+   * If we can't get memory for a new chunk, just leave this one oversized.
+   */
+  if ((new_chunk = lll_index_insert_chunk(chunk->index, chunk->slot + 1L, curr, chunk->count - LINE_INDEX_STRIDE)) == NULL) {
+    return;
+  }
+  chunk->count = LINE_INDEX_STRIDE;
+  for (i = 0L; i < new_chunk->count; i++, curr = curr->next) {
+    curr->chunk = new_chunk;
+  }
+}
+
+static void lll_index_unlink(LINE *curr) {
+  LINE_CHUNK *chunk = curr->chunk;
+
+  curr->chunk = NULL;
+  if (chunk->count == 1L) {
+    lll_index_remove_chunk(chunk);
+    return;
+  }
+  if (chunk->head == curr) {
+    chunk->head = curr->next;
+  }
+  lll_index_count(chunk, -1L);
+}
+
+static LINE_INDEX *lll_index_build(LINE *first) {
+  LINE_INDEX *index = NULL;
+  LINE_CHUNK *chunk = NULL;
+  LINE *curr = NULL;
+
+  if ((index = (LINE_INDEX *) malloc(sizeof(LINE_INDEX))) == NULL) {
+    return (NULL);
+  }
+  memset(index, 0, sizeof(LINE_INDEX));
+  for (curr = first; curr != NULL; curr = curr->next) {
+    if (chunk == NULL || chunk->count == LINE_INDEX_STRIDE) {
+      if ((chunk = lll_index_insert_chunk(index, index->num_chunks, curr, 0L)) == NULL) {
+        if (first->chunk != NULL) {
+          lll_reindex(first);
+        } else {
+          lll_index_free(index);
+        }
+        return (NULL);
+      }
+    }
+    chunk->count++;
+    curr->chunk = chunk;
+  }
+  return (index);
+}
+
+static LINE *lll_index_find(LINE_INDEX *index, long line_number) {
+  LINE *curr = NULL;
+  long pos = 0L, step = 1L;
+
+  if (index->dirty) {
+    lll_index_build_tree(index);
+  }
+  /*
+   * Find the chunk containing line_number (0 based), leaving
+   * the offset of the line within the chunk in line_number.
+   */
+  while (step * 2L <= index->num_chunks) {
+    step *= 2L;
+  }
+  for (; step > 0L; step /= 2L) {
+    if (pos + step <= index->num_chunks && index->tree[pos + step] <= line_number) {
+      pos += step;
+      line_number -= index->tree[pos];
+    }
+  }
+  if (line_number < 0L || pos >= index->num_chunks) {
+    return (NULL);
+  }
+  for (curr = index->chunks[pos]->head; line_number > 0L; line_number--, curr = curr->next);
+  return (curr);
+}
+
+/*
+ * Line slabs.
+ *
+ * The lines of a file are allocated from a pool of slabs, LINE_SLAB_SIZE
+ * bytes each and aligned to that size, so that the slab, and through it the
+ * pool, of a line is found from its address. Lines deleted are kept in the
+ * pool for reuse, with no text, and the whole pool is freed a slab at a time
+ * with its file.
+ * lll_add() allocates a line from the pool of its neighbour, so a list
+ * started with lll_add_to_pool() stays in its pool; other lists are malloc()ed.
+ */
+
+#define LINE_SLAB_OF(line) ((LINE_SLAB *) ((size_t) (line) & ~((size_t) LINE_SLAB_SIZE - 1)))
+#define LINES_PER_SLAB ((LINE_SLAB_SIZE / sizeof(LINE)) - 1)
+
+LINE *lll_new(LINE_POOL *pool) {
+  LINE_SLAB *slab = NULL;
+  LINE *curr = NULL;
+  void *mem = NULL;
+
+  if ((curr = pool->free_lines) != NULL) {
+    pool->free_lines = curr->next;
+  } else {
+    if (pool->first_slab == NULL || pool->used == LINES_PER_SLAB) {
+      if (posix_memalign(&mem, LINE_SLAB_SIZE, LINE_SLAB_SIZE) != 0) {
+        return (NULL);
+      }
+      /*
+       * The slab header takes the place of its first line.
+       */
+      slab = (LINE_SLAB *) mem;
+      slab->next = pool->first_slab;
+      slab->pool = pool;
+      pool->first_slab = slab;
+      pool->used = 0L;
+    }
+    curr = (LINE *) pool->first_slab + 1 + pool->used++;
+  }
+  memset(curr, 0, sizeof(LINE));
+  curr->flags.slab_flag = TRUE;
+  return (curr);
+}
+
+/*
+ * Line extras.
+ *
+ * Few lines have a name, a list of names or a pending prefix command, so
+ * these are kept out of the LINE in a LINE_EXTRA found by hashing the
+ * address of the line; flags.extra_flag says whether a line has one.
+ * The table grows as entries are added and is freed when the last goes.
+ */
+
+static LINE_EXTRA **extra_table = NULL;
+static size_t extra_table_size = 0;
+static size_t extra_count = 0;
+
+#define LINE_EXTRA_HASH(line, size) ((((size_t) (line)) / sizeof(LINE)) & ((size) - 1))
+
+static bool lll_extra_grow(void) {
+  LINE_EXTRA **table = NULL, *curr = NULL, *next = NULL;
+  size_t size = (extra_table_size) ? extra_table_size * 2 : LINE_EXTRA_TABLE_SIZE;
+  size_t i = 0, hash = 0;
+
+  if ((table = (LINE_EXTRA **) calloc(size, sizeof(LINE_EXTRA *))) == NULL) {
+    return (FALSE);
+  }
+  for (i = 0; i < extra_table_size; i++) {
+    for (curr = extra_table[i]; curr != NULL; curr = next) {
+      next = curr->next;
+      hash = LINE_EXTRA_HASH(curr->owner, size);
+      curr->next = table[hash];
+      table[hash] = curr;
+    }
+  }
+  if (extra_table) {
+    free(extra_table);
+  }
+  extra_table = table;
+  extra_table_size = size;
+  return (TRUE);
+}
+
+/*
+ * Returns the LINE_EXTRA of curr. If it has none, one is created when create
+ * is TRUE; NULL is returned if it is FALSE or there is no memory.
+ */
+LINE_EXTRA *lll_extra(LINE *curr, bool create) {
+  LINE_EXTRA *extra = NULL;
+  size_t hash = 0;
+
+  if (curr->flags.extra_flag) {
+    for (extra = extra_table[LINE_EXTRA_HASH(curr, extra_table_size)]; extra->owner != curr; extra = extra->next);
+    return (extra);
+  }
+  if (!create) {
+    return (NULL);
+  }
+  if (extra_count >= extra_table_size && !lll_extra_grow()) {
+    return (NULL);
+  }
+  if ((extra = (LINE_EXTRA *) calloc(1, sizeof(LINE_EXTRA))) == NULL) {
+    return (NULL);
+  }
+  hash = LINE_EXTRA_HASH(curr, extra_table_size);
+  extra->owner = curr;
+  extra->next = extra_table[hash];
+  extra_table[hash] = extra;
+  extra_count++;
+  curr->flags.extra_flag = TRUE;
+  return (extra);
+}
+
+/*
+ * Removes the LINE_EXTRA of curr, freeing its name. The owner of the list of
+ * names and of the prefix command is responsible for freeing them.
+ */
+static void lll_extra_remove(LINE *curr) {
+  LINE_EXTRA **prev = NULL, *extra = NULL;
+
+  prev = &extra_table[LINE_EXTRA_HASH(curr, extra_table_size)];
+  for (extra = *prev; extra->owner != curr; prev = &extra->next, extra = extra->next);
+  *prev = extra->next;
+  if (extra->name) {
+    free(extra->name);
+  }
+  free(extra);
+  curr->flags.extra_flag = FALSE;
+  if (--extra_count == 0) {
+    free(extra_table);
+    extra_table = NULL;
+    extra_table_size = 0;
+  }
+}
+
+static void lll_dispose(LINE *curr) {
+  LINE_POOL *pool = NULL;
+
+  if (curr->flags.extra_flag) {
+    lll_extra_remove(curr);
+  }
+  if (curr->flags.slab_flag) {
+    pool = LINE_SLAB_OF(curr)->pool;
+    curr->line = NULL;
+    curr->next = pool->free_lines;
+    pool->free_lines = curr;
+  } else {
+    free(curr);
+  }
+}
+
+/*
+ * Moves the slabs and lines of pool from into pool to.
+ */
+void lll_merge_pool(LINE_POOL *to, LINE_POOL *from) {
+  LINE_SLAB *slab = NULL, *last = NULL;
+  LINE *curr = NULL;
+
+  if (from->first_slab == NULL) {
+    return;
+  }
+  for (slab = from->first_slab; slab != NULL; slab = slab->next) {
+    slab->pool = to;
+    last = slab;
+  }
+  /*
+   * Keep taking new lines from the newest slab of to, if it has one. The
+   * newest slab of from then counts as full, so its unused lines are cleared.
+   */
+  if (to->first_slab != NULL && from->used < LINES_PER_SLAB) {
+    memset((LINE *) from->first_slab + 1 + from->used, 0, (LINES_PER_SLAB - from->used) * sizeof(LINE));
+  }
+  if (to->first_slab == NULL) {
+    to->first_slab = from->first_slab;
+    to->used = from->used;
+  } else {
+    last->next = to->first_slab->next;
+    to->first_slab->next = from->first_slab;
+  }
+  if (from->free_lines) {
+    for (curr = from->free_lines; curr->next != NULL; curr = curr->next);
+    curr->next = to->free_lines;
+    to->free_lines = from->free_lines;
+  }
+  memset(from, 0, sizeof(LINE_POOL));
+}
+
+void lll_free_pool(LINE_POOL *pool) {
+  LINE_SLAB *slab = NULL;
+
+  while ((slab = pool->first_slab) != NULL) {
+    pool->first_slab = slab->next;
+    free(slab);
+  }
+  memset(pool, 0, sizeof(LINE_POOL));
+}
+
+static LINE *lll_link(LINE_POOL *pool, LINE *first, LINE *curr, unsigned short size) {
   LINE *next = NULL;
 
-  if ((next = (LINE *) malloc(size)) != (LINE *) NULL) {
+  if (pool) {
+    next = lll_new(pool);
+  } else if ((next = (LINE *) malloc(size)) != (LINE *) NULL) {
     /*
      * Ensure all pointers in the structure are set to NULL
      */
     memset(next, 0, size);
+  }
+  if (next != (LINE *) NULL) {
     if (curr == NULL) {
       if (first == NULL) {
         /*
@@ -146,18 +540,50 @@ LINE *lll_add(LINE *first, LINE *curr, unsigned short size) {
       curr->next = next;
       next->prev = curr;
     }
+    /*
+     * If the list is indexed, the new line joins the chunk of its neighbour.
+     */
+    if (curr == NULL) {
+      if (first != NULL && first->chunk != NULL) {
+        next->chunk = first->chunk;
+        next->chunk->head = next;
+      }
+    } else {
+      next->chunk = curr->chunk;
+    }
+    if (next->chunk != NULL) {
+      lll_index_count(next->chunk, 1L);
+      lll_index_split(next->chunk);
+    }
   }
   return (next);
 }
 
+LINE *lll_add(LINE *first, LINE *curr, unsigned short size) {
+  LINE *neighbour = (curr) ? curr : first;
+
+  if (neighbour != NULL && neighbour->flags.slab_flag && size == sizeof(LINE)) {
+    return (lll_link(LINE_SLAB_OF(neighbour)->pool, first, curr, size));
+  }
+  return (lll_link(NULL, first, curr, size));
+}
+
+LINE *lll_add_to_pool(LINE_POOL *pool, LINE *first, LINE *curr) {
+  return (lll_link(pool, first, curr, sizeof(LINE)));
+}
+
 LINE *lll_del(LINE **first, LINE **last, LINE *curr, short direction) {
   LINE *new_curr = NULL;
 
+  if (curr->chunk != NULL) {
+    lll_index_unlink(curr);
+  }
+
   /*
    * Delete the only record
    */
   if (curr->prev == NULL && curr->next == NULL) {
-    free(curr);
+    lll_dispose(curr);
     *first = NULL;
     if (last != NULL) {
       *last = NULL;
@@ -170,7 +596,7 @@ LINE *lll_del(LINE **first, LINE **last, LINE *curr, short direction) {
   if (curr->prev == NULL) {
     curr->next->prev = NULL;
     *first = new_curr = curr->next;
-    free(curr);
+    lll_dispose(curr);
     curr = new_curr;
     return (curr);
   }
@@ -183,7 +609,7 @@ LINE *lll_del(LINE **first, LINE **last, LINE *curr, short direction) {
     if (last != NULL) {
       *last = curr->prev;
     }
-    free(curr);
+    lll_dispose(curr);
     curr = new_curr;
     return (curr);
   }
@@ -198,7 +624,7 @@ LINE *lll_del(LINE **first, LINE **last, LINE *curr, short direction) {
     new_curr = curr->prev;
   }
 
-  free(curr);
+  lll_dispose(curr);
   curr = new_curr;
   return (curr);
 }
@@ -206,14 +632,42 @@ LINE *lll_del(LINE **first, LINE **last, LINE *curr, short direction) {
 LINE *lll_free(LINE *first) {
   LINE *curr = NULL;
   LINE *new_curr = NULL;
+  LINE_POOL *pool = NULL;
+  LINE_SLAB *slab = NULL;
+  long i = 0L, num_lines = 0L;
 
+  if (first != NULL && first->chunk != NULL) {
+    lll_index_free(first->chunk->index);
+  }
+  /*
+   * The lines of a pool are freed with their slabs, which are walked in
+   * address order rather than along the list; only lines with text of their
+   * own or an extra need anything more.
+   */
+  if (first != NULL && first->flags.slab_flag) {
+    pool = LINE_SLAB_OF(first)->pool;
+    for (slab = pool->first_slab; slab != NULL; slab = slab->next) {
+      num_lines = (slab == pool->first_slab) ? pool->used : (long) LINES_PER_SLAB;
+      for (i = 1; i <= num_lines; i++) {
+        curr = (LINE *) slab + i;
+        if (curr->line && !curr->flags.shared_flag) {
+          free(curr->line);
+        }
+        if (curr->flags.extra_flag) {
+          lll_extra_remove(curr);
+        }
+      }
+    }
+    lll_free_pool(pool);
+    return ((LINE *) NULL);
+  }
   curr = first;
   while (curr != NULL) {
-    if (curr->line) {
+    if (curr->line && !curr->flags.shared_flag) {
       free(curr->line);
     }
-    if (curr->name) {
-      free(curr->name);
+    if (curr->flags.extra_flag) {
+      lll_extra_remove(curr);
     }
     new_curr = curr->next;
     free(curr);
@@ -224,8 +678,25 @@ LINE *lll_free(LINE *first) {
 
 LINE *lll_find(LINE *first, LINE *last, long line_number, long max_lines) {
   LINE *curr = NULL;
+  LINE_INDEX *index = NULL;
   long i = 0L;
 
+  /*
+   * Large lists are indexed on first use; small ones are just walked.
+   */
+  if (first != NULL && (first->chunk != NULL || max_lines >= LINE_INDEX_MINIMUM)) {
+    index = (first->chunk) ? first->chunk->index : lll_index_build(first);
+    if (index != NULL) {
+      /*
+       * Out of range line numbers give the first or last line, as walking does.
+       */
+      if (line_number <= 0L) {
+        return (first);
+      }
+      curr = lll_index_find(index, line_number);
+      return ((curr == NULL) ? last : curr);
+    }
+  }
   if (line_number < (max_lines / 2)) {
     curr = first;
     if (curr != NULL) {
@@ -240,12 +711,81 @@ LINE *lll_find(LINE *first, LINE *last, long line_number, long max_lines) {
   return (curr);
 }
 
+void lll_reindex(LINE *first) {
+  LINE_INDEX *index = NULL;
+  LINE *curr = NULL;
+
+  /*
+   * Discard the position index of the list; it is rebuilt by the next lll_find().
+   */
+  if (first == NULL || first->chunk == NULL) {
+    return;
+  }
+  index = first->chunk->index;
+  for (curr = first; curr != NULL; curr = curr->next) {
+    curr->chunk = NULL;
+  }
+  lll_index_free(index);
+  return;
+}
+
+void lll_join(LINE *first, LINE *prev, LINE *head, LINE *tail, long count) {
+  LINE_INDEX *index = NULL;
+  LINE_CHUNK *chunk = NULL;
+  LINE *next = prev->next;
+  LINE *curr = NULL;
+  long i = 0L, slot = 0L;
+
+  /*
+   * Link the count lines from head to tail in after prev.
+   */
+  head->prev = prev;
+  prev->next = head;
+  tail->next = next;
+  if (next != NULL) {
+    next->prev = tail;
+  }
+  if (first->chunk == NULL) {
+    return;
+  }
+  /*
+   * If the list is indexed, the lines after prev in its chunk move to a
+   * chunk of their own, and the joined lines are counted in new chunks
+   * between the two, so that no more of the list than them is walked.
+   */
+  index = first->chunk->index;
+  slot = prev->chunk->slot + 1L;
+  if (next != NULL && next->chunk == prev->chunk) {
+    for (i = 0L, curr = next; curr != NULL && curr->chunk == prev->chunk; i++, curr = curr->next);
+    if ((chunk = lll_index_insert_chunk(index, slot, next, i)) == NULL) {
+      lll_reindex(first);
+      return;
+    }
+    prev->chunk->count -= i;
+    for (curr = next; i > 0L; i--, curr = curr->next) {
+      curr->chunk = chunk;
+    }
+  }
+  for (curr = head, chunk = NULL; count > 0L; count--, curr = curr->next) {
+    if (chunk == NULL || chunk->count == LINE_INDEX_STRIDE) {
+      if ((chunk = lll_index_insert_chunk(index, slot++, curr, 0L)) == NULL) {
+        lll_reindex(first);
+        return;
+      }
+    }
+    chunk->count++;
+    curr->chunk = chunk;
+  }
+  return;
+}
+
 LINE *lll_locate(LINE *first, uchar *value) {
   LINE *curr = NULL;
+  uchar *name = NULL;
 
   curr = first;
   while (curr) {
-    if (curr->name && strcmp((char *) curr->name, (char *) value) == 0) {
+    if (curr->flags.extra_flag && (name = lll_extra(curr, FALSE)->name) != NULL && strcmp((char *) name, (char *) value) == 0) {
       break;
     }
     curr = curr->next;
@@ -416,7 +416,10 @@ static int find_paired_comment_delim(uchar scrno, FILE_DETAILS *fd, int state, c
   SHOW_LINE *scurr;
 
   /*
-   * We never get called with STATE_START_TAG!
+   * If the supplied state is STATE_START_TAG, then starting at the supplied start location (row and column)
+   * check each character forwards until a matching start_delim is found.
+   * When found, set the start location and return STATE_START_TAG
+   * Otherwise return STATE_IGNORE
    *
    * If the supplied state is STATE_END_TAG, then starting at the supplied start location (row and column)
    * check each character backwardsforwards until a matching end_delim is found.
@@ -465,9 +468,150 @@ static int find_paired_comment_delim(uchar scrno, FILE_DETAILS *fd, int state, c
   return STATE_IGNORE;
 }
 
+/*
+ * A paired comment can span any number of lines, so whether the first
+ * displayed line starts inside one depends on every line before it. The
+ * comment open at the start of every COMMENT_CHECKPOINT_LINES line of the
+ * file is saved as it is found, and the state at any other line is found by
+ * scanning forward from the checkpoint before it. An edit only makes the
+ * checkpoints after the edited line wrong, so a redisplay scans at most
+ * COMMENT_CHECKPOINT_LINES lines more than are displayed.
+ *
+ * States are numbered from 1 in the order of the parser's comments; 0 means
+ * no comment is open.
+ */
+static bool comment_delim_at(PARSER_DETAILS *parser, uchar *ptr, long length, uchar *delim, short len_delim) {
+  if (len_delim == 0 || len_delim > length) {
+    return FALSE;
+  }
+  if (parser->case_sensitive) {
+    return memcmp(ptr, delim, len_delim) == 0;
+  }
+  return memcmpi(ptr, delim, len_delim) == 0;
+}
+
+/*
+ * Returns the comment open at the end of a line, given the comment open
+ * at its start. Strings and line comments hide the delimiters in them.
+ */
+static int scan_comment_state(PARSER_DETAILS *parser, int state, uchar *line, long length) {
+  PARSE_COMMENTS *curr = NULL, *open = NULL;
+  long i, first_nonblank;
+  int idx;
+  uchar quote = '\0';
+
+  if (state) {
+    for (idx = 1, open = parser->first_comments; idx < state; idx++, open = open->next);
+  }
+  for (first_nonblank = 0; first_nonblank < length && (line[first_nonblank] == ' ' || line[first_nonblank] == '\t'); first_nonblank++);
+  for (i = 0; i < length; i++) {
+    if (open) {
+      if (comment_delim_at(parser, line + i, length - i, open->end_delim, open->len_end_delim)) {
+        i += open->len_end_delim - 1;
+        open = NULL;
+        state = 0;
+      }
+      continue;
+    }
+    if (quote) {
+      if (line[i] == '\\' && ((quote == '\'' && parser->backslash_single_quote) || (quote == '"' && parser->backslash_double_quote))) {
+        i++;
+      } else if (line[i] == quote) {
+        quote = '\0';
+      }
+      continue;
+    }
+    if ((line[i] == '\'' && parser->check_single_quote) || (line[i] == '"' && parser->check_double_quote)) {
+      quote = line[i];
+      continue;
+    }
+    for (idx = 1, curr = parser->first_comments; curr != NULL; idx++, curr = curr->next) {
+      if (!comment_delim_at(parser, line + i, length - i, curr->start_delim, curr->len_start_delim)) {
+        continue;
+      }
+      if (curr->line_comment) {
+        if (curr->column == 0 || (curr->column == MAX_INT && i == first_nonblank) || curr->column == i) {
+          return 0;
+        }
+        continue;
+      }
+      i += curr->len_start_delim - 1;
+      open = curr;
+      state = idx;
+      break;
+    }
+  }
+  return state;
+}
+
+/*
+ * Returns the comment open at the start of line_number.
+ */
+static int paired_comment_state(FILE_DETAILS *fd, long line_number) {
+  COMMENT_CACHE *cache = &fd->comment_cache;
+  LINE *curr = NULL;
+  short *states = NULL;
+  long i, checkpoint;
+  int state;
+
+  if (cache->parser != fd->parser) {
+    cache->parser = fd->parser;
+    cache->num_valid = 0L;
+  }
+  if (cache->num_valid == 0L) {
+    if (cache->max_states == 0L) {
+      if ((cache->states = (short *) malloc(COMMENT_CHECKPOINT_LINES * sizeof(short))) == NULL) {
+        return 0;
+      }
+      cache->max_states = COMMENT_CHECKPOINT_LINES;
+    }
+    cache->states[0] = 0;
+    cache->num_valid = 1L;
+  }
+  checkpoint = min(line_number / COMMENT_CHECKPOINT_LINES, cache->num_valid - 1L);
+  state = cache->states[checkpoint];
+  i = checkpoint * COMMENT_CHECKPOINT_LINES;
+  curr = lll_find(fd->first_line, fd->last_line, i, fd->number_lines);
+  for (; i < line_number && curr != NULL && curr->next != NULL; i++, curr = curr->next) {
+    if (i > 0L) {               /* not Top of File */
+      state = scan_comment_state(fd->parser, state, curr->line, curr->length);
+    }
+    if ((i + 1L) % COMMENT_CHECKPOINT_LINES == 0L && (i + 1L) / COMMENT_CHECKPOINT_LINES == cache->num_valid) {
+      if (cache->num_valid == cache->max_states) {
+        if ((states = (short *) realloc(cache->states, 2 * cache->max_states * sizeof(short))) == NULL) {
+          continue;
+        }
+        cache->states = states;
+        cache->max_states *= 2;
+      }
+      cache->states[cache->num_valid++] = (short) state;
+    }
+  }
+  return state;
+}
+
+/*
+ * Called as line_number of the file is changed, inserted or deleted.
+ */
+void invalidate_comment_states(FILE_DETAILS *fd, long line_number) {
+  long num_valid = (line_number < 0L) ? 0L : line_number / COMMENT_CHECKPOINT_LINES + 1L;
+
+  if (fd->comment_cache.num_valid > num_valid) {
+    fd->comment_cache.num_valid = num_valid;
+  }
+}
+
+void free_comment_states(FILE_DETAILS *fd) {
+  if (fd->comment_cache.states) {
+    free(fd->comment_cache.states);
+  }
+  memset(&fd->comment_cache, 0, sizeof(COMMENT_CACHE));
+}
+
 short parse_paired_comments(uchar scrno, FILE_DETAILS *fd) {
   PARSE_COMMENTS *curr_comments = fd->parser->first_comments;
-  int type = 0;
+  int type = 0, state = 0, idx;
+  int row;
   comment_loc locations;
 
   /*
@@ -484,67 +628,72 @@ short parse_paired_comments(uchar scrno, FILE_DETAILS *fd) {
    * If we did not find 'end of comment', set highlight_type from 'start of comment' to end of display,
    * and break - no more parsing to be done
    *
-   * If we find a match for an 'end of comment' then search for the 'start of comment' from the character
-   * before the match to the start of the current line, and on subsequent lines backwards.
-   * Ignore the highlight_type when looking for the 'start of comment' ONLY on the same line as the 'start of comment'.
-   * For all other lines ignore characters with highlight_type != THE_SYNTAX_NONE.
+   * If the first displayed line starts inside a comment (see paired_comment_state()), everything up to
+   * the first 'end of comment' is a comment, and the search starts after it.
    *
    * Repeat the above until we have parsed every line in the view
    *
    * -
    * Find the specified line comments
    */
-  for (; curr_comments != NULL; curr_comments = curr_comments->next) {
+  for (row = 0; row < screen[scrno].rows[WINDOW_FILEAREA]; row++) {
+    if (screen[scrno].sl[row].line_type == LINE_LINE) {
+      state = paired_comment_state(fd, screen[scrno].sl[row].line_number);
+      break;
+    }
+  }
+  for (idx = 1; curr_comments != NULL; idx++, curr_comments = curr_comments->next) {
     if (curr_comments->line_comment) {
       continue;
     }
-    type = STATE_START;
     memset(&locations, 0, sizeof(locations));
+    if (idx == state) {
+      /*
+       * The display starts inside this comment, so it is a comment up to
+       * the first end delimiter, or to the end of the display if there is none
+       */
+      type = find_paired_comment_delim(scrno, fd, STATE_END_TAG, &locations, curr_comments->start_delim, curr_comments->end_delim);
+      if (type != STATE_END_TAG) {
+        locations.end_row = screen[scrno].rows[WINDOW_FILEAREA] - 1;
+        locations.end_column = THE_MAX_SCREEN_WIDTH;
+        set_paired_comments(scrno, fd, &locations);
+        continue;
+      }
+      set_paired_comments(scrno, fd, &locations);
+      if (reset_paired_comments_locations(scrno, fd, &locations, STATE_END_TAG)) {
+        continue;
+      }
+    }
     for (;;) {
-      type = find_paired_comment_delim(scrno, fd, type, &locations, curr_comments->start_delim, curr_comments->end_delim);
+      type = find_paired_comment_delim(scrno, fd, STATE_START_TAG, &locations, curr_comments->start_delim, curr_comments->end_delim);
       if (type == STATE_IGNORE) { /* no more comment delimiters */
         break;
       }
-      if (type == STATE_START_TAG) {
-        /*
-         * Reset locations struct to start searching from start delimiter
-         */
-        if (reset_paired_comments_locations(scrno, fd, &locations, STATE_START_TAG)) {
-          break;
-        }
-        /* look forward for the matching end delimiter */
-        type = find_paired_comment_delim(scrno, fd, STATE_END_TAG, &locations, curr_comments->start_delim, curr_comments->end_delim);
-        if (type == STATE_END_TAG) {
-          set_paired_comments(scrno, fd, &locations);
-          /*
-           * Reset locations struct to start searching from end
-           */
-          type = STATE_START;
-          if (reset_paired_comments_locations(scrno, fd, &locations, STATE_END_TAG)) {
-            break;
-          }
-        } else {
-          /*
-           * must have received a STATE_IGNORE,
-           * so comment everything from start location to end of display and get out
-           */
-          locations.end_row = screen[scrno].rows[WINDOW_FILEAREA] - 1;
-          locations.end_column = THE_MAX_SCREEN_WIDTH;
-          set_paired_comments(scrno, fd, &locations);
-          break;
-        }
-      } else if (type == STATE_END_TAG) {
-        locations.start_row = 0;        /* should this be first row displayed ? */
-        locations.start_column = 0;
-        /* set all code from the end delimiter back to start of display to a comment */
+      /*
+       * Reset locations struct to start searching from start delimiter
+       */
+      if (reset_paired_comments_locations(scrno, fd, &locations, STATE_START_TAG)) {
+        break;
+      }
+      /* look forward for the matching end delimiter */
+      type = find_paired_comment_delim(scrno, fd, STATE_END_TAG, &locations, curr_comments->start_delim, curr_comments->end_delim);
+      if (type == STATE_END_TAG) {
         set_paired_comments(scrno, fd, &locations);
         /*
          * Reset locations struct to start searching from end
          */
-        type = STATE_START;
         if (reset_paired_comments_locations(scrno, fd, &locations, STATE_END_TAG)) {
           break;
         }
+      } else {
+        /*
+         * must have received a STATE_IGNORE,
+         * so comment everything from start location to end of display and get out
+         */
+        locations.end_row = screen[scrno].rows[WINDOW_FILEAREA] - 1;
+        locations.end_column = THE_MAX_SCREEN_WIDTH;
+        set_paired_comments(scrno, fd, &locations);
+        break;
       }
     }
   }
@@ -1393,56 +1542,165 @@ static short parse_columns(uchar scrno, FILE_DETAILS *fd, SHOW_LINE *scurr) {
   return RC_OK;
 }
 
-short find_preprocessor(FILE_DETAILS *fd, uchar *word, int len, int *alternate_colour) {
-  PARSE_KEYWORDS *curr = fd->parser->first_keyword;
-  uchar preprocessor_char = fd->parser->preprocessor_char;
-  bool found;
+/*
+ * Keywords and functions are looked up for every word displayed, so
+ * construct_parser() hashes them into a PARSE_WORD_TABLE each. The words
+ * of a case insensitive parser are kept in lower case, so that only the
+ * word looked up needs to be folded. A word defined more than once keeps
+ * its first definition.
+ */
+static unsigned int hash_word(PARSER_DETAILS *parser, uchar *word, int len) {
+  unsigned int hash = 2166136261U;
+  int i;
 
-  for (; curr != NULL; curr = curr->next) {
-    if (len == curr->keyword_length - 1) {
-      found = FALSE;
-      if (*(curr->keyword) == preprocessor_char) {
-        if (fd->parser->case_sensitive) {
-          if (memcmp(word, curr->keyword + 1, len) == 0) {
-            found = TRUE;
-          }
-        } else {
-          if (memcmpi(word, curr->keyword + 1, len) == 0) {
-            found = TRUE;
-          }
-        }
-      }
-      if (found) {
-        *alternate_colour = curr->alternate;
-        return len;
-      }
+  if (parser->case_sensitive) {
+    for (i = 0; i < len; i++) {
+      hash = (hash ^ word[i]) * 16777619U;
+    }
+  } else {
+    for (i = 0; i < len; i++) {
+      hash = (hash ^ (uchar) tolower(word[i])) * 16777619U;
     }
   }
-  return 0;
+  return hash;
 }
 
-bool find_keyword(FILE_DETAILS *fd, uchar *word, int len, int *alternate_colour) {
-  PARSE_KEYWORDS *curr = fd->parser->first_keyword;
-  bool found = FALSE;
+static PARSE_WORD *find_word(PARSER_DETAILS *parser, PARSE_WORD_TABLE *table, uchar *word, int len) {
+  PARSE_WORD *curr = NULL;
+  int idx, i;
 
-  for (; curr != NULL; curr = curr->next) {
-    if (len == curr->keyword_length) {
-      if (fd->parser->case_sensitive) {
-        if (memcmp(word, curr->keyword, len) == 0) {
-          found = TRUE;
-        }
-      } else {
-        if (memcmpi(word, curr->keyword, len) == 0) {
-          found = TRUE;
-        }
+  if (table->num_buckets == 0) {
+    return NULL;
+  }
+  for (idx = table->buckets[hash_word(parser, word, len) & (table->num_buckets - 1)]; idx != -1; idx = curr->next) {
+    curr = table->words + idx;
+    if (curr->word_length != len) {
+      continue;
+    }
+    if (parser->case_sensitive) {
+      if (memcmp(curr->word, word, len) == 0) {
+        return curr;
       }
-      if (found) {
-        *alternate_colour = curr->alternate;
-        break;
+    } else {
+      for (i = 0; i < len && curr->word[i] == tolower(word[i]); i++);
+      if (i == len) {
+        return curr;
       }
     }
   }
-  return found;
+  return NULL;
+}
+
+/*
+ * Allocates a table for num_words words of text_length bytes in all.
+ */
+static bool alloc_word_table(PARSE_WORD_TABLE *table, int num_words, long text_length) {
+  int i;
+
+  if (num_words == 0) {
+    return TRUE;
+  }
+  for (table->num_buckets = 16; table->num_buckets < num_words * 2; table->num_buckets *= 2);
+  table->words = (PARSE_WORD *) malloc(num_words * sizeof(PARSE_WORD));
+  table->text = (uchar *) malloc(text_length * sizeof(uchar));
+  table->buckets = (int *) malloc(table->num_buckets * sizeof(int));
+  if (table->words == NULL || table->text == NULL || table->buckets == NULL) {
+    return FALSE;
+  }
+  for (i = 0; i < table->num_buckets; i++) {
+    table->buckets[i] = -1;
+  }
+  return TRUE;
+}
+
+static void add_word(PARSER_DETAILS *parser, PARSE_WORD_TABLE *table, int *num_words, long *text_length, uchar *word, int len, uchar alternate) {
+  PARSE_WORD *curr = NULL;
+  unsigned int bucket;
+  int i;
+
+  if (find_word(parser, table, word, len) != NULL) {
+    return;
+  }
+  curr = table->words + *num_words;
+  curr->word = table->text + *text_length;
+  for (i = 0; i < len; i++) {
+    curr->word[i] = (parser->case_sensitive) ? word[i] : tolower(word[i]);
+  }
+  curr->word_length = len;
+  curr->alternate = alternate;
+  bucket = hash_word(parser, word, len) & (table->num_buckets - 1);
+  curr->next = table->buckets[bucket];
+  table->buckets[bucket] = (*num_words)++;
+  *text_length += len;
+}
+
+static void free_word_table(PARSE_WORD_TABLE *table) {
+  if (table->words) {
+    free(table->words);
+  }
+  if (table->text) {
+    free(table->text);
+  }
+  if (table->buckets) {
+    free(table->buckets);
+  }
+  memset(table, 0, sizeof(PARSE_WORD_TABLE));
+}
+
+static short build_word_tables(PARSER_DETAILS *parser) {
+  PARSE_KEYWORDS *curr_keyword = NULL;
+  PARSE_FUNCTIONS *curr_function = NULL;
+  int num_keywords = 0, num_preprocessor = 0, num_functions = 0;
+  long keyword_text = 0L, preprocessor_text = 0L, function_text = 0L;
+
+  for (curr_keyword = parser->first_keyword; curr_keyword != NULL; curr_keyword = curr_keyword->next) {
+    num_keywords++;
+    keyword_text += curr_keyword->keyword_length;
+    if (curr_keyword->keyword_length > 0 && *(curr_keyword->keyword) == parser->preprocessor_char) {
+      num_preprocessor++;
+      preprocessor_text += curr_keyword->keyword_length - 1;
+    }
+  }
+  for (curr_function = parser->first_function; curr_function != NULL; curr_function = curr_function->next) {
+    num_functions++;
+    function_text += curr_function->function_length;
+  }
+  if (!alloc_word_table(&parser->keyword_table, num_keywords, keyword_text) || !alloc_word_table(&parser->preprocessor_table, num_preprocessor, preprocessor_text) || !alloc_word_table(&parser->function_table, num_functions, function_text)) {
+    display_error(30, (uchar *) "", FALSE);
+    return RC_OUT_OF_MEMORY;
+  }
+  num_keywords = num_preprocessor = num_functions = 0;
+  keyword_text = preprocessor_text = function_text = 0L;
+  for (curr_keyword = parser->first_keyword; curr_keyword != NULL; curr_keyword = curr_keyword->next) {
+    add_word(parser, &parser->keyword_table, &num_keywords, &keyword_text, curr_keyword->keyword, curr_keyword->keyword_length, curr_keyword->alternate);
+    if (curr_keyword->keyword_length > 0 && *(curr_keyword->keyword) == parser->preprocessor_char) {
+      add_word(parser, &parser->preprocessor_table, &num_preprocessor, &preprocessor_text, curr_keyword->keyword + 1, curr_keyword->keyword_length - 1, curr_keyword->alternate);
+    }
+  }
+  for (curr_function = parser->first_function; curr_function != NULL; curr_function = curr_function->next) {
+    add_word(parser, &parser->function_table, &num_functions, &function_text, curr_function->function, curr_function->function_length, curr_function->alternate);
+  }
+  return RC_OK;
+}
+
+short find_preprocessor(FILE_DETAILS *fd, uchar *word, int len, int *alternate_colour) {
+  PARSE_WORD *curr = find_word(fd->parser, &fd->parser->preprocessor_table, word, len);
+
+  if (curr == NULL) {
+    return 0;
+  }
+  *alternate_colour = curr->alternate;
+  return len;
+}
+
+bool find_keyword(FILE_DETAILS *fd, uchar *word, int len, int *alternate_colour) {
+  PARSE_WORD *curr = find_word(fd->parser, &fd->parser->keyword_table, word, len);
+
+  if (curr == NULL) {
+    return FALSE;
+  }
+  *alternate_colour = curr->alternate;
+  return TRUE;
 }
 
 static short parse_keywords(uchar scrno, FILE_DETAILS *fd, SHOW_LINE *scurr) {
@@ -1573,27 +1831,13 @@ static short parse_keywords(uchar scrno, FILE_DETAILS *fd, SHOW_LINE *scurr) {
 }
 
 bool find_function(FILE_DETAILS *fd, uchar *word, int len, int *alternate_colour) {
-  PARSE_FUNCTIONS *curr = fd->parser->first_function;
-  bool found = FALSE;
+  PARSE_WORD *curr = find_word(fd->parser, &fd->parser->function_table, word, len);
 
-  for (; curr != NULL; curr = curr->next) {
-    if (len == curr->function_length) {
-      if (fd->parser->case_sensitive) {
-        if (memcmp(word, curr->function, len) == 0) {
-          found = TRUE;
-        }
-      } else {
-        if (memcmpi(word, curr->function, len) == 0) {
-          found = TRUE;
-        }
-      }
-      if (found) {
-        *alternate_colour = curr->alternate;
-        break;
-      }
-    }
+  if (curr == NULL) {
+    return FALSE;
   }
-  return found;
+  *alternate_colour = curr->alternate;
+  return TRUE;
 }
 
 static short parse_functions(uchar scrno, FILE_DETAILS *fd, SHOW_LINE *scurr) {
@@ -1913,6 +2157,7 @@ short parse_line(uchar scrno, FILE_DETAILS *fd, SHOW_LINE *scurr, short start_ro
   }
   memcpy((char *) brec, scurr->contents, len);
   brec[len] = THE_CHAR_SPACE;
+  brec[len + 1] = '\0';        /* regexec() in match() needs a string */
   work = brec;
   number_blanks = 0;
   /*
@@ -3418,11 +3663,26 @@ short construct_parser(uchar *contents, int contents_length, PARSER_DETAILS **pa
       line[j++] = contents[i];
     }
   }
+  if (rc == RC_OK) {
+    rc = build_word_tables(last_parser);
+  }
   return rc;
 }
 
 short destroy_parser(PARSER_DETAILS *parser) {
   short rc = RC_OK;
+  int i;
+
+  /*
+   * Rows parsed with this parser must not be reused by one that gets its address.
+   */
+  for (i = 0; i < MAX_SCREENS; i++) {
+    invalidate_screen_rows((uchar) i);
+  }
+
+  free_word_table(&parser->keyword_table);
+  free_word_table(&parser->preprocessor_table);
+  free_word_table(&parser->function_table);
 
   if (parser->first_comments) {
     parser->first_comments = parse_commentsll_free(parser->first_comments);
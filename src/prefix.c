@@ -480,7 +480,7 @@ static short parse_prefix_command(THE_PPC *curr_ppc) {
    */
   curr = first_prefix_synonym;
   while (curr) {
-    if (strcmp((char *) curr_ppc->ppc_command, (char *) curr->name) != 0) {
+    if (strcmp((char *) curr_ppc->ppc_command, (char *) lll_extra(curr, FALSE)->name) != 0) {
       curr = curr->next;
       continue;
     }
@@ -1115,7 +1115,9 @@ void clear_pending_prefix_command(THE_PPC *curr_ppc, FILE_DETAILS *curr_file, LI
   if (curr == (LINE *) NULL) {
     curr = lll_find(curr_file->first_line, curr_file->last_line, curr_ppc->ppc_line_number, curr_file->number_lines);
   }
-  curr->pre = NULL;
+  if (curr->flags.extra_flag) {
+    lll_extra(curr, FALSE)->pre = NULL;
+  }
   curr_ppc->ppc_cmd_idx = (-1);
   curr_ppc->ppc_block_command = FALSE;
   curr_ppc->ppc_shadow_line = FALSE;
@@ -1139,7 +1141,9 @@ THE_PPC *delete_pending_prefix_command(THE_PPC *curr_ppc, FILE_DETAILS *curr_fil
   if (curr == (LINE *) NULL) {
     curr = lll_find(curr_file->first_line, curr_file->last_line, curr_ppc->ppc_line_number, curr_file->number_lines);
   }
-  curr->pre = NULL;
+  if (curr->flags.extra_flag) {
+    lll_extra(curr, FALSE)->pre = NULL;
+  }
   return_ppc = pll_del(&(curr_file->first_ppc), &(curr_file->last_ppc), curr_ppc, DIRECTION_FORWARD);
   return (return_ppc);
 }
@@ -1404,6 +1408,7 @@ void add_prefix_command(uchar curr_screen, VIEW_DETAILS *curr_view, LINE *curr,
   short i = 0;
   uchar temp_prefix_array[MAX_PREFIX_WIDTH + 1];
   THE_PPC *curr_ppc = NULL;
+  LINE_EXTRA *extra = NULL;
   bool redisplay_screen = FALSE;
 
   prefix_changed = FALSE;
@@ -1419,7 +1424,7 @@ void add_prefix_command(uchar curr_screen, VIEW_DETAILS *curr_view, LINE *curr,
    * If the prefix record area is blank, clear the pending prefix area.
    */
   if (blank_field(temp_prefix_array)) {
-    (void) delete_pending_prefix_command(curr->pre, curr_view->file_for_view, curr);
+    (void) delete_pending_prefix_command(LINE_PRE(curr), curr_view->file_for_view, curr);
     redisplay_screen = TRUE;
   } else {
     /*
@@ -1434,7 +1439,11 @@ void add_prefix_command(uchar curr_screen, VIEW_DETAILS *curr_view, LINE *curr,
         return;
       }
     }
-    curr->pre = curr_ppc;
+    if ((extra = lll_extra(curr, TRUE)) == NULL) {
+      display_error(30, (uchar *) "", FALSE);
+      return;
+    }
+    extra->pre = curr_ppc;
     /*
      * Parse the prefix command line into command and operands.
      */
@@ -1463,16 +1472,14 @@ void add_prefix_command(uchar curr_screen, VIEW_DETAILS *curr_view, LINE *curr,
 
 short add_prefix_synonym(uchar *synonym, uchar *macroname) {
   LINE *curr = NULL;
+  LINE_EXTRA *extra = NULL;
 
   /*
    * First thing is to delete any definitions that may exist for the supplied synonym.
    */
   curr = first_prefix_synonym;
   while (curr != NULL) {
-    if (strcmp((char *) curr->name, (char *) synonym) == 0) {
-      if (curr->name != NULL) {
-        free(curr->name);
-      }
+    if (strcmp((char *) lll_extra(curr, FALSE)->name, (char *) synonym) == 0) {
       if (curr->line != NULL) {
         free(curr->line);
       }
@@ -1494,18 +1501,20 @@ short add_prefix_synonym(uchar *synonym, uchar *macroname) {
       display_error(30, (uchar *) "", FALSE);
       return (RC_OUT_OF_MEMORY);
     }
+    /*
+     * Every synonym in the list has a name, so a synonym that cannot be completed is taken off again.
+     */
     curr->line = (uchar *) malloc((strlen((char *) macroname) + 1) * sizeof(uchar));
-    if (curr->line == NULL) {
+    if (curr->line == NULL || (extra = lll_extra(curr, TRUE)) == NULL || (extra->name = (uchar *) malloc((strlen((char *) synonym) + 1) * sizeof(uchar))) == NULL) {
+      if (curr->line != NULL) {
+        free(curr->line);
+      }
+      lll_del(&first_prefix_synonym, &last_prefix_synonym, curr, DIRECTION_FORWARD);
       display_error(30, (uchar *) "", FALSE);
       return (RC_OUT_OF_MEMORY);
     }
     strcpy((char *) curr->line, (char *) macroname);
-    curr->name = (uchar *) malloc((strlen((char *) synonym) + 1) * sizeof(uchar));
-    if (curr->name == NULL) {
-      display_error(30, (uchar *) "", FALSE);
-      return (RC_OUT_OF_MEMORY);
-    }
-    strcpy((char *) curr->name, (char *) synonym);
+    strcpy((char *) extra->name, (char *) synonym);
     last_prefix_synonym = curr;
     if (first_prefix_synonym == NULL) {
       first_prefix_synonym = last_prefix_synonym;
@@ -1519,7 +1528,7 @@ uchar *find_prefix_synonym(uchar *synonym) {
 
   curr = first_prefix_synonym;
   while (curr != NULL) {
-    if (strcmp((char *) synonym, (char *) curr->name) == 0) {
+    if (strcmp((char *) synonym, (char *) lll_extra(curr, FALSE)->name) == 0) {
       return ((uchar *) curr->line);
     }
     curr = curr->next;
@@ -1533,7 +1542,7 @@ uchar *find_prefix_oldname(uchar *oldname) {
   curr = first_prefix_synonym;
   while (curr != NULL) {
     if (strcmp((char *) oldname, (char *) curr->line) == 0) {
-      return (curr->name);
+      return (lll_extra(curr, FALSE)->name);
     }
     curr = curr->next;
   }
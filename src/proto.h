@@ -31,7 +31,7 @@ bool valid_command_to_save (uchar *);
 bool is_tab_col (long);
 long find_next_tab_col (long);
 long find_prev_tab_col (long);
-short tabs_convert (LINE *, bool, bool, bool);
+short tabs_convert (LINE *, bool, bool, long);
 short convert_hex_strings (uchar *);
 short marked_block (bool);
 short suspend_curses (void);
@@ -73,8 +73,9 @@ short find_target (TARGET *, long, bool, bool);
 short find_column_target (uchar *, long, TARGET *, long, bool, bool);
 THELIST *find_line_name (LINE * curr, uchar * name);
 LINE *find_named_line (uchar *, long *, bool);
-short find_string_target (LINE *, RTARGET *, long, int);
+short find_string_target (LINE *, RTARGET *, long, int, uchar *);
 short find_rtarget_target (LINE *, TARGET *, long, long, long *);
+long find_rtarget_lines (TARGET *, LINE *, long, long, long, short *, long *);
 bool find_rtarget_column_target (uchar *, long, TARGET *, long, long, long *);
 long find_next_in_scope (VIEW_DETAILS *, LINE *, long, short);
 long find_last_not_in_scope (VIEW_DETAILS *, LINE *, long, short);
@@ -113,6 +114,7 @@ short execute_set_on_off (uchar *, bool *, bool);
 short execute_set_row_position (uchar *, short *, short *);
 short processable_line (VIEW_DETAILS *, long, LINE *);
 short execute_expand_compress (uchar *, bool, bool, bool, bool);
+short execute_undo (uchar *, bool);
 short execute_select (uchar *, bool, short);
 short execute_move_cursor (uchar, VIEW_DETAILS *, long);
 short execute_find_command (uchar *, long);
@@ -160,6 +162,11 @@ int expose_msgline (void);
 /* file.c */
 short get_file (uchar *);
 LINE *read_file (FILE *, LINE *, uchar *, long, long, bool);
+void load_file_lines (FILE_DETAILS *, long);
+void complete_file_load (FILE_DETAILS *);
+bool update_file_loads (void);
+bool file_loads_pending (void);
+void stop_file_load (FILE_DETAILS *);
 LINE *read_fixed_file (FILE *, LINE *, uchar *, long, long);
 short save_file (FILE_DETAILS *, uchar *, bool, long, long, long *, bool, long, long, bool, bool, bool);
 void increment_alt (FILE_DETAILS *);
@@ -188,6 +195,8 @@ void draw_cursor (bool);
 /* parser.c */
 short parse_line (uchar, FILE_DETAILS *, SHOW_LINE *, short);
 short parse_paired_comments (uchar, FILE_DETAILS *);
+void invalidate_comment_states (FILE_DETAILS *, long);
+void free_comment_states (FILE_DETAILS *);
 short construct_parser (uchar *, int, PARSER_DETAILS **, uchar *, uchar *);
 short destroy_parser (PARSER_DETAILS *);
 bool find_parser_mapping (FILE_DETAILS *, PARSER_MAPPING *);
@@ -220,6 +229,10 @@ void repaint_screen (void);
 void touch_screen (uchar);
 void refresh_screen (uchar);
 void redraw_screen (uchar);
+void invalidate_screen_rows (uchar);
+void free_parsed_lines (uchar);
+void start_highlighting_ahead (void);
+void complete_highlighting_ahead (void);
 bool line_in_view (uchar, long);
 bool column_in_view (uchar, long);
 long find_next_current_line (long, short);
@@ -262,6 +275,8 @@ long strzreveq (uchar *, uchar);
 uchar *strtrunc (uchar *);
 uchar *strstrip (uchar *, char, char);
 long memfind (uchar *, uchar *, long, long, bool, bool, uchar, uchar, long *);
+void memfind_compile (MEMFIND *, uchar *, uchar *, long, bool, bool, uchar, uchar);
+long memfind_run (MEMFIND *, uchar *, long, long *);
 void memrev (uchar *, uchar *, long);
 long memcmpi (uchar *, uchar *, long);
 uchar *make_upper (uchar *);
@@ -272,6 +287,12 @@ short valid_positive_integer_against_maximum (uchar *, long);
 long strzeq (uchar *, uchar);
 uchar *strtrans (uchar *, uchar, uchar);
 LINE *add_LINE (LINE *, LINE *, uchar *, long, ushort, bool);
+LINE *add_pooled_LINE (FILE_DETAILS *, LINE *, uchar *, long, ushort, bool);
+LINE *add_stored_LINE (FILE_DETAILS *, LINE *, uchar *, long);
+uchar *resize_LINE (LINE *, long);
+uchar *read_text (FILE_DETAILS *, int, long *);
+uchar *alloc_text (FILE_DETAILS *, long);
+void free_text_blocks (FILE_DETAILS *);
 LINE *append_LINE (LINE *, uchar *, long);
 LINE *delete_LINE (LINE **, LINE **, LINE *, short, bool);
 void put_string (WINDOW *, ushort, ushort, uchar *, long);
@@ -286,9 +307,6 @@ bool blank_field (uchar *);
 void adjust_marked_lines (bool, long, long);
 void adjust_pending_prefix (VIEW_DETAILS *, bool, long, long);
 uchar case_translate (uchar);
-void add_to_recovery_list (uchar *, long);
-void get_from_recovery_list (short);
-void free_recovery_list (void);
 short my_wmove (WINDOW *, short, short, short, short);
 short my_isalphanum (uchar);
 short get_row_for_tof_eof (short, uchar);
@@ -304,14 +322,35 @@ short my_wdelch (WINDOW *);
 short get_word (uchar *, long, long, long *, long *);
 short get_fieldword (uchar *, long, long, long *, long *);
 
+/* journal.c */
+void journal_begin_command (void);
+void journal_change (FILE_DETAILS *, long, uchar *, long, uchar *, long);
+void journal_changed_line (FILE_DETAILS *, LINE *);
+void journal_insert (FILE_DETAILS *, long, long);
+void journal_delete (FILE_DETAILS *, long, uchar *, long);
+void journal_permute (FILE_DETAILS *, long, long *);
+void journal_alteration (FILE_DETAILS *);
+void journal_unchanged (FILE_DETAILS *);
+void journal_discard (FILE_DETAILS *);
+short journal_undo (bool, long);
+void journal_recover (long);
+void journal_free (void);
+
 /* linked.c */
 THELIST *ll_add (THELIST * first, THELIST * curr, unsigned short size);
 THELIST *ll_del (THELIST ** first, THELIST ** last, THELIST * curr, short direction, THELIST_DEL delfunc);
 THELIST *ll_free (THELIST * first, THELIST_DEL delfunc);
+LINE *lll_new (LINE_POOL *);
+void lll_merge_pool (LINE_POOL *, LINE_POOL *);
+void lll_free_pool (LINE_POOL *);
 LINE *lll_add (LINE *, LINE *, unsigned short);
+LINE *lll_add_to_pool (LINE_POOL *, LINE *, LINE *);
+LINE_EXTRA *lll_extra (LINE *, bool);
 LINE *lll_del (LINE **, LINE **, LINE *, short);
 LINE *lll_free (LINE *);
 LINE *lll_find (LINE *, LINE *, long, long);
+void lll_reindex (LINE *);
+void lll_join (LINE *, LINE *, LINE *, LINE *, long);
 LINE *lll_locate (LINE *, uchar *);
 VIEW_DETAILS *vll_add (VIEW_DETAILS *, VIEW_DETAILS *, unsigned short);
 VIEW_DETAILS *vll_del (VIEW_DETAILS **, VIEW_DETAILS **, VIEW_DETAILS *, short);
@@ -362,6 +401,9 @@ short execute_macro_file (uchar *, uchar *, short *, bool);
 short execute_macro_instore (uchar *, short *, uchar **, int *, int *, int);
 short get_rexx_variable (uchar *, uchar **, int *);
 short set_rexx_variable (uchar *, uchar *, long, int);
+short queue_rexx_variable (uchar *, uchar *, long, int);
+short flush_rexx_variables (void);
+void discard_rexx_variables (void);
 
 /* os2eas.c */
 /* query.c */
@@ -593,6 +635,7 @@ short THERecord (uchar *);
 short Recover (uchar *);
 short Reexecute (uchar *);
 short Redit (uchar *);
+short Redo (uchar *);
 short Redraw (uchar *);
 short THERefresh (uchar *);
 short Repeat (uchar *);
@@ -691,6 +734,7 @@ short Trailing (uchar *);
 short THETypeahead (uchar *);
 short Undoing (uchar *);
 short Untaa (uchar *);
+short Undo (uchar *);
 short Up (uchar *);
 short Uppercase (uchar *);
 short Verify (uchar *);
@@ -627,11 +627,12 @@ short set_extract_variables(short itemno) {
 
   number_values = atoi((char *) item_values[0].value);
   for (i = 0; i < number_values + 1; i++) {
-    if ((rc = set_rexx_variable(query_item[itemno].name, item_values[i].value, item_values[i].len, i)) != RC_OK) {
-      break;
+    if ((rc = queue_rexx_variable(query_item[itemno].name, item_values[i].value, item_values[i].len, i)) != RC_OK) {
+      discard_rexx_variables();
+      return (rc);
     }
   }
-  return (rc);
+  return (flush_rexx_variables());
 }
 
 short get_number_dynamic_items(int qitem) {
@@ -715,11 +716,11 @@ short extract_point_settings(short itemno, uchar *params) {
   if (strcmp((char *) params, "") == 0) {       /* get name for focus line only */
     true_line = (compatible_feel == COMPAT_XEDIT) ? CURRENT_VIEW->current_line : get_true_line(TRUE);
     curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, true_line, CURRENT_FILE->number_lines);
-    if (curr->first_name == NULL) {     /* line not named */
+    if (LINE_FIRST_NAME(curr) == NULL) {       /* line not named */
       number_variables = 0;
     } else {
       total_len = sprintf((char *) query_rsrvd, "%ld", true_line);
-      curr_name = curr->first_name;
+      curr_name = LINE_FIRST_NAME(curr);
       while (curr_name) {
         len = strlen((char *) curr_name->data);
         if (total_len + len + 1 > sizeof(query_rsrvd)) {
@@ -741,9 +742,9 @@ short extract_point_settings(short itemno, uchar *params) {
     } else {
       curr = CURRENT_FILE->first_line;
       for (true_line = 0, i = 0; curr != NULL; true_line++) {
-        if (curr->first_name != NULL) { /* line is named */
+        if (LINE_FIRST_NAME(curr) != NULL) {   /* line is named */
           total_len = sprintf((char *) query_rsrvd, "%ld", true_line);
-          curr_name = curr->first_name;
+          curr_name = LINE_FIRST_NAME(curr);
           while (curr_name) {
             len = strlen((char *) curr_name->data);
             if (total_len + len + 1 > sizeof(query_rsrvd)) {
@@ -754,8 +755,9 @@ short extract_point_settings(short itemno, uchar *params) {
             total_len += len + 1;
             curr_name = curr_name->next;
           }
-          rc = set_rexx_variable(query_item[itemno].name, query_rsrvd, total_len, ++i);
-          if (rc == RC_SYSTEM_ERROR) {
+          rc = queue_rexx_variable(query_item[itemno].name, query_rsrvd, total_len, ++i);
+          if (rc != RC_OK) {
+            discard_rexx_variables();
             display_error(54, (uchar *) "", FALSE);
             return (EXTRACT_ARG_ERROR);
           }
@@ -764,7 +766,8 @@ short extract_point_settings(short itemno, uchar *params) {
       }
       sprintf((char *) num4, "%d", i);
       rc = set_rexx_variable(query_item[itemno].name, num4, strlen((char *) num4), 0);
-      if (rc == RC_SYSTEM_ERROR) {
+      if (rc != RC_OK) {
+        discard_rexx_variables();
         display_error(54, (uchar *) "", FALSE);
         number_variables = EXTRACT_ARG_ERROR;
       } else {
@@ -830,22 +833,24 @@ short extract_prefix_settings(short itemno, uchar *params, uchar query_type) {
       curr = first_prefix_synonym;
       i = 0;
       while (curr != NULL) {
-        tmpbuf = (uchar *) malloc(sizeof(uchar) * (strlen((char *) curr->name) + strlen((char *) curr->line) + 2));
+        tmpbuf = (uchar *) malloc(sizeof(uchar) * (strlen((char *) lll_extra(curr, FALSE)->name) + strlen((char *) curr->line) + 2));
         if (tmpbuf == (uchar *) NULL) {
+          discard_rexx_variables();
           display_error(30, (uchar *) "", FALSE);
           return (EXTRACT_ARG_ERROR);
         }
-        strcpy((char *) tmpbuf, (char *) curr->name);
+        strcpy((char *) tmpbuf, (char *) lll_extra(curr, FALSE)->name);
         strcat((char *) tmpbuf, " ");
         strcat((char *) tmpbuf, (char *) curr->line);
         if (query_type == QUERY_EXTRACT) {
-          rc = set_rexx_variable(query_item[itemno].name, tmpbuf, strlen((char *) tmpbuf), ++i);
+          rc = queue_rexx_variable(query_item[itemno].name, tmpbuf, strlen((char *) tmpbuf), ++i);
         } else {
           display_error(0, tmpbuf, FALSE);
           rc = RC_OK;
         }
         free(tmpbuf);
-        if (rc == RC_SYSTEM_ERROR) {
+        if (rc != RC_OK) {
+          discard_rexx_variables();
           display_error(54, (uchar *) "", FALSE);
           return (EXTRACT_ARG_ERROR);
         }
@@ -854,7 +859,8 @@ short extract_prefix_settings(short itemno, uchar *params, uchar query_type) {
       if (query_type == QUERY_EXTRACT) {
         sprintf((char *) num4, "%d", i);
         rc = set_rexx_variable(query_item[itemno].name, num4, strlen((char *) num4), 0);
-        if (rc == RC_SYSTEM_ERROR) {
+        if (rc != RC_OK) {
+          discard_rexx_variables();
           display_error(54, (uchar *) "", FALSE);
           number_variables = EXTRACT_ARG_ERROR;
         } else {
@@ -529,12 +529,12 @@ short extract_point(short number_variables, short itemno, uchar *itemargs, uchar
     case QUERY_MODIFY:
       true_line = (compatible_feel == COMPAT_XEDIT) ? CURRENT_VIEW->current_line : get_true_line(TRUE);
       curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, true_line, CURRENT_FILE->number_lines);
-      if (curr->first_name == NULL) {   /* line not named */
+      if (LINE_FIRST_NAME(curr) == NULL) {     /* line not named */
         item_values[1].value = (uchar *) "";
         item_values[1].len = 0;
       } else {
         strcpy((char *) query_rsrvd, "");
-        curr_name = curr->first_name;
+        curr_name = LINE_FIRST_NAME(curr);
         while (curr_name) {
           len = strlen((char *) curr_name->data);
           if (total_len + len + 1 > sizeof(query_rsrvd)) {
@@ -724,10 +724,13 @@ short extract_reserved(short number_variables, short itemno, uchar *itemargs, uc
     } else {
       attr_string = get_colour_strings(curr_rsrvd->attr);
       if (attr_string == (uchar *) NULL) {
+        discard_rexx_variables();
         return (EXTRACT_ARG_ERROR);
       }
       tmpbuf = (uchar *) malloc(sizeof(uchar) * (strlen((char *) attr_string) + strlen((char *) curr_rsrvd->line) + strlen((char *) curr_rsrvd->spec) + 13));
       if (tmpbuf == (uchar *) NULL) {
+        free(attr_string);
+        discard_rexx_variables();
         display_error(30, (uchar *) "", FALSE);
         return (EXTRACT_ARG_ERROR);
       }
@@ -741,9 +744,10 @@ short extract_reserved(short number_variables, short itemno, uchar *itemargs, uc
       strcat((char *) tmpbuf, (char *) attr_string);
       free(attr_string);
       strcat((char *) tmpbuf, (char *) curr_rsrvd->line);
-      rc = set_rexx_variable(query_item[itemno].name, tmpbuf, strlen((char *) tmpbuf), ++number_variables);
+      rc = queue_rexx_variable(query_item[itemno].name, tmpbuf, strlen((char *) tmpbuf), ++number_variables);
       free(tmpbuf);
-      if (rc == RC_SYSTEM_ERROR) {
+      if (rc != RC_OK) {
+        discard_rexx_variables();
         display_error(54, (uchar *) "", FALSE);
         return (EXTRACT_ARG_ERROR);
       }
@@ -761,7 +765,8 @@ short extract_reserved(short number_variables, short itemno, uchar *itemargs, uc
   } else {
     sprintf((char *) query_rsrvd, "%d", number_variables);
     rc = set_rexx_variable(query_item[itemno].name, query_rsrvd, strlen((char *) query_rsrvd), 0);
-    if (rc == RC_SYSTEM_ERROR) {
+    if (rc != RC_OK) {
+      discard_rexx_variables();
       display_error(54, (uchar *) "", FALSE);
       number_variables = EXTRACT_ARG_ERROR;
     } else {
@@ -1114,7 +1119,7 @@ short extract_statopt(short number_variables, short itemno, uchar *itemargs, uch
       number_variables = 0;
     }
     for (curr = first_option; curr != NULL; curr = curr->next) {
-      sprintf((char *) query_rsrvd, "%sON %s %d %d %s", (query_type == QUERY_QUERY) ? (char *) "statopt " : "", curr->name, curr->select + 1 + STATAREA_OFFSET, curr->save_select, (char *) ((curr->line != NULL) ? (char *) curr->line : ""));
+      sprintf((char *) query_rsrvd, "%sON %s %d %d %s", (query_type == QUERY_QUERY) ? (char *) "statopt " : "", LINE_NAME(curr), curr->select + 1 + STATAREA_OFFSET, curr->save_select, (char *) ((curr->line != NULL) ? (char *) curr->line : ""));
       if (query_type == QUERY_QUERY) {
         display_error(0, query_rsrvd, TRUE);
       } else {
@@ -1138,7 +1143,7 @@ short extract_statopt(short number_variables, short itemno, uchar *itemargs, uch
       /*
        * We found it
        */
-      sprintf((char *) query_rsrvd, "%sON %s %d %d %s", (query_type == QUERY_QUERY) ? (char *) "statopt " : "", curr->name, curr->select, curr->save_select, (char *) ((curr->line != NULL) ? (char *) curr->line : ""));
+      sprintf((char *) query_rsrvd, "%sON %s %d %d %s", (query_type == QUERY_QUERY) ? (char *) "statopt " : "", LINE_NAME(curr), curr->select, curr->save_select, (char *) ((curr->line != NULL) ? (char *) curr->line : ""));
     } else {
       /*
        * We didn't find it
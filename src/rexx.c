@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-2.0
 // SPDX-FileContributor: 2022 Ben Ravago
 
+#include <poll.h>
 #include <sys/wait.h>
 
 #include "the.h"
@@ -19,6 +20,19 @@ long rexxout_number_lines = 0L;
 
 #define BUF_SIZE 512
 
+/*
+ * The output of a command run by RUN_OS, read from one of its pipes and split into lines for a stem.
+ */
+struct os_capture {
+  int fd;                       /* read end of the pipe; -1 once closed */
+  uchar *stem;
+  char *line;                   /* a line not yet ended by a newline */
+  long length;
+  long size;
+  int lines;                    /* number of lines set in the stem */
+};
+typedef struct os_capture OS_CAPTURE;
+
 RexxSubcomHandler THE_Commands;
 RexxExitHandler THE_Exit_Handler;
 RexxFunctionHandler THE_Function_Handler;
@@ -28,12 +42,23 @@ static short valid_target_function(ULONG, RXSTRING[]);
 static short run_os_function(ULONG, RXSTRING[]);
 static int run_os_command(uchar *, uchar *, uchar *, uchar *);
 static uchar *MakeAscii(RXSTRING *);
-static char *get_a_line(FILE *, char *, int *, int *);
-static short set_rexx_variables_from_file(char *, uchar *);
+static void close_os_pipes(int *, int *, int *);
+static short capture_os_output(OS_CAPTURE *, char *, long);
 
 static long captured_lines;
 static bool rexx_halted;
 
+/*
+ * REXX variables queued by queue_rexx_variable() as a chain of SHVBLOCKs.
+ * Their names and values are copied into one arena, and are located by offset until the chain is passed to RexxVariablePool().
+ */
+static SHVBLOCK *shv_queue = NULL;
+static size_t *shv_offsets = NULL;
+static int shv_queued = 0;
+static char *shv_arena = NULL;
+static size_t shv_arena_size = 0;
+static size_t shv_arena_used = 0;
+
 /*
  * The following 2 variables count the number of calls made within the execution of a macro in case SET REXXHALT is set
  */
@@ -292,6 +317,13 @@ ULONG THE_Function_Handler(PSZ FunctionName, ULONG Argc, PRXSTRING Argv, PSZ Que
    * Find the external function name in the array. Error if not found.
    */
   set_compare_exact(TRUE);
+  /*
+   * Values such as SIZE() and targets depend on the whole file, so read
+   * the rest of a file still being read in the background first.
+   */
+  if (number_of_files > 0) {
+    complete_file_load(CURRENT_FILE);
+  }
   if (itemno == (-1)) {
     rc = search_query_item_array(function_item, number_function_item(), sizeof(QUERY_ITEM), (char *) FunctionName, functionname_length);
     if (rc == (-1)) {
@@ -405,6 +437,16 @@ short finalise_rexx(void) {
 
   rc = RexxDeregisterSubcom((PSZ) "THE", (PSZ) NULL);
   rc = RexxDeregisterExit((PSZ) "THE_EXIT", (PSZ) NULL);
+  if (shv_queue) {
+    free(shv_queue);
+    free(shv_offsets);
+    shv_queue = NULL;
+  }
+  if (shv_arena) {
+    free(shv_arena);
+    shv_arena = NULL;
+    shv_arena_size = 0;
+  }
   return ((short) rc);
 }
 
@@ -606,44 +648,119 @@ short get_rexx_variable(uchar *name, uchar **value, int *value_length) {
 }
 
 short set_rexx_variable(uchar *name, uchar *value, long value_length, int suffix) {
-  SHVBLOCK shv;
-  CHAR variable_name[250];
-  short rc = 0;
+  short rc = RC_OK;
 
-  shv.shvnext = NULL;           /* only one block */
-  shv.shvcode = RXSHV_SET;      /* use direct set */
-  /*
-   * This calls the RexxVariablePool() function for each value.
-   * This is not the most efficient way of doing this.
-   */
-  if (suffix == (-1)) {
-    strcpy(variable_name, (char *) name);
-  } else {
-    sprintf(variable_name, "%s.%-d", name, suffix);
+  if ((rc = queue_rexx_variable(name, value, value_length, suffix)) != RC_OK) {
+    return (rc);
+  }
+  return (flush_rexx_variables());
+}
+
+/*
+ * Queue a REXX variable to be set by the next flush_rexx_variables().
+ * name and value are copied, so the caller may reuse them straight away.
+ * A suffix of -1 sets name itself, otherwise the compound variable name.suffix.
+ */
+short queue_rexx_variable(uchar *name, uchar *value, long value_length, int suffix) {
+  int name_length;
+  size_t needed;
+  char digits[12];
+  char *p;
+  int i;
+  unsigned int number;
+
+  if (name == NULL) {           /* no stem was given; not a valid variable */
+    display_error(25, (uchar *) "", FALSE);
+    return (RC_SYSTEM_ERROR);
+  }
+  name_length = strlen((char *) name);
+  needed = name_length + 12 + value_length;
+  if (shv_queue == NULL) {
+    shv_queue = (SHVBLOCK *) malloc(REXX_VARIABLE_BATCH * sizeof(SHVBLOCK));
+    shv_offsets = (size_t *) malloc(REXX_VARIABLE_BATCH * sizeof(size_t));
+    if (shv_queue == NULL || shv_offsets == NULL) {
+      display_error(30, (uchar *) "", FALSE);
+      return (RC_OUT_OF_MEMORY);
+    }
+  }
+  if (shv_arena_used + needed > shv_arena_size) {
+    shv_arena_size = (shv_arena_used + needed) * 2;
+    if ((p = (char *) realloc(shv_arena, shv_arena_size)) == NULL) {
+      display_error(30, (uchar *) "", FALSE);
+      return (RC_OUT_OF_MEMORY);
+    }
+    shv_arena = p;
   }
-  (void) make_upper((uchar *) variable_name);   /* make variable name uppercase */
-  /*
-   * Now (attempt to) set the REXX variable
-   * Add name/value to SHVBLOCK
-   */
-  MAKERXSTRING(shv.shvname, variable_name, strlen(variable_name));
-  MAKERXSTRING(shv.shvvalue, (char *) value, value_length);
   /*
-   * One or both of these is needed, too <sigh>
+   * The name is made uppercase as it is copied; the suffix is written backwards then reversed into place.
    */
-  shv.shvnamelen = strlen(variable_name);
-  shv.shvvaluelen = value_length;
-  rc = RexxVariablePool(&shv);  /* Set the REXX variable */
-  /* rc = RXSHV_OK;*/
-  if (rc != RXSHV_OK && rc != RXSHV_NEWV) {
+  shv_offsets[shv_queued] = shv_arena_used;
+  p = shv_arena + shv_arena_used;
+  for (i = 0; i < name_length; i++) {
+    *p++ = toupper(name[i]);
+  }
+  if (suffix != (-1)) {
+    *p++ = '.';
+    number = (suffix < 0) ? -suffix : suffix;
+    i = 0;
+    do {
+      digits[i++] = '0' + (number % 10);
+      number /= 10;
+    } while (number);
+    if (suffix < 0) {
+      *p++ = '-';
+    }
+    while (i) {
+      *p++ = digits[--i];
+    }
+  }
+  shv_queue[shv_queued].shvcode = RXSHV_SET;
+  shv_queue[shv_queued].shvnamelen = shv_queue[shv_queued].shvname.strlength = (p - shv_arena) - shv_arena_used;
+  shv_queue[shv_queued].shvvaluelen = shv_queue[shv_queued].shvvalue.strlength = value_length;
+  if (value_length) {
+    memcpy(p, value, value_length);
+  }
+  shv_arena_used = (p - shv_arena) + value_length;
+  if (++shv_queued == REXX_VARIABLE_BATCH) {
+    return (flush_rexx_variables());
+  }
+  return (RC_OK);
+}
+
+/*
+ * Set all the queued REXX variables with one call of RexxVariablePool().
+ */
+short flush_rexx_variables(void) {
+  int i;
+  short rc = RC_OK;
+  ULONG ret;
+
+  if (shv_queued == 0) {
+    return (RC_OK);
+  }
+  for (i = 0; i < shv_queued; i++) {
+    shv_queue[i].shvnext = (i + 1 < shv_queued) ? &shv_queue[i + 1] : NULL;
+    shv_queue[i].shvname.strptr = shv_arena + shv_offsets[i];
+    shv_queue[i].shvvalue.strptr = shv_queue[i].shvname.strptr + shv_queue[i].shvnamelen;
+  }
+  ret = RexxVariablePool(shv_queue);   /* the returns of all the blocks or'ed together */
+  if (ret != RXSHV_OK && ret != RXSHV_NEWV) {
     display_error(25, (uchar *) "", FALSE);
     rc = RC_SYSTEM_ERROR;
-  } else {
-    rc = RC_OK;
   }
+  discard_rexx_variables();
   return (rc);
 }
 
+/*
+ * Forget the queued REXX variables without setting them, for a caller that gives up part way.
+ */
+void discard_rexx_variables(void) {
+  shv_queued = 0;
+  shv_arena_used = 0;
+  return;
+}
+
 static RXSTRING *get_compound_rexx_variable(uchar *name, RXSTRING *value, short suffix) {
   static SHVBLOCK shv;
   CHAR variable_name[250];
@@ -828,17 +945,23 @@ static int run_os_command(uchar *cmd, uchar *instem, uchar *outstem, uchar *errs
   RXSTRING tmpstr;
   bool in = TRUE, out = TRUE, err = TRUE;
   bool out_and_err_same = FALSE;
-  bool redirect_std_files;
   int inlen = 0, outlen = 0, errlen = 0;
   int i = 0;
-  FILE *infp = NULL;
-  char *infile = "", *outfile = "", *errfile = "";
   long innum = 0L;
-  int rc = 0, rcode = 0;
-  int save_stdin = 0, save_stdout = 0, save_stderr = 0;
-  int infd = 0, outfd = 0, errfd = 0;
+  int rc = 0, rc2 = 0, rcode = 0;
+  char *inbuf = NULL, *p;
+  long inbuflen = 0L, inbufsize = 0L, inbufpos = 0L;
+  int in_pipe[2], out_pipe[2], err_pipe[2];
+  OS_CAPTURE capture[2];
+  struct pollfd fds[3];
+  int nfds;
+  char buffer[BUF_SIZE * 16];
+  char tmpnum[15];
+  long len;
+  pid_t pid;
+  int status = 0;
+  void (*func)(int);
 
-  redirect_std_files = TRUE;
   /*
    * Determine if we are redirecting stdin, stdout or both and
    * if the * values passed as stem variables end in '.'.
@@ -893,7 +1016,7 @@ static int run_os_command(uchar *cmd, uchar *instem, uchar *outstem, uchar *errs
     }
   }
   /*
-   * If redirecting stdin, get the value of instem.0 to determine how many variables to get...
+   * If redirecting stdin, get the value of instem.0 to determine how many variables to get, and gather them into one buffer to be written to the command as it runs...
    */
   if (in) {
     tmpstr.strptr = NULL;
@@ -906,175 +1029,187 @@ static int run_os_command(uchar *cmd, uchar *instem, uchar *outstem, uchar *errs
     }
     innum = atol((char *) tmpstr.strptr);
     free(tmpstr.strptr);
-    /*
-     * Write the contents of the stdin stem to a temporary file...
-     */
-    if ((infile = tmpname("IN")) == NULL) {
-      return (RC_OUT_OF_MEMORY + 1000);
-    }
-    if ((infp = fopen(infile, "w")) == NULL) {
-      return (RC_ACCESS_DENIED + 1000);
-    }
     for (i = 0; i < innum; i++) {
       tmpstr.strptr = NULL;
       (void) get_compound_rexx_variable(instem, &tmpstr, (short) (i + 1));
       if (tmpstr.strptr == NULL) {
+        free(inbuf);
         return (RC_SYSTEM_ERROR + 1000);
       }
-      fputs((char *) tmpstr.strptr, infp);
-      fputs("\n", infp);
+      if (inbuflen + tmpstr.strlength + 1 > inbufsize) {
+        inbufsize = (inbuflen + tmpstr.strlength + 1) * 2;
+        if ((p = (char *) realloc(inbuf, inbufsize)) == NULL) {
+          free(tmpstr.strptr);
+          free(inbuf);
+          return (RC_OUT_OF_MEMORY + 1000);
+        }
+        inbuf = p;
+      }
+      memcpy(inbuf + inbuflen, tmpstr.strptr, tmpstr.strlength);
+      inbuflen += tmpstr.strlength;
+      inbuf[inbuflen++] = '\n';
       free(tmpstr.strptr);
     }
-    if (fclose(infp)) {
-      return (RC_ACCESS_DENIED + 1000);
-    }
   }
   /*
-   * If redirecting stdout, create the name of a temporary file for the output.
+   * Create a pipe for each redirected stream; if stdout and stderr go to the same stem, they share one pipe.
    */
-  if (out) {
-    if ((outfile = tmpname("OUT")) == NULL) {
-      return (RC_OUT_OF_MEMORY + 1000);
-    }
+  in_pipe[0] = in_pipe[1] = out_pipe[0] = out_pipe[1] = err_pipe[0] = err_pipe[1] = (-1);
+  if ((in && pipe(in_pipe) == (-1))
+      || (out && pipe(out_pipe) == (-1))
+      || (err && !out_and_err_same && pipe(err_pipe) == (-1))) {
+    close_os_pipes(in_pipe, out_pipe, err_pipe);
+    free(inbuf);
+    return (RC_SYSTEM_ERROR + 1000);
+  }
+  if (out_and_err_same) {
+    err_pipe[1] = out_pipe[1];
   }
   /*
-   * If redirecting stderr, create the name of a temporary file for the output.
+   * Execute the OS command supplied, with its redirected streams attached to the pipes.
    */
-  if (err) {
+  if ((pid = fork()) == (-1)) {
     if (out_and_err_same) {
-      errfile = outfile;
-    } else {
-      if ((errfile = tmpname("ERR")) == NULL) {
-        return (RC_OUT_OF_MEMORY + 1000);
-      }
+      err_pipe[1] = (-1);
     }
+    close_os_pipes(in_pipe, out_pipe, err_pipe);
+    free(inbuf);
+    return (RC_SYSTEM_ERROR + 1000);
   }
-
-  if (redirect_std_files) {
-    /*
-     * Save file ids for stdin, stdout and stderr, then reassign them to the appropriate temporary files.
-     */
+  if (pid == 0) {
     if (in) {
-      save_stdin = dup(fileno(stdin));
+      dup2(in_pipe[0], fileno(stdin));
     }
     if (out) {
-      save_stdout = dup(fileno(stdout));
+      dup2(out_pipe[1], fileno(stdout));
     }
     if (err) {
-      save_stderr = dup(fileno(stderr));
-    }
-    if (in) {
-      if ((infd = open(infile, O_RDONLY)) == (-1)) {
-        return (RC_ACCESS_DENIED + 1000);
-      }
-    }
-    if (out) {
-      if ((outfd = open(outfile, O_RDWR | O_CREAT | O_TRUNC, S_IWRITE | S_IREAD)) == (-1)) {
-        return (RC_ACCESS_DENIED + 1000);
-      }
+      dup2(err_pipe[1], fileno(stderr));
     }
     if (out_and_err_same) {
-      errfd = outfd;
-    } else {
-      if (err) {
-        if ((errfd = open(errfile, O_RDWR | O_CREAT | O_TRUNC, S_IWRITE | S_IREAD)) == (-1)) {
-          return (RC_ACCESS_DENIED + 1000);
-        }
-      }
-    }
-    if (out) {
-      chmod(outfile, S_IWUSR | S_IRUSR);
-    }
-    if (!out_and_err_same) {
-      if (err) {
-        chmod(errfile, S_IWUSR | S_IRUSR);
-      }
-    }
-    if (in) {
-      dup2(infd, fileno(stdin));
-    }
-    if (out) {
-      dup2(outfd, fileno(stdout));
-    }
-    if (err) {
-      dup2(errfd, fileno(stderr));
-    }
-    if (in) {
-      close(infd);
-    }
-    if (out) {
-      close(outfd);
-    }
-    if (!out_and_err_same) {
-      if (err) {
-        close(errfd);
-      }
+      err_pipe[1] = (-1);
     }
+    close_os_pipes(in_pipe, out_pipe, err_pipe);
+    execl("/bin/sh", "sh", "-c", (char *) cmd, (char *) NULL);
+    _exit(127);
   }
   /*
-   * Execute the OS command supplied.
+   * Close the child's ends of the pipes, and don't let a command that exits without reading all of its input kill us with SIGPIPE.
    */
-  rcode = system((char *) cmd);
-  if (rcode) {
-    rcode = WEXITSTATUS(rcode);
+  if (in) {
+    close(in_pipe[0]);
+    fcntl(in_pipe[1], F_SETFL, fcntl(in_pipe[1], F_GETFL) | O_NONBLOCK);
+    if (inbuflen == 0) {
+      close(in_pipe[1]);
+      in = FALSE;
+    }
   }
-  if (redirect_std_files) {
-    /*
-     * Put all file ids back the way they were...
-     */
+  if (out) {
+    close(out_pipe[1]);
+  }
+  if (err && !out_and_err_same) {
+    close(err_pipe[1]);
+  }
+  func = signal(SIGPIPE, SIG_IGN);
+  capture[0].fd = out ? out_pipe[0] : (-1);
+  capture[0].stem = outstem;
+  capture[1].fd = (err && !out_and_err_same) ? err_pipe[0] : (-1);
+  capture[1].stem = errstem;
+  for (i = 0; i < 2; i++) {
+    capture[i].line = NULL;
+    capture[i].length = capture[i].size = 0;
+    capture[i].lines = 0;
+  }
+  /*
+   * Feed stdin and set a REXX variable for each line of output as it arrives, until the command has closed all of its streams.
+   */
+  while (in || capture[0].fd != (-1) || capture[1].fd != (-1)) {
+    nfds = 0;
     if (in) {
-      dup2(save_stdin, fileno(stdin));
+      fds[nfds].fd = in_pipe[1];
+      fds[nfds++].events = POLLOUT;
     }
-    if (out) {
-      dup2(save_stdout, fileno(stdout));
+    for (i = 0; i < 2; i++) {
+      if (capture[i].fd != (-1)) {
+        fds[nfds].fd = capture[i].fd;
+        fds[nfds++].events = POLLIN;
+      }
     }
-    if (err) {
-      dup2(save_stderr, fileno(stderr));
+    if (poll(fds, nfds, -1) == (-1)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
     }
+    nfds = 0;
     if (in) {
-      close(save_stdin);
+      if (fds[nfds++].revents) {
+        len = write(in_pipe[1], inbuf + inbufpos, inbuflen - inbufpos);
+        if (len > 0) {
+          inbufpos += len;
+        }
+        if (inbufpos == inbuflen || (len == (-1) && errno != EAGAIN && errno != EINTR)) {
+          close(in_pipe[1]);
+          in = FALSE;
+        }
+      }
     }
-    if (out) {
-      close(save_stdout);
+    for (i = 0; i < 2; i++) {
+      if (capture[i].fd != (-1) && fds[nfds++].revents) {
+        len = read(capture[i].fd, buffer, sizeof(buffer));
+        if (len > 0) {
+          if ((rc2 = capture_os_output(&capture[i], buffer, len)) != RC_OK) {
+            rc = rc2;
+          }
+        } else if (len == 0 || (errno != EAGAIN && errno != EINTR)) {
+          if (capture[i].length) {
+            if ((rc2 = queue_rexx_variable(capture[i].stem, (uchar *) capture[i].line, capture[i].length, ++capture[i].lines)) != RC_OK) {
+              rc = rc2;
+            }
+          }
+          close(capture[i].fd);
+          capture[i].fd = (-1);
+        }
+      }
     }
-    if (err) {
-      close(save_stderr);
+  }
+  if (in) {
+    close(in_pipe[1]);
+  }
+  for (i = 0; i < 2; i++) {
+    if (capture[i].fd != (-1)) {
+      close(capture[i].fd);
     }
+    free(capture[i].line);
+  }
+  free(inbuf);
+  while (waitpid(pid, &status, 0) == (-1) && errno == EINTR);
+  signal(SIGPIPE, func);
+  if (status) {
+    rcode = WEXITSTATUS(status);
   }
   /*
-   * If redirecting stdout, we now have to read the file and set a REXX variable for each line read.
+   * Set the count of lines captured in each stem; this also sets any variables still queued.
    */
   if (out) {
-    rc = set_rexx_variables_from_file(outfile, outstem);
+    sprintf(tmpnum, "%d", capture[0].lines);
+    rc2 = set_rexx_variable(outstem, (uchar *) tmpnum, strlen(tmpnum), 0);
   } else {
-    rc = set_rexx_variable(outstem, (uchar *) "0", 1, 0);
+    rc2 = set_rexx_variable(outstem, (uchar *) "0", 1, 0);
   }
   if (err) {
     if (!out_and_err_same) {
-      rc = set_rexx_variables_from_file(errfile, errstem);
+      sprintf(tmpnum, "%d", capture[1].lines);
+      rc2 = set_rexx_variable(errstem, (uchar *) tmpnum, strlen(tmpnum), 0);
     }
   } else {
-    rc = set_rexx_variable(errstem, (uchar *) "0", 1, 0);
+    rc2 = set_rexx_variable(errstem, (uchar *) "0", 1, 0);
   }
-  /*
-   * Delete the temporary file(s) and free up any memory.
-   */
-  if (in) {
-    unlink(infile);
-    free(infile);
-  }
-  if (out) {
-    unlink(outfile);
-    free(outfile);
-  }
-  if (err) {
-    if (!out_and_err_same) {
-      unlink(errfile);
-      free(errfile);
-    }
+  if (rc2 != RC_OK) {
+    rc = rc2;
   }
   /*
-   * Return with, hopefully, return code from system() command.
+   * Return with, hopefully, return code from the command.
    */
   if (rc) {
     return (rc + 1000);
@@ -1083,102 +1218,68 @@ static int run_os_command(uchar *cmd, uchar *instem, uchar *outstem, uchar *errs
   }
 }
 
-static uchar *MakeAscii(RXSTRING *rxstring) {
-  uchar *string = NULL;
+static void close_os_pipes(int *in_pipe, int *out_pipe, int *err_pipe) {
+  int i;
 
-  string = (uchar *) malloc((sizeof(uchar) * rxstring->strlength) + 1);
-  if (string != NULL) {
-    memcpy(string, rxstring->strptr, rxstring->strlength);
-    *(string + (rxstring->strlength)) = '\0';
+  for (i = 0; i < 2; i++) {
+    if (in_pipe[i] != (-1)) {
+      close(in_pipe[i]);
+    }
+    if (out_pipe[i] != (-1)) {
+      close(out_pipe[i]);
+    }
+    if (err_pipe[i] != (-1)) {
+      close(err_pipe[i]);
+    }
   }
-  return (string);
 }
 
-static char *get_a_line(FILE *fp, char *string, int *length, int *rcode) {
-  int ch;
-  static int bufs = 1;
-  int i = 0;
+/*
+ * Queue a REXX variable for each complete line in a chunk of command output.
+ * A line split across chunks is held in the capture's line buffer until its end arrives.
+ */
+static short capture_os_output(OS_CAPTURE *capture, char *buffer, long length) {
+  char *eol, *p;
+  long len;
+  short rc = RC_OK;
 
-  /*
-   * Allocate the first block of memory.
-   */
-  if ((string = (char *) malloc(BUF_SIZE + 1)) == NULL) {
-    *rcode = RC_OUT_OF_MEMORY;
-    return (NULL);
-  }
-  for (;;) {
-    /*
-     * Read a character from the stream...
-     */
-    if ((ch = fgetc(fp)) == EOF) {
-      /*
-       * If EOF is reached, check that it really is end of file.
-       */
-      if (feof(fp)) {
-        *length = i;
-        *rcode = RC_TOF_EOF_REACHED;
-        return (string);
+  while (length > 0) {
+    eol = (char *) memchr(buffer, '\n', length);
+    len = eol ? eol - buffer : length;
+    if (eol && capture->length == 0) {
+      rc = queue_rexx_variable(capture->stem, (uchar *) buffer, len, ++capture->lines);
+    } else {
+      if (capture->length + len > capture->size) {
+        capture->size = (capture->length + len) * 2;
+        if ((p = (char *) realloc(capture->line, capture->size)) == NULL) {
+          return (RC_OUT_OF_MEMORY);
+        }
+        capture->line = p;
       }
-    }
-    /*
-     * If end of line is reached, nul terminate string and return.
-     */
-    if ((char) ch == '\n') {
-      *(string + i) = '\0';
-      break;
-    }
-    /*
-     * All other characters, copy to string.
-     */
-    *(string + i++) = (char) ch;
-    /*
-     * If we have got to the end of the allocated memory, realloc some more
-     */
-    if (i == BUF_SIZE * bufs) {
-      if ((string = (char *) realloc(string, (BUF_SIZE * (++bufs)) + 1)) == NULL) {
-        *rcode = RC_OUT_OF_MEMORY;
-        return (NULL);
+      memcpy(capture->line + capture->length, buffer, len);
+      capture->length += len;
+      if (eol) {
+        rc = queue_rexx_variable(capture->stem, (uchar *) capture->line, capture->length, ++capture->lines);
+        capture->length = 0;
       }
     }
+    if (eol) {
+      len++;
+    }
+    buffer += len;
+    length -= len;
   }
-  /*
-   * Return a line read from the temporary file.
-   */
-  *length = i;
-  *rcode = 0;
-  return (string);
+  return (rc);
 }
 
-static short set_rexx_variables_from_file(char *filename, uchar *stem) {
-  FILE *fp = NULL;
-  int i = 0;
-  char *string = NULL;
-  int length = 0, rcode = 0, rc = 0;
-  char tmpnum[15];
+static uchar *MakeAscii(RXSTRING *rxstring) {
+  uchar *string = NULL;
 
-  if ((fp = fopen(filename, "r")) == NULL) {
-    return (RC_ACCESS_DENIED);
-  }
-  for (i = 0;; i++) {
-    string = get_a_line(fp, string, &length, &rcode);
-    if (rcode == RC_OUT_OF_MEMORY) {
-      return (rcode);
-    }
-    if (rcode == RC_TOF_EOF_REACHED && length == 0) {
-      free(string);
-      break;
-    }
-    rc = set_rexx_variable(stem, (uchar *) string, strlen(string), i + 1);
-    free(string);
-    if (rcode == RC_TOF_EOF_REACHED) {
-      break;
-    }
-  }
-  sprintf(tmpnum, "%d", i);
-  rc = set_rexx_variable(stem, (uchar *) tmpnum, strlen(tmpnum), 0);
-  if (fclose(fp)) {
-    rc = RC_ACCESS_DENIED;
+  string = (uchar *) malloc((sizeof(uchar) * rxstring->strlength) + 1);
+  if (string != NULL) {
+    memcpy(string, rxstring->strptr, rxstring->strlength);
+    *(string + (rxstring->strlength)) = '\0';
   }
-  return (rc);
+  return (string);
 }
 
@@ -52,6 +52,17 @@ static void show_lines(uchar);
 static void show_a_line(uchar, short, SHOW_LINE *);
 static void set_prefix_contents(uchar, LINE *, short, long, bool);
 static void show_hex_line(uchar, short);
+static unsigned int sign_bytes(unsigned int, void *, long);
+static unsigned int sign_long(unsigned int, long);
+static void check_parse_environment(uchar);
+static void check_show_environment(uchar);
+static bool row_unchanged(SHOW_LINE *, long);
+static void remember_row(SHOW_LINE *, long);
+static unsigned int parse_signature(SHOW_LINE *);
+static PARSED_LINE *find_parsed_line(uchar, unsigned int, SHOW_LINE *);
+static PARSED_LINE *store_parsed_line(uchar, unsigned int, SHOW_LINE *);
+static bool highlight_screen_ahead(uchar, SHOW_LINE *);
+static void *highlight_ahead(void *);
 static long displayed_max_line_length = 0;      /* max length of displayed line */
 static LINE *hexshow_curr = NULL;       /* module global for historical reasons? */
 
@@ -173,6 +184,441 @@ static void display_line_center(WINDOW *win, chtype colour, uchar *str, int line
   END_LINE_OUTPUT();
 }
 
+/*
+ * Rows are not reparsed when a line was parsed from the same contents in
+ * the same state for any row of the screen, or for the lines around it
+ * while waiting for a key; each screen keeps a pool of such parsed lines.
+ * The pool is looked up by signature and confirmed against a copy of the
+ * contents, and is emptied whenever anything else that parse_line() looks
+ * at has changed. Each row also keeps what was last painted in it, and
+ * rows that would be painted the same again are not repainted.
+ * The signatures are FNV-1a hashes; a signature of 0 is never computed,
+ * so a zeroed one is always redone.
+ */
+#define SIGNATURE_BASIS 2166136261U
+
+static pthread_t ahead_thread;
+static pthread_mutex_t ahead_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool ahead_running = FALSE;
+static bool ahead_stop = FALSE;
+static SHOW_LINE *ahead_line = NULL;
+
+/*
+ * Everything other than the row itself that parse_line() looks at.
+ */
+typedef struct {
+  FILE_DETAILS *file;
+  PARSER_DETAILS *parser;
+  bool colour_support;
+  COLOUR_ATTR attr[ATTR_MAX];
+  COLOUR_ATTR ecolour[ECOLOUR_MAX];
+  long current_syntax_headers;
+  long syntax_headers;
+  long verify_col;
+  ushort cols;
+  uchar pseudo_file;
+} PARSE_ENVIRONMENT;
+
+static PARSE_ENVIRONMENT parse_environments[MAX_SCREENS];
+
+/*
+ * Everything other than the row itself that show_lines() looks at for a
+ * row that is not always repainted.
+ */
+typedef struct {
+  long verify_col;
+  long verify_start;
+  long verify_end;
+  ushort cols;
+  uchar prefix;
+  short prefix_width;
+  short prefix_gap;
+  bool prefix_gap_line;
+  bool tofeof;
+  chtype etmode_table[256];
+  bool etmode_flag[256];
+} SHOW_ENVIRONMENT;
+
+static SHOW_ENVIRONMENT show_environments[MAX_SCREENS];
+
+static unsigned int sign_bytes(unsigned int signature, void *data, long len) {
+  uchar *ptr = (uchar *) data;
+
+  while (len-- > 0) {
+    signature = (signature ^ *ptr++) * 16777619U;
+  }
+  return signature;
+}
+
+static unsigned int sign_long(unsigned int signature, long value) {
+  return sign_bytes(signature, &value, sizeof(value));
+}
+
+/*
+ * Empties the screen's pool of parsed lines if anything other than the
+ * rows themselves that parse_line() looks at has changed since it was
+ * last checked.
+ */
+static void check_parse_environment(uchar scrno) {
+  FILE_DETAILS *screen_file = SCREEN_FILE(scrno);
+  PARSE_ENVIRONMENT environment;
+  short i;
+
+  memset(&environment, 0, sizeof(environment));
+  environment.file = screen_file;
+  environment.parser = screen_file->parser;
+  environment.colour_support = colour_support;
+  memcpy(environment.attr, screen_file->attr, sizeof(environment.attr));
+  memcpy(environment.ecolour, screen_file->ecolour, sizeof(environment.ecolour));
+  environment.current_syntax_headers = CURRENT_VIEW->syntax_headers;
+  environment.syntax_headers = SCREEN_VIEW(scrno)->syntax_headers;
+  environment.verify_col = SCREEN_VIEW(scrno)->verify_col;
+  environment.cols = screen[scrno].cols[WINDOW_FILEAREA];
+  environment.pseudo_file = CURRENT_FILE->pseudo_file;
+  if (memcmp(&environment, parse_environments + scrno, sizeof(environment)) == 0) {
+    return;
+  }
+  parse_environments[scrno] = environment;
+  for (i = 0; i < screen[scrno].num_parsed; i++) {
+    screen[scrno].parsed[i].signature = 0;
+  }
+  return;
+}
+
+/*
+ * Forgets what was painted in each row of the screen if anything other
+ * than the rows themselves that show_lines() looks at has changed since it
+ * was last checked.
+ */
+static void check_show_environment(uchar scrno) {
+  VIEW_DETAILS *screen_view = SCREEN_VIEW(scrno);
+  SHOW_ENVIRONMENT environment;
+  short i;
+
+  memset(&environment, 0, sizeof(environment));
+  environment.verify_col = screen_view->verify_col;
+  environment.verify_start = screen_view->verify_start;
+  environment.verify_end = screen_view->verify_end;
+  environment.cols = screen[scrno].cols[WINDOW_FILEAREA];
+  environment.prefix = screen_view->prefix;
+  environment.prefix_width = screen_view->prefix_width;
+  environment.prefix_gap = screen_view->prefix_gap;
+  environment.prefix_gap_line = screen_view->prefix_gap_line;
+  environment.tofeof = screen_view->tofeof;
+  memcpy(environment.etmode_table, etmode_table, sizeof(environment.etmode_table));
+  memcpy(environment.etmode_flag, etmode_flag, sizeof(environment.etmode_flag));
+  if (memcmp(&environment, show_environments + scrno, sizeof(environment)) == 0) {
+    return;
+  }
+  show_environments[scrno] = environment;
+  for (i = 0; i < screen[scrno].rows[WINDOW_FILEAREA]; i++) {
+    screen[scrno].sl[i].shown.valid = FALSE;
+  }
+  return;
+}
+
+/*
+ * Returns TRUE if the row would be painted just as it was last time.
+ */
+static bool row_unchanged(SHOW_LINE *scurr, long cols) {
+  SHOWN_ROW *shown = &scurr->shown;
+
+  if (!shown->valid
+      || shown->line_type != scurr->line_type
+      || shown->number_lines_excluded != scurr->number_lines_excluded
+      || shown->normal_colour != scurr->normal_colour
+      || shown->other_colour != scurr->other_colour
+      || shown->other_start_col != scurr->other_start_col
+      || shown->other_end_col != scurr->other_end_col
+      || shown->prefix_colour != scurr->prefix_colour
+      || shown->gap_colour != scurr->gap_colour
+      || strcmp((char *) shown->prefix, (char *) scurr->prefix) != 0
+      || shown->highlight != scurr->highlight
+      || shown->is_highlighting != scurr->is_highlighting
+      || shown->length != ((scurr->contents == NULL) ? -1 : scurr->length)) {
+    return (FALSE);
+  }
+  if (scurr->contents && memcmp(shown->contents, scurr->contents, scurr->length) != 0) {
+    return (FALSE);
+  }
+  if (scurr->is_highlighting && memcmp(shown->highlighting, scurr->highlighting, cols * sizeof(chtype)) != 0) {
+    return (FALSE);
+  }
+  return (TRUE);
+}
+
+/*
+ * Keeps what is about to be painted in the row. If there is no memory for
+ * the contents, the row is repainted next time.
+ */
+static void remember_row(SHOW_LINE *scurr, long cols) {
+  SHOWN_ROW *shown = &scurr->shown;
+
+  shown->valid = FALSE;
+  if (scurr->contents && scurr->length > shown->contents_size) {
+    if (shown->contents) {
+      free(shown->contents);
+    }
+    shown->contents_size = 0;
+    if ((shown->contents = (uchar *) malloc(scurr->length)) == NULL) {
+      return;
+    }
+    shown->contents_size = scurr->length;
+  }
+  shown->line_type = scurr->line_type;
+  shown->number_lines_excluded = scurr->number_lines_excluded;
+  shown->normal_colour = scurr->normal_colour;
+  shown->other_colour = scurr->other_colour;
+  shown->other_start_col = scurr->other_start_col;
+  shown->other_end_col = scurr->other_end_col;
+  shown->prefix_colour = scurr->prefix_colour;
+  shown->gap_colour = scurr->gap_colour;
+  strcpy((char *) shown->prefix, (char *) scurr->prefix);
+  shown->highlight = scurr->highlight;
+  shown->is_highlighting = scurr->is_highlighting;
+  shown->length = (scurr->contents == NULL) ? -1 : scurr->length;
+  if (scurr->contents) {
+    memcpy(shown->contents, scurr->contents, scurr->length);
+  }
+  if (scurr->is_highlighting) {
+    memcpy(shown->highlighting, scurr->highlighting, cols * sizeof(chtype));
+  }
+  shown->valid = TRUE;
+  return;
+}
+
+/*
+ * Signs a row's own inputs to parse_line().
+ */
+static unsigned int parse_signature(SHOW_LINE *scurr) {
+  unsigned int signature;
+
+  signature = sign_bytes(SIGNATURE_BASIS, scurr->contents, scurr->length);
+  signature = sign_long(signature, scurr->length);
+  signature = sign_long(signature, scurr->is_current_line);
+  signature = sign_long(signature, scurr->is_cursor_line && scurr->is_cursor_line_filearea_different);
+  return (signature == 0) ? 1 : signature;
+}
+
+static PARSED_LINE *find_parsed_line(uchar scrno, unsigned int signature, SHOW_LINE *scurr) {
+  PARSED_LINE *parsed;
+  bool is_cursor_line = (scurr->is_cursor_line && scurr->is_cursor_line_filearea_different);
+  short i;
+
+  for (i = 0, parsed = screen[scrno].parsed; i < screen[scrno].num_parsed; i++, parsed++) {
+    if (parsed->signature == signature
+        && parsed->length == scurr->length
+        && parsed->is_current_line == scurr->is_current_line
+        && parsed->is_cursor_line == is_cursor_line
+        && memcmp(parsed->contents, scurr->contents, scurr->length) == 0) {
+      return (parsed);
+    }
+  }
+  return (NULL);
+}
+
+/*
+ * Keeps what parse_line() left in scurr, in place of the parsed line used
+ * least recently. Lines used in the current display are never replaced.
+ * Returns NULL if there is no room or no memory.
+ */
+static PARSED_LINE *store_parsed_line(uchar scrno, unsigned int signature, SHOW_LINE *scurr) {
+  PARSED_LINE *parsed = NULL, *curr;
+  unsigned int displays = screen[scrno].displays;
+  short i;
+
+  if (screen[scrno].parsed == NULL) {
+    i = screen[scrno].rows[WINDOW_FILEAREA] * (2 + 2 * HIGHLIGHT_AHEAD_PAGES);
+    if ((screen[scrno].parsed = (PARSED_LINE *) calloc(i, sizeof(PARSED_LINE))) == NULL) {
+      return (NULL);
+    }
+    screen[scrno].num_parsed = i;
+  }
+  for (i = 0, curr = screen[scrno].parsed; i < screen[scrno].num_parsed; i++, curr++) {
+    if (curr->signature == 0) {
+      parsed = curr;
+      break;
+    }
+    if (curr->used != displays && (parsed == NULL || displays - curr->used > displays - parsed->used)) {
+      parsed = curr;
+    }
+  }
+  if (parsed == NULL) {
+    return (NULL);
+  }
+  parsed->signature = 0;
+  if (parsed->highlighting == NULL) {
+    if ((parsed->highlighting = (chtype *) malloc(sizeof(scurr->highlighting))) == NULL) {
+      return (NULL);
+    }
+  }
+  if (parsed->highlight_type) {
+    free(parsed->highlight_type);
+  }
+  if ((parsed->highlight_type = (unsigned char *) malloc(scurr->length)) == NULL) {
+    return (NULL);
+  }
+  if (parsed->contents) {
+    free(parsed->contents);
+  }
+  if ((parsed->contents = (uchar *) malloc(scurr->length)) == NULL) {
+    return (NULL);
+  }
+  memcpy(parsed->highlighting, scurr->highlighting, sizeof(scurr->highlighting));
+  memcpy(parsed->highlight_type, scurr->highlight_type, scurr->length);
+  memcpy(parsed->contents, scurr->contents, scurr->length);
+  parsed->length = scurr->length;
+  parsed->is_current_line = scurr->is_current_line;
+  parsed->is_cursor_line = (scurr->is_cursor_line && scurr->is_cursor_line_filearea_different);
+  parsed->signature = signature;
+  parsed->used = displays;
+  return (parsed);
+}
+
+void free_parsed_lines(uchar scrno) {
+  short i;
+
+  for (i = 0; i < screen[scrno].num_parsed; i++) {
+    if (screen[scrno].parsed[i].highlighting) {
+      free(screen[scrno].parsed[i].highlighting);
+    }
+    if (screen[scrno].parsed[i].highlight_type) {
+      free(screen[scrno].parsed[i].highlight_type);
+    }
+    if (screen[scrno].parsed[i].contents) {
+      free(screen[scrno].parsed[i].contents);
+    }
+  }
+  if (screen[scrno].parsed) {
+    free(screen[scrno].parsed);
+  }
+  screen[scrno].parsed = NULL;
+  screen[scrno].num_parsed = 0;
+  return;
+}
+
+/*
+ * Parses the lines within HIGHLIGHT_AHEAD_PAGES screens above and below
+ * the screen that are not already parsed, as they would be displayed
+ * away from the current and cursor lines.
+ * Returns FALSE if asked to stop.
+ */
+static bool highlight_screen_ahead(uchar scrno, SHOW_LINE *scurr) {
+  FILE_DETAILS *screen_file = SCREEN_FILE(scrno);
+  VIEW_DETAILS *screen_view = SCREEN_VIEW(scrno);
+  PARSED_LINE *parsed;
+  LINE *curr;
+  long first_line = -1L, last_line = -1L;
+  unsigned int signature;
+  short i, pass, direction;
+  long count;
+  bool stop;
+
+  if (screen[scrno].sl == NULL || !screen_file->colouring || screen_file->parser == NULL) {
+    return (TRUE);
+  }
+  for (i = 0; i < screen[scrno].rows[WINDOW_FILEAREA]; i++) {
+    if (screen[scrno].sl[i].line_type == LINE_LINE || screen[scrno].sl[i].line_type == LINE_TOF || screen[scrno].sl[i].line_type == LINE_EOF) {
+      if (first_line == -1L) {
+        first_line = screen[scrno].sl[i].line_number;
+      }
+      last_line = screen[scrno].sl[i].line_number;
+    }
+  }
+  if (first_line == -1L) {
+    return (TRUE);
+  }
+  check_parse_environment(scrno);
+  for (pass = 0; pass < 2; pass++) {
+    direction = (pass == 0) ? DIRECTION_FORWARD : DIRECTION_BACKWARD;
+    /*
+     * Lines are found by number, in case the rows are out of date.
+     */
+    curr = lll_find(screen_file->first_line, screen_file->last_line, (direction == DIRECTION_FORWARD) ? last_line + 1 : first_line - 1, screen_file->number_lines);
+    count = screen[scrno].rows[WINDOW_FILEAREA] * HIGHLIGHT_AHEAD_PAGES;
+    for (; curr != NULL && curr->prev != NULL && curr->next != NULL && count > 0; curr = (direction == DIRECTION_FORWARD) ? curr->next : curr->prev) {
+      if (!IN_SCOPE(screen_view, curr)) {
+        continue;
+      }
+      count--;
+      pthread_mutex_lock(&ahead_mutex);
+      stop = ahead_stop;
+      pthread_mutex_unlock(&ahead_mutex);
+      if (stop) {
+        return (FALSE);
+      }
+      if (curr->length == 0) {
+        continue;
+      }
+      scurr->contents = curr->line;
+      scurr->length = curr->length;
+      signature = parse_signature(scurr);
+      if ((parsed = find_parsed_line(scrno, signature, scurr)) != NULL) {
+        parsed->used = screen[scrno].displays;
+        continue;
+      }
+      if (scurr->highlight_type) {
+        free(scurr->highlight_type);
+      }
+      if ((scurr->highlight_type = (unsigned char *) malloc(scurr->length)) == NULL) {
+        return (TRUE);
+      }
+      memset(scurr->highlight_type, THE_SYNTAX_NONE, scurr->length);
+      parse_line(scrno, screen_file, scurr, 0);
+      if (store_parsed_line(scrno, signature, scurr) == NULL) {
+        return (TRUE);
+      }
+    }
+  }
+  return (TRUE);
+}
+
+static void *highlight_ahead(void *arg) {
+  SHOW_LINE *scurr = (SHOW_LINE *) arg;
+  short i;
+
+  for (i = 0; i < display_screens; i++) {
+    if (!highlight_screen_ahead((uchar) i, scurr)) {
+      break;
+    }
+  }
+  return (NULL);
+}
+
+/*
+ * Called just before waiting for a key. The lines around each screen are
+ * parsed in the background while nothing else can change them, until
+ * complete_highlighting_ahead() is called as soon as the key arrives.
+ */
+void start_highlighting_ahead(void) {
+  if (ahead_running || batch_only || !curses_started) {
+    return;
+  }
+  if (ahead_line == NULL) {
+    if ((ahead_line = (SHOW_LINE *) calloc(1, sizeof(SHOW_LINE))) == NULL) {
+      return;
+    }
+  }
+  ahead_stop = FALSE;
+  if (pthread_create(&ahead_thread, NULL, highlight_ahead, ahead_line) != 0) {
+    return;
+  }
+  ahead_running = TRUE;
+  return;
+}
+
+void complete_highlighting_ahead(void) {
+  if (!ahead_running) {
+    return;
+  }
+  pthread_mutex_lock(&ahead_mutex);
+  ahead_stop = TRUE;
+  pthread_mutex_unlock(&ahead_mutex);
+  pthread_join(ahead_thread, NULL);
+  ahead_running = FALSE;
+  return;
+}
+
 /* real stuff */
 
 void prepare_idline(uchar scrno) {
@@ -187,6 +633,7 @@ void prepare_idline(uchar scrno) {
   FILE_DETAILS *screen_file = SCREEN_FILE(scrno);
   int buflen;
   char *pos_string = NULL;
+  uchar size[30];
 
   /*
    * Determine content of window title. This can be display whether IDLINE is ON or OFF
@@ -223,6 +670,10 @@ void prepare_idline(uchar scrno) {
   if (screen_view->position_status) {
     pos_string = get_current_position(scrno, &line_number, &x);
   }
+  /*
+   * A file still being read shows the lines read so far, followed by "+".
+   */
+  sprintf((char *) size, (screen_file->lazy_load) ? "%lu+" : "%lu", screen_file->number_lines);
   /*
    * Set up buffer for line,col,size and alt values for vertical screens.
    */
@@ -230,47 +681,47 @@ void prepare_idline(uchar scrno) {
     if (screen_view->position_status) {
       switch (compatible_look) {
         case COMPAT_XEDIT:
-          sprintf((char *) buffer, "S=%lu L=%lu C=%lu A=%u,%u", screen_file->number_lines, line_number, x, screen_file->autosave_alt, screen_file->save_alt);
+          sprintf((char *) buffer, "S=%s L=%lu C=%lu A=%u,%u", size, line_number, x, screen_file->autosave_alt, screen_file->save_alt);
           break;
         case COMPAT_ISPF:
           if (pos_string == NULL) {
-            sprintf((char *) buffer, "S=%lu L=%lu C=%lu A=%u,%u", screen_file->number_lines, line_number, x, screen_file->autosave_alt, screen_file->save_alt);
+            sprintf((char *) buffer, "S=%s L=%lu C=%lu A=%u,%u", size, line_number, x, screen_file->autosave_alt, screen_file->save_alt);
           } else {
-            sprintf((char *) buffer, "S=%lu L=%s C=%lu A=%u,%u", screen_file->number_lines, pos_string, x, screen_file->autosave_alt, screen_file->save_alt);
+            sprintf((char *) buffer, "S=%s L=%s C=%lu A=%u,%u", size, pos_string, x, screen_file->autosave_alt, screen_file->save_alt);
           }
           break;
         default:
-          sprintf((char *) buffer, "L=%lu C=%lu S=%lu A=%u,%u", line_number, x, screen_file->number_lines, screen_file->autosave_alt, screen_file->save_alt);
+          sprintf((char *) buffer, "L=%lu C=%lu S=%s A=%u,%u", line_number, x, size, screen_file->autosave_alt, screen_file->save_alt);
           break;
       }
     } else {
-      sprintf((char *) buffer, "S=%lu A=%u,%u", screen_file->number_lines, screen_file->autosave_alt, screen_file->save_alt);
+      sprintf((char *) buffer, "S=%s A=%u,%u", size, screen_file->autosave_alt, screen_file->save_alt);
     }
     max_name = max(0, (screen[scrno].screen_cols - 1) - strlen((char *) buffer));
   } else {
     if (screen_view->position_status) {
       switch (compatible_look) {
         case COMPAT_XEDIT:
-          sprintf((char *) buffer, "Size=%-6lu Line=%-6lu Col=%-3lu Alt=%u,%u", screen_file->number_lines, line_number, x, screen_file->autosave_alt, screen_file->save_alt);
+          sprintf((char *) buffer, "Size=%-6s Line=%-6lu Col=%-3lu Alt=%u,%u", size, line_number, x, screen_file->autosave_alt, screen_file->save_alt);
           break;
         case COMPAT_ISPF:
           if (pos_string == NULL) {
-            sprintf((char *) buffer, "Size=%-6lu Line=%-6lu Col=%-3lu Alt=%u,%u", screen_file->number_lines, line_number, x, screen_file->autosave_alt, screen_file->save_alt);
+            sprintf((char *) buffer, "Size=%-6s Line=%-6lu Col=%-3lu Alt=%u,%u", size, line_number, x, screen_file->autosave_alt, screen_file->save_alt);
           } else {
-            sprintf((char *) buffer, "Size=%-6lu Line=%s Col=%-3lu Alt=%u,%u", screen_file->number_lines, pos_string, x, screen_file->autosave_alt, screen_file->save_alt);
+            sprintf((char *) buffer, "Size=%-6s Line=%s Col=%-3lu Alt=%u,%u", size, pos_string, x, screen_file->autosave_alt, screen_file->save_alt);
           }
           break;
         default:
-          sprintf((char *) buffer, "Line=%-6lu Col=%-4lu Size=%-5lu Alt=%u,%u", line_number, x, screen_file->number_lines, screen_file->autosave_alt, screen_file->save_alt);
+          sprintf((char *) buffer, "Line=%-6lu Col=%-4lu Size=%-5s Alt=%u,%u", line_number, x, size, screen_file->autosave_alt, screen_file->save_alt);
           break;
       }
       max_name = max(0, (screen[scrno].screen_cols - 47));
     } else {
       if (compatible_look == COMPAT_XEDIT) { /* speed up */
-        sprintf((char *) buffer, "Size=%-9lu%sAlt=%u,%u", screen_file->number_lines, "                  ", screen_file->autosave_alt, screen_file->save_alt);
+        sprintf((char *) buffer, "Size=%-9s%sAlt=%u,%u", size, "                  ", screen_file->autosave_alt, screen_file->save_alt);
         max_name = max(0, (screen[scrno].screen_cols - 47));
       } else {
-        sprintf((char *) buffer, "Size=%-5lu Alt=%u,%u", screen_file->number_lines, screen_file->autosave_alt, screen_file->save_alt);
+        sprintf((char *) buffer, "Size=%-5s Alt=%u,%u", size, screen_file->autosave_alt, screen_file->save_alt);
         max_name = max(0, (screen[scrno].screen_cols - 26));
       }
     }
@@ -531,6 +982,11 @@ void build_screen(uchar scrno) {
   short crow = SCREEN_VIEW(scrno)->current_row;
   long cline = SCREEN_VIEW(scrno)->current_line;
 
+  /*
+   * If the file is still being read, it needs only the lines down to the
+   * bottom of the window.
+   */
+  load_file_lines(SCREEN_FILE(scrno), cline + screen[scrno].rows[WINDOW_FILEAREA]);
   hexshow_curr = save_curr = curr = lll_find(SCREEN_FILE(scrno)->first_line, SCREEN_FILE(scrno)->last_line, cline, SCREEN_FILE(scrno)->number_lines);
   displayed_max_line_length = 0;
   /*
@@ -593,6 +1049,7 @@ void display_screen(uchar scrno) {
    * Display the built lines...
    */
   crow = SCREEN_VIEW(scrno)->current_row;
+  screen[scrno].displays++;
   build_lines_for_display(scrno, DIRECTION_FORWARD, (short) (screen[scrno].rows[WINDOW_FILEAREA] - crow), crow);
   build_lines_for_display(scrno, DIRECTION_BACKWARD, crow, (short) (crow - 1));
   /*
@@ -1002,6 +1459,8 @@ static void build_lines_for_display(uchar scrno, short direction, short rows, sh
   long mark_end_line = 0L;
   long mark_start_col = 0;
   long mark_end_col = 0;
+  unsigned int signature;
+  PARSED_LINE *parsed;
 
   /*
    * Determine the row that is the focus line.
@@ -1026,6 +1485,9 @@ static void build_lines_for_display(uchar scrno, short direction, short rows, sh
   attr_cursor = set_colour(screen_file->attr + ATTR_CURSORLINE);
   gap = screen_view->prefix_gap;
   widthnogap = screen_view->prefix_width - gap;
+  if (screen_file->colouring && screen_file->parser) {
+    check_parse_environment(scrno);
+  }
   /*
    * Now, for each row to be displayed...
    */
@@ -1381,7 +1843,20 @@ static void build_lines_for_display(uchar scrno, short direction, short rows, sh
      * build the colours in the highlighting array based on the line's contents.
      */
     if (line_parseable && SCREEN_FILE(scrno)->colouring && SCREEN_FILE(scrno)->parser && scurr->length > 0) {
-      parse_line(scrno, SCREEN_FILE(scrno), scurr, start_row);  /* test for error return */
+      /*
+       * If the line was parsed from the same contents in the same state, reuse what parse_line() left then.
+       */
+      signature = parse_signature(scurr);
+      if (scurr->highlight_type && (parsed = find_parsed_line(scrno, signature, scurr)) != NULL) {
+        memcpy(scurr->highlighting, parsed->highlighting, sizeof(scurr->highlighting));
+        memcpy(scurr->highlight_type, parsed->highlight_type, scurr->length);
+        parsed->used = screen[scrno].displays;
+      } else {
+        parse_line(scrno, SCREEN_FILE(scrno), scurr, start_row);        /* test for error return */
+        if (scurr->highlight_type) {
+          store_parsed_line(scrno, signature, scurr);
+        }
+      }
       scurr->is_highlighting = TRUE;
     }
     start_row += direction;
@@ -1405,8 +1880,29 @@ static void show_lines(uchar scrno) {
   char buffer[60];
   uchar *ptr;
   SHOW_LINE *scurr = screen[scrno].sl;
+  short filearea_row = getcury(screen_window_filearea);
+  short prefix_row = (SCREEN_WINDOW_PREFIX(scrno) != NULL) ? getcury(SCREEN_WINDOW_PREFIX(scrno)) : -1;
+  long cols = min(filearea_cols, THE_MAX_SCREEN_WIDTH);
+  bool always;
 
+  check_show_environment(scrno);
   for (i = 0, scurr = screen[scrno].sl; i < screen[scrno].rows[WINDOW_FILEAREA]; i++, scurr++) {
+    /*
+     * Leave the row alone if it would be painted just as it was last time.
+     * Reserved, scale, tabline and hexshow rows and the row with the target highlighted are always repainted,
+     * as are the rows with the cursor in them, which may have been written to directly while editing.
+     */
+    always = (i == filearea_row || i == prefix_row || scurr->line_type & (LINE_RESERVED | LINE_SCALE | LINE_TABLINE | LINE_HEXSHOW));
+    if (SCREEN_VIEW(scrno)->thighlight_on && SCREEN_VIEW(scrno)->thighlight_active && SCREEN_VIEW(scrno)->thighlight_target.true_line == scurr->line_number) {
+      always = TRUE;
+    }
+    if (always) {
+      scurr->shown.valid = FALSE;
+    } else if (row_unchanged(scurr, cols)) {
+      continue;
+    } else {
+      remember_row(scurr, cols);
+    }
     /*
      * Display the contents of the prefix area (if on).
      */
@@ -1762,9 +2258,9 @@ static void set_prefix_contents(uchar scrno, LINE *curr, short start_row, long c
     scurr = screen[scrno].sl + start_row;
     ptr = scurr->prefix;
     width = screen_view->prefix_width - screen_view->prefix_gap;
-    if (curr->pre != NULL) {    /* prefix command pending... */
+    if (LINE_PRE(curr) != NULL) {       /* prefix command pending... */
       // && !blank_field(curr->pre->ppc_command)) /* ... and not blank */
-      strcpy((char *) ptr, (char *) curr->pre->ppc_orig_command);
+      strcpy((char *) ptr, (char *) LINE_PRE(curr)->ppc_orig_command);
       scurr->prefix_colour = set_colour(screen_file->attr + ATTR_PENDING);
     } else {                    /* no prefix command on this line */
       scurr->prefix_colour = (is_current) ? set_colour(screen_file->attr + ATTR_CPREFIX) : set_colour(screen_file->attr + ATTR_PREFIX);
@@ -1920,6 +2416,26 @@ void redraw_screen(uchar scrno) {
   return;
 }
 
+/*
+ * Forgets the lines parsed for the screen and what was painted in each of
+ * its rows, so that the next display_screen() does all rows again. Needed
+ * when the windows are recreated or a parser goes away.
+ */
+void invalidate_screen_rows(uchar scrno) {
+  short i;
+
+  for (i = 0; i < screen[scrno].num_parsed; i++) {
+    screen[scrno].parsed[i].signature = 0;
+  }
+  if (screen[scrno].sl == NULL) {
+    return;
+  }
+  for (i = 0; i < screen[scrno].rows[WINDOW_FILEAREA]; i++) {
+    screen[scrno].sl[i].shown.valid = FALSE;
+  }
+  return;
+}
+
 bool line_in_view(uchar scrno, long line_number) {
   short i, max = screen[scrno].rows[WINDOW_FILEAREA];
   bool result = FALSE;
@@ -6,6 +6,16 @@
 #include "proto.h"
 
 #define MAX_SORT_FIELDS 1000
+#define SORT_KEY_LENGTH          16  /* bytes of each line's sort key compared directly */
+#define SORT_INSERTION_LENGTH    16  /* lines sorted by insertion before merging */
+#define SORT_THREAD_MINIMUM   65536  /* lines for each thread making and sorting keys */
+#define SORT_BUFFER_KEYS       4096  /* keys written or read at a time for a temporary file */
+#define SORT_MAX_RUNS           256  /* most sorted runs merged at once */
+#define SORT_HASH_MINIMUM      1024  /* initial size of the table of unique lines */
+
+#define SORT_LINES       0
+#define SORT_UNIQUE      1
+#define SORT_COUNT       2
 
 #define SF_ERROR    0
 #define SF_START    1
@@ -19,94 +29,625 @@ struct sort_field {
 };
 typedef struct sort_field SORT_FIELD;
 
-uchar *sort_field_1;
-uchar *sort_field_2;
+/*
+ * The leading bytes of a line's sort fields, in the form compared:
+ * blank past the end of the line, folded to uppercase if CASE IGNORE,
+ * nul after a nul (as strncmp() stops there) and complemented if DESCENDING,
+ * so that memcmp() orders keys as the fields would be ordered.
+ */
+struct sort_key {
+  uchar key[SORT_KEY_LENGTH];
+  LINE *line;
+};
+typedef struct sort_key SORT_KEY;
+
+/*
+ * A sorted run of keys being merged: either a part of the keys sorted in
+ * memory, or a run written to a temporary file and read back a buffer at a time.
+ */
+struct sort_run {
+  SORT_KEY *keys;               /* sorted keys, or buffer of keys read from fd */
+  long next;                    /* next key in keys to merge */
+  long count;                   /* number of keys in keys */
+  long left;                    /* number of keys still to be read from fd */
+  int fd;                       /* temporary file holding run, or -1 */
+  LINE **lines;                 /* lines whose keys are sorted into keys */
+  SORT_KEY *work;               /* room for sorting keys */
+  pthread_t thread;
+};
+typedef struct sort_run SORT_RUN;
+
+/*
+ * A line kept by SORT UNIQUE or COUNT, and the hash of its sort fields.
+ */
+struct sort_hash {
+  unsigned long hash;
+  LINE *line;
+};
+typedef struct sort_hash SORT_HASH;
+
+/*
+ * A line sorted and its index among the lines before they were sorted.
+ */
+struct sort_origin {
+  LINE *line;
+  long index;
+};
+typedef struct sort_origin SORT_ORIGIN;
 
 SORT_FIELD sort_fields[MAX_SORT_FIELDS];
 
 short num_fields;
 
-static int cmp(const void *, const void *);
+static uchar sort_fold[256];
+static long sort_key_width;
 
-static int cmp(const void *first, const void *second) {
-  long i = 0, j = 0;
-  short rc = RC_OK;
-  long len = 0;
-  long right_col = 0, left_col = 0;
-  LINE *one = *(LINE **) first;
-  LINE *two = *(LINE **) second;
+static void make_sort_key(SORT_KEY *);
+static int compare_lines(LINE *, LINE *);
+static int compare_sort_keys(SORT_KEY *, SORT_KEY *);
+static void sort_keys(SORT_KEY *, SORT_KEY *, long);
+static void *sort_run(void *);
+static void sort_runs(SORT_KEY *, SORT_KEY *, LINE **, long, SORT_RUN *, int);
+static short write_sort_keys(int, SORT_KEY *, long);
+static short read_sort_keys(SORT_RUN *);
+static bool sort_run_before(SORT_RUN *, int, int);
+static short merge_runs(SORT_RUN *, int, LINE **, int, SORT_KEY *);
+static short sort_lines(LINE **, long);
+static unsigned long hash_sort_fields(LINE *);
+static short remove_duplicate_lines(LINE *, long, long, bool, short);
+static int compare_sort_origins(const void *, const void *);
+static void journal_sort(LINE **, LINE **, long *, long, short);
+
+static void make_sort_key(SORT_KEY *sk) {
+  LINE *curr = sk->line;
+  long i, col, k = 0;
+  uchar ch;
+  bool nul;
+
+  for (i = 0; i < num_fields && k < SORT_KEY_LENGTH; i++) {
+    nul = FALSE;
+    for (col = sort_fields[i].left_col - 1; col < sort_fields[i].right_col && k < SORT_KEY_LENGTH; col++) {
+      ch = (nul) ? 0 : (col < curr->length) ? sort_fold[curr->line[col]] : ' ';
+      nul = (ch == 0);
+      sk->key[k++] = (sort_fields[i].order == 'A') ? ch : (uchar) ~ch;
+    }
+  }
+  if (k < SORT_KEY_LENGTH) {
+    memset(sk->key + k, 0, SORT_KEY_LENGTH - k);
+  }
+}
+
+/*
+ * Compares the sort fields of two lines in full, without copying them.
+ */
+static int compare_lines(LINE *one, LINE *two) {
+  long i, col, last;
+  uchar ch1, ch2;
 
-  /*
-   * For each sort field defined in the array sort_fields,
-   * compare the value of both lines for the specified column range.
-   */
   for (i = 0; i < num_fields; i++) {
     /*
-     * Calculate the length of the sort field.
-     */
-    len = sort_fields[i].right_col - sort_fields[i].left_col + 1;
-    /*
-     * Set the two temporary fields to blanks.
-     */
-    memset(sort_field_1, ' ', len);
-    memset(sort_field_2, ' ', len);
-    /*
-     * For the first line to be compared,
-     * extract the portion of the line that corresponds with the current sort column...
+     * Past the end of both lines, the fields are equally blank.
      */
-    right_col = min(sort_fields[i].right_col, one->length);
-    left_col = min(sort_fields[i].left_col, one->length);
-    /*
-     * If the sort column lies after the end of the line,
-     * leave the contents of the sort field blank.
-     */
-    if (sort_fields[i].left_col <= one->length) {
-      memcpy(sort_field_1, one->line + left_col - 1, right_col - left_col + 1);
+    last = min(sort_fields[i].right_col, max(one->length, two->length));
+    for (col = sort_fields[i].left_col - 1; col < last; col++) {
+      ch1 = (col < one->length) ? sort_fold[one->line[col]] : ' ';
+      ch2 = (col < two->length) ? sort_fold[two->line[col]] : ' ';
+      if (ch1 != ch2) {
+        return ((sort_fields[i].order == 'A') ? ch1 - ch2 : ch2 - ch1);
+      }
+      if (ch1 == 0) {
+        break;
+      }
+    }
+  }
+  return (0);
+}
+
+static int compare_sort_keys(SORT_KEY *one, SORT_KEY *two) {
+  int rc;
+
+  if ((rc = memcmp(one->key, two->key, SORT_KEY_LENGTH)) != 0 || sort_key_width <= SORT_KEY_LENGTH) {
+    return (rc);
+  }
+  return (compare_lines(one->line, two->line));
+}
+
+/*
+ * A stable merge sort; work must have room for half of the keys.
+ */
+static void sort_keys(SORT_KEY *keys, SORT_KEY *work, long num) {
+  SORT_KEY sk;
+  long half, i, j, k;
+
+  if (num <= SORT_INSERTION_LENGTH) {
+    for (i = 1; i < num; i++) {
+      sk = keys[i];
+      for (j = i; j > 0 && compare_sort_keys(&keys[j - 1], &sk) > 0; j--) {
+        keys[j] = keys[j - 1];
+      }
+      keys[j] = sk;
+    }
+    return;
+  }
+  half = num / 2;
+  sort_keys(keys, work, half);
+  sort_keys(keys + half, work, num - half);
+  if (compare_sort_keys(&keys[half - 1], &keys[half]) <= 0) {
+    return;
+  }
+  memcpy(work, keys, half * sizeof(SORT_KEY));
+  for (i = 0, j = half, k = 0; i < half && j < num;) {
+    if (compare_sort_keys(&keys[j], &work[i]) < 0) {
+      keys[k++] = keys[j++];
+    } else {
+      keys[k++] = work[i++];
+    }
+  }
+  memcpy(keys + k, work + i, (half - i) * sizeof(SORT_KEY));
+}
+
+static void *sort_run(void *arg) {
+  SORT_RUN *run = (SORT_RUN *) arg;
+  long i;
+
+  for (i = 0; i < run->count; i++) {
+    run->keys[i].line = run->lines[i];
+    make_sort_key(&run->keys[i]);
+  }
+  sort_keys(run->keys, run->work, run->count);
+  return (NULL);
+}
+
+/*
+ * Makes and sorts the keys of num lines as threads runs, each on its own
+ * thread; work must have room for num / 2 + threads + 1 keys.
+ */
+static void sort_runs(SORT_KEY *keys, SORT_KEY *work, LINE **lines, long num, SORT_RUN *runs, int threads) {
+  long start;
+  int i;
+
+  for (i = 0; i < threads; i++) {
+    start = num * i / threads;
+    runs[i].keys = keys + start;
+    runs[i].next = 0;
+    runs[i].count = (num * (i + 1) / threads) - start;
+    runs[i].left = 0;
+    runs[i].fd = (-1);
+    runs[i].lines = lines + start;
+    runs[i].work = work + (start / 2) + i;
+  }
+  for (i = 1; i < threads; i++) {
+    if (pthread_create(&runs[i].thread, NULL, sort_run, &runs[i]) != 0) {
+      runs[i].thread = pthread_self();
+      sort_run(&runs[i]);
+    }
+  }
+  sort_run(&runs[0]);
+  for (i = 1; i < threads; i++) {
+    if (!pthread_equal(runs[i].thread, pthread_self())) {
+      pthread_join(runs[i].thread, NULL);
+    }
+  }
+}
+
+static short write_sort_keys(int fd, SORT_KEY *keys, long num) {
+  char *buf = (char *) keys;
+  long len = num * sizeof(SORT_KEY);
+  ssize_t done;
+
+  while (len > 0) {
+    if ((done = write(fd, buf, len)) == (-1)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      display_error(57, (uchar *) "", FALSE);
+      return (RC_DISK_FULL);
+    }
+    buf += done;
+    len -= done;
+  }
+  return (RC_OK);
+}
+
+static short read_sort_keys(SORT_RUN *run) {
+  char *buf = (char *) run->keys;
+  long num = min(run->left, SORT_BUFFER_KEYS);
+  long len = num * sizeof(SORT_KEY);
+  ssize_t done;
+
+  while (len > 0) {
+    if ((done = read(run->fd, buf, len)) <= 0) {
+      if (done == (-1) && errno == EINTR) {
+        continue;
+      }
+      display_error(8, (uchar *) "", FALSE);
+      return (RC_IO_ERROR);
+    }
+    buf += done;
+    len -= done;
+  }
+  run->next = 0;
+  run->count = num;
+  run->left -= num;
+  return (RC_OK);
+}
+
+/*
+ * Orders the runs in the merge heap; a tie goes to the earlier run, so that
+ * lines with equal fields stay in order.
+ */
+static bool sort_run_before(SORT_RUN *runs, int one, int two) {
+  int rc = compare_sort_keys(&runs[one].keys[runs[one].next], &runs[two].keys[runs[two].next]);
+
+  return ((rc < 0 || (rc == 0 && one < two)) ? TRUE : FALSE);
+}
+
+/*
+ * Merges the runs, storing the lines in order in lines if it is not NULL,
+ * otherwise writing the keys in order to fd through the buffer out.
+ */
+static short merge_runs(SORT_RUN *runs, int num_runs, LINE **lines, int fd, SORT_KEY *out) {
+  int heap[SORT_MAX_RUNS];
+  int size = 0, i, child, run;
+  long num_out = 0;
+  short rc = RC_OK;
+
+  for (i = 0; i < num_runs; i++) {
+    if (runs[i].next == runs[i].count && runs[i].left > 0 && (rc = read_sort_keys(&runs[i])) != RC_OK) {
+      return (rc);
+    }
+    if (runs[i].next < runs[i].count) {
+      /*
+       * Sift the run up into the heap.
+       */
+      for (child = size++; child > 0 && sort_run_before(runs, i, heap[(child - 1) / 2]); child = (child - 1) / 2) {
+        heap[child] = heap[(child - 1) / 2];
+      }
+      heap[child] = i;
+    }
+  }
+  while (size > 0) {
+    run = heap[0];
+    if (lines) {
+      *lines++ = runs[run].keys[runs[run].next].line;
+    } else {
+      out[num_out++] = runs[run].keys[runs[run].next];
+      if (num_out == SORT_BUFFER_KEYS) {
+        if ((rc = write_sort_keys(fd, out, num_out)) != RC_OK) {
+          return (rc);
+        }
+        num_out = 0;
+      }
+    }
+    if (++runs[run].next == runs[run].count) {
+      if (runs[run].left > 0) {
+        if ((rc = read_sort_keys(&runs[run])) != RC_OK) {
+          return (rc);
+        }
+      } else {
+        run = heap[--size];
+      }
     }
     /*
-     * For the next line to be compared,
-     * extract the portion of the line that corresponds with the current sort column...
-     */
-    right_col = min(sort_fields[i].right_col, two->length);
-    left_col = min(sort_fields[i].left_col, two->length);
-    /*
-     * If the sort column lies after the end of the line,
-     * leave the contents of the sort field blank.
+     * Sift the run down from the top of the heap.
      */
-    if (sort_fields[i].left_col <= two->length) {
-      memcpy(sort_field_2, two->line + left_col - 1, right_col - left_col + 1);
+    for (i = 0; (child = (i * 2) + 1) < size; i = child) {
+      if (child + 1 < size && sort_run_before(runs, heap[child + 1], heap[child])) {
+        child++;
+      }
+      if (!sort_run_before(runs, heap[child], run)) {
+        break;
+      }
+      heap[i] = heap[child];
+    }
+    if (size > 0) {
+      heap[i] = run;
+    }
+  }
+  if (num_out) {
+    rc = write_sort_keys(fd, out, num_out);
+  }
+  return (rc);
+}
+
+/*
+ * Sorts the lines on the sort fields, keeping lines with equal fields in order.
+ * The leading bytes of each line's fields are extracted once; the rest are
+ * only compared when those are equal.
+ * The keys are sorted in runs, one for each of up to load_threads threads,
+ * which are then merged. If the keys take more than sort_memory, each part of
+ * the lines that fits is sorted that way and written to a temporary file,
+ * and the files are merged.
+ */
+static short sort_lines(LINE **lines, long num) {
+  SORT_KEY *keys = NULL, *work = NULL, *out = NULL;
+  SORT_RUN runs[MAX_LOAD_THREADS];
+  SORT_RUN *file_runs = NULL;
+  long run_length = num, start, count, i;
+  int threads, num_file_runs = 0;
+  char *filename;
+  short rc = RC_OK;
+
+  if (sort_memory > 0) {
+    run_length = max(SORT_BUFFER_KEYS, sort_memory / (sizeof(SORT_KEY) + (sizeof(SORT_KEY) / 2)));
+    run_length = min(num, max(run_length, (num + SORT_MAX_RUNS - 1) / SORT_MAX_RUNS));
+  }
+  threads = max(1, min(load_threads, run_length / SORT_THREAD_MINIMUM));
+  keys = (SORT_KEY *) malloc(run_length * sizeof(SORT_KEY));
+  work = (SORT_KEY *) malloc(((run_length / 2) + threads + 1) * sizeof(SORT_KEY));
+  if (run_length < num) {
+    num_file_runs = (num + run_length - 1) / run_length;
+    file_runs = (SORT_RUN *) calloc(num_file_runs, sizeof(SORT_RUN));
+    out = (SORT_KEY *) malloc(SORT_BUFFER_KEYS * sizeof(SORT_KEY));
+    for (i = 0; file_runs != NULL && i < num_file_runs; i++) {
+      file_runs[i].fd = (-1);
+    }
+  }
+  if (keys == NULL || work == NULL || (run_length < num && (file_runs == NULL || out == NULL))) {
+    display_error(30, (uchar *) "", FALSE);
+    rc = RC_OUT_OF_MEMORY;
+  }
+  if (rc == RC_OK && run_length == num) {
+    sort_runs(keys, work, lines, num, runs, threads);
+    if (threads == 1) {
+      for (i = 0; i < num; i++) {
+        lines[i] = keys[i].line;
+      }
+    } else {
+      rc = merge_runs(runs, threads, lines, (-1), NULL);
+    }
+  }
+  /*
+   * Sort each part of the lines that fits into a temporary file.
+   * The file is unlinked as soon as it is open; it goes when it is closed.
+   * Failing to create the file is a file error, just like failing to open it.
+   */
+  for (i = 0; rc == RC_OK && i < num_file_runs; i++) {
+    start = i * run_length;
+    count = min(run_length, num - start);
+    threads = max(1, min(load_threads, count / SORT_THREAD_MINIMUM));
+    if ((filename = tmpname("SRT")) != NULL) {
+      file_runs[i].fd = open(filename, O_RDWR);
+      unlink(filename);
+      free(filename);
+    }
+    if (file_runs[i].fd == (-1)) {
+      display_error(8, (uchar *) "", FALSE);
+      rc = RC_ACCESS_DENIED;
+      break;
+    }
+    sort_runs(keys, work, lines + start, count, runs, threads);
+    if ((rc = merge_runs(runs, threads, NULL, file_runs[i].fd, out)) != RC_OK) {
+      break;
+    }
+    lseek(file_runs[i].fd, 0L, SEEK_SET);
+    file_runs[i].left = count;
+  }
+  /*
+   * Merge the files back into the lines, reading each through a buffer
+   * carved from the keys; those are no longer needed.
+   */
+  if (rc == RC_OK && num_file_runs) {
+    free(keys);
+    keys = (SORT_KEY *) malloc(num_file_runs * SORT_BUFFER_KEYS * sizeof(SORT_KEY));
+    if (keys == NULL) {
+      display_error(30, (uchar *) "", FALSE);
+      rc = RC_OUT_OF_MEMORY;
+    } else {
+      for (i = 0; i < num_file_runs; i++) {
+        file_runs[i].keys = keys + (i * SORT_BUFFER_KEYS);
+      }
+      rc = merge_runs(file_runs, num_file_runs, lines, (-1), NULL);
+    }
+  }
+  for (i = 0; file_runs != NULL && i < num_file_runs; i++) {
+    if (file_runs[i].fd != (-1)) {
+      close(file_runs[i].fd);
+    }
+  }
+  if (keys != NULL) {
+    free(keys);
+  }
+  if (work != NULL) {
+    free(work);
+  }
+  if (file_runs != NULL) {
+    free(file_runs);
+  }
+  if (out != NULL) {
+    free(out);
+  }
+  return (rc);
+}
+
+/*
+ * Hashes the sort fields of a line as compare_lines() compares them, so that
+ * equal fields hash equally: trailing blanks in a field, whether in the line
+ * or past its end, are left out, and a field ends at a nul.
+ */
+static unsigned long hash_sort_fields(LINE *curr) {
+  unsigned long hash = 2166136261UL;
+  long i, col, last, end;
+  uchar ch;
+
+  for (i = 0; i < num_fields; i++) {
+    last = min(sort_fields[i].right_col, curr->length);
+    for (col = end = sort_fields[i].left_col - 1; col < last; col++) {
+      ch = sort_fold[curr->line[col]];
+      if (ch != ' ') {
+        end = col + 1;
+      }
+      if (ch == 0) {
+        break;
+      }
+    }
+    for (col = sort_fields[i].left_col - 1; col < end; col++) {
+      hash = (hash ^ sort_fold[curr->line[col]]) * 16777619UL;
+    }
+    hash = (hash ^ 0xff) * 16777619UL;
+  }
+  return (hash);
+}
+
+/*
+ * Finds the lines whose sort fields equal those of an earlier line in the
+ * target, in one pass and without sorting, and either deletes them (UNIQUE)
+ * or counts them (COUNT). The first of each set of equal lines is kept.
+ */
+static short remove_duplicate_lines(LINE *curr, long true_line, long abs_num_lines, bool lines_based_on_scope, short action) {
+  SORT_HASH *table = NULL, *new_table = NULL;
+  unsigned long size = SORT_HASH_MINIMUM, used = 0L, hash, k, n;
+  long j = 0L, line_number;
+  long num_actual_lines = 0L;
+  long num_duplicate_lines = 0L;
+  bool duplicate;
+
+  if ((table = (SORT_HASH *) calloc(size, sizeof(SORT_HASH))) == NULL) {
+    display_error(30, (uchar *) "", FALSE);
+    return (RC_OUT_OF_MEMORY);
+  }
+  for (j = 0L, num_actual_lines = 0L;; j++) {
+    if (lines_based_on_scope) {
+      if (num_actual_lines == abs_num_lines) {
+        break;
+      }
+    } else {
+      if (abs_num_lines == j) {
+        break;
+      }
     }
     /*
-     * If CASE IGNORE is on for the current view,
-     * set both sort fields to uppercase for the comparison.
+     * Lines already deleted move the rest of the target up.
      */
-    if (CURRENT_VIEW->case_sort == CASE_IGNORE) {
-      for (j = 0; j < len; j++) {
-        if (islower(sort_field_1[j])) {
-          sort_field_1[j] = toupper(sort_field_1[j]);
+    line_number = true_line + j - ((action == SORT_UNIQUE) ? num_duplicate_lines : 0L);
+    switch (processable_line(CURRENT_VIEW, line_number, curr)) {
+      case LINE_SHADOW:
+        curr = curr->next;
+        break;
+      case LINE_TOF:
+      case LINE_EOF:
+        num_actual_lines++;
+        curr = curr->next;
+        break;
+      default:
+        num_actual_lines++;
+        hash = hash_sort_fields(curr);
+        duplicate = FALSE;
+        for (k = hash & (size - 1); table[k].line != NULL; k = (k + 1) & (size - 1)) {
+          if (table[k].hash == hash && compare_lines(table[k].line, curr) == 0) {
+            duplicate = TRUE;
+            break;
+          }
+        }
+        if (!duplicate) {
+          table[k].hash = hash;
+          table[k].line = curr;
+          curr = curr->next;
+          /*
+           * Keep the table no more than half full.
+           */
+          if (++used > size / 2) {
+            if ((new_table = (SORT_HASH *) calloc(size * 2, sizeof(SORT_HASH))) == NULL) {
+              free(table);
+              display_error(30, (uchar *) "", FALSE);
+              return (RC_OUT_OF_MEMORY);
+            }
+            for (n = 0; n < size; n++) {
+              if (table[n].line != NULL) {
+                for (k = table[n].hash & (size * 2 - 1); new_table[k].line != NULL; k = (k + 1) & (size * 2 - 1));
+                new_table[k] = table[n];
+              }
+            }
+            free(table);
+            table = new_table;
+            size *= 2;
+          }
+          break;
         }
-        if (islower(sort_field_2[j])) {
-          sort_field_2[j] = toupper(sort_field_2[j]);
+        num_duplicate_lines++;
+        if (action == SORT_COUNT) {
+          curr = curr->next;
+          break;
         }
-      }
+        journal_delete(CURRENT_FILE, line_number, curr->line, curr->length);
+        curr = delete_LINE(&CURRENT_FILE->first_line, &CURRENT_FILE->last_line, curr, DIRECTION_FORWARD, TRUE);
+        CURRENT_FILE->number_lines--;
+        adjust_marked_lines(FALSE, line_number, 1L);
+        adjust_pending_prefix(CURRENT_VIEW, FALSE, line_number, 1L);
+        if (CURRENT_VIEW->focus_line > line_number) {
+          CURRENT_VIEW->focus_line--;
+        }
+        if (CURRENT_VIEW->current_line > line_number) {
+          CURRENT_VIEW->current_line--;
+        }
+        break;
+    }
+    if (curr == NULL) {
+      break;
     }
+  }
+  free(table);
+  if (action == SORT_UNIQUE) {
+    if (num_duplicate_lines != 0L) {
+      CURRENT_VIEW->current_line = find_next_in_scope(CURRENT_VIEW, NULL, CURRENT_VIEW->current_line, DIRECTION_FORWARD);
+      CURRENT_VIEW->focus_line = find_next_in_scope(CURRENT_VIEW, NULL, CURRENT_VIEW->focus_line, DIRECTION_FORWARD);
+      increment_alt(CURRENT_FILE);
+    }
+    sprintf((char *) temp_cmd, "%ld duplicate line(s) deleted", num_duplicate_lines);
+  } else {
+    sprintf((char *) temp_cmd, "%ld duplicate line(s)", num_duplicate_lines);
+  }
+  display_error(0, temp_cmd, TRUE);
+  return (RC_OK);
+}
+
+static int compare_sort_origins(const void *one, const void *two) {
+  LINE *line1 = ((SORT_ORIGIN *) one)->line;
+  LINE *line2 = ((SORT_ORIGIN *) two)->line;
+
+  return ((line1 < line2) ? -1 : (line1 > line2) ? 1 : 0);
+}
+
+/*
+ * Records in the journal where each of the num lines sorted came from, so
+ * that the SORT can be undone. orig holds the lines in the order they were
+ * collected (as triples with their old neighbours), sorted the same lines
+ * as relinked, and slots their line numbers in the order collected, with
+ * room for as many more.
+ */
+static void journal_sort(LINE **sorted, LINE **orig, long *slots, long num, short direction) {
+  SORT_ORIGIN *origins = NULL, *found = NULL, key;
+  long i, swap;
+
+  if ((origins = (SORT_ORIGIN *) malloc(num * sizeof(SORT_ORIGIN))) == NULL) {
     /*
-     * If the two sort fields are equal,
-     * continue the sort with the next sort field value.
-     * If the sort fields are different,
-     * return with the the comparison value (if ASCENDING)
-     * or the comparison value negated (if DESCENDING).
+     * Without the old order, the journal no longer matches the file.
      */
-    if ((rc = strncmp((char *) sort_field_1, (char *) sort_field_2, len)) != 0) {
-      return ((sort_fields[i].order == 'A') ? rc : -rc);
-    }
+    journal_discard(CURRENT_FILE);
+    return;
   }
+  for (i = 0L; i < num; i++) {
+    origins[i].line = orig[i * 3L];
+    origins[i].index = i;
+  }
+  qsort(origins, num, sizeof(SORT_ORIGIN), compare_sort_origins);
   /*
-   * To get to here,
-   * the result of sorting on all fields has resulted in both lines being equal.
-   * Return with 0 to indicate this.
+   * The journal wants the line numbers in ascending order.
    */
-  return (0);
+  if (direction == DIRECTION_BACKWARD) {
+    for (i = 0L; i < num / 2; i++) {
+      swap = slots[i];
+      slots[i] = slots[num - i - 1];
+      slots[num - i - 1] = swap;
+    }
+  }
+  for (i = 0L; i < num; i++) {
+    key.line = sorted[(direction == DIRECTION_BACKWARD) ? num - i - 1 : i];
+    found = (SORT_ORIGIN *) bsearch(&key, origins, num, sizeof(SORT_ORIGIN), compare_sort_origins);
+    slots[num + i] = (direction == DIRECTION_BACKWARD) ? num - found->index - 1 : found->index;
+  }
+  free(origins);
+  journal_permute(CURRENT_FILE, num, slots);
 }
 
 #define STATE_REAL   0
@@ -122,18 +663,20 @@ short execute_sort(uchar *params) {
   LINE **origfirst = NULL, **origlp = NULL;
   LINE *curr = NULL, *first = NULL;
   LINE *curr_prev = NULL, *curr_next = NULL;
+  long *slots = NULL;
   long true_line = 0L, dest_line = 0L;
   long abs_num_lines = 0L;
   long j = 0L;
   long num_actual_lines = 0L;
   long num_sorted_lines = 0L, save_num_sorted_lines = 0L;
   short rc = RC_OK, direction = DIRECTION_FORWARD;
-  long left_col = 0, right_col = 0, max_column_width = 0;
+  long left_col = 0, right_col = 0;
   uchar order = 'A';
   TARGET target;
   long target_type = TARGET_NORMAL | TARGET_BLOCK_CURRENT | TARGET_ALL | TARGET_SPARE;
   bool lines_based_on_scope = FALSE;
   short state = STATE_REAL;
+  short action = SORT_LINES;
   int errornum = 1;
 
   /*
@@ -166,6 +709,23 @@ short execute_sort(uchar *params) {
     }
     num_params = param_split(strtrunc(target.rt[target.spare].string), word, SOR_PARAMS, WORD_DELIMS, TEMP_PARAM, strip, FALSE);
   }
+  /*
+   * UNIQUE or COUNT before any sort fields removes or counts lines with
+   * the same sort fields as an earlier line, instead of sorting.
+   */
+  if (num_params > 0) {
+    if (equal((uchar *) "unique", word[0], 1)) {
+      action = SORT_UNIQUE;
+    } else if (equal((uchar *) "count", word[0], 1)) {
+      action = SORT_COUNT;
+    }
+    if (action != SORT_LINES) {
+      for (i = 1; i < num_params; i++) {
+        word[i - 1] = word[i];
+      }
+      num_params--;
+    }
+  }
   /*
    * Process parameters differently, depending on the number...
    *
@@ -313,30 +873,20 @@ short execute_sort(uchar *params) {
       }
       break;
   }
-  /*
-   * Determine the maximum length of a sort field.
-   */
-  for (i = 0; i < num_fields; i++) {
-    max_column_width = max(max_column_width, sort_fields[i].right_col - sort_fields[i].left_col + 1);
-  }
-  /*
-   * Allocate memory for each of the temporary sort fields to the length
-   * of the maximum field width.
-   */
-  if ((sort_field_1 = (uchar *) malloc(max_column_width)) == NULL) {
-    display_error(30, (uchar *) "", FALSE);
-    free_target(&target);
-    return (RC_OUT_OF_MEMORY);
+  for (i = 0; i < 256; i++) {
+    sort_fold[i] = (CURRENT_VIEW->case_sort == CASE_IGNORE && islower(i)) ? toupper(i) : i;
   }
-  if ((sort_field_2 = (uchar *) malloc(max_column_width)) == NULL) {
-    display_error(30, (uchar *) "", FALSE);
-    free_target(&target);
-    return (RC_OUT_OF_MEMORY);
+  for (i = 0, sort_key_width = 0; i < num_fields; i++) {
+    sort_key_width += sort_fields[i].right_col - sort_fields[i].left_col + 1;
   }
   /*
    * Assign the values of the newly allocated array to the LINE pointers for the target lines.
    */
   first = curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, true_line, CURRENT_FILE->number_lines);
+  if (action != SORT_LINES) {
+    free_target(&target);
+    return (remove_duplicate_lines(first, true_line, abs_num_lines, lines_based_on_scope, action));
+  }
   /*
    * Allocate memory for num_lines of LINE pointers and for a copy of original lines.
    */
@@ -350,6 +900,13 @@ short execute_sort(uchar *params) {
     free_target(&target);
     return (RC_OUT_OF_MEMORY);
   }
+  if ((slots = (long *) malloc(2 * abs_num_lines * sizeof(long))) == NULL) {
+    display_error(30, (uchar *) "", FALSE);
+    free(lfirst);
+    free(origfirst);
+    free_target(&target);
+    return (RC_OUT_OF_MEMORY);
+  }
   lp = lfirst;
   origlp = origfirst;
   for (j = 0L, num_actual_lines = 0L;; j++) {
@@ -372,6 +929,7 @@ short execute_sort(uchar *params) {
         break;
       default:
         lp[num_sorted_lines] = curr;
+        slots[num_sorted_lines] = true_line + (long) (j * direction);
         *origlp++ = curr;
         *origlp++ = curr->next;
         *origlp++ = curr->prev;
@@ -403,7 +961,13 @@ short execute_sort(uchar *params) {
     /*
      * Sort the target array...
      */
-    qsort(lfirst, num_sorted_lines, sizeof(LINE *), cmp);
+    if ((rc = sort_lines(lfirst, num_sorted_lines)) != RC_OK) {
+      free(lfirst);
+      free(origfirst);
+      free(slots);
+      free_target(&target);
+      return (rc);
+    }
     /*
      * Merge  the sorted array pointers into the linked list...
      */
@@ -481,6 +1045,12 @@ short execute_sort(uchar *params) {
         break;
       }
     }
+    /*
+     * The lines have been relinked behind the back of the position index.
+     */
+    lll_reindex(CURRENT_FILE->first_line);
+    journal_sort(lfirst, origfirst, slots, save_num_sorted_lines, direction);
+    invalidate_comment_states(CURRENT_FILE, true_line);
     /*
      * If STAY is OFF, change the current and focus lines by the number of lines calculated from the target.
      */
@@ -495,12 +1065,11 @@ short execute_sort(uchar *params) {
     display_error(0, temp_cmd, TRUE);
   }
   /*
-   * Free up the memory used for the sort fields and the target array.
+   * Free up the memory used for the target array.
    */
-  free(sort_field_1);
-  free(sort_field_2);
   free(lfirst);
   free(origfirst);
+  free(slots);
   free_target(&target);
   return (RC_OK);
 }
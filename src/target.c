@@ -22,6 +22,8 @@
 #define STATE_ERROR        99
 
 static bool is_blank(LINE *);
+static short compile_string_target(RTARGET *, bool);
+static bool parallel_target(TARGET *);
 
 /*
  * Return the length of ptr that matches from the minlen of type.
@@ -220,7 +222,7 @@ short parse_target(uchar *target_spec, long true_line, TARGET *target, long targ
         return (RC_OUT_OF_MEMORY);
       }
       strcpy((char *) target->rt[0].string, (char *) ptr);
-      return (RC_OK);
+      return (compile_string_target(&target->rt[0], allow_error_display));
       break;
     default:
       break;
@@ -1083,6 +1085,18 @@ short parse_target(uchar *target_spec, long true_line, TARGET *target, long targ
         }
         target->rt[i].have_compiled_re = TRUE;
         break;
+      case TARGET_STRING:
+        if (target->rt[i].negative != negative || !(target_types & target->rt[i].target_type)) {
+          rc = RC_INVALID_OPERAND;
+          break;
+        }
+        /*
+         * Prepare the string for searching; any error has been displayed
+         */
+        if ((rc = compile_string_target(&target->rt[i], allow_error_display)) != RC_OK) {
+          return (rc);
+        }
+        break;
       default:
         if (target->rt[i].negative != negative) {
           rc = RC_INVALID_OPERAND;
@@ -1126,6 +1140,9 @@ void free_target(TARGET *target) {
     if (target->rt[i].have_compiled_re) {
       regfree(&target->rt[i].pattern_buffer);
     }
+    if (target->rt[i].finder.needle != NULL) {
+      free(target->rt[i].finder.needle);
+    }
   }
   if (target->string != NULL) {
     free(target->string);
@@ -1148,6 +1165,8 @@ short find_target(TARGET *target, long true_line, bool display_parse_error, bool
   long first_found_column = 0;
   short status = RC_OK;
   int i;
+  bool scan_ahead = FALSE;
+  long window = SCAN_THREAD_MINIMUM, count, skipped;
 
   /*
    * Check single targets first (ALL and BLOCK)
@@ -1227,49 +1246,86 @@ short find_target(TARGET *target, long true_line, bool display_parse_error, bool
     curr = &tmpcurr;
   }
   num_lines = 0L;
-  for (;;) {
+  if (target->num_targets == 1 && target->spare == (-1) && target->rt[0].target_type == TARGET_ABSOLUTE && !target->rt[0].not_target && !target->search_semantics && (CURRENT_VIEW->scope_all || target->ignore_scope)) {
     /*
-     * For all repeating targets,
-     * see if the combined targets are found on the line we are currently processing
+     * When every line is in scope, a lone absolute target can be
+     * located directly rather than by testing each line up to it.
      */
-    status = find_rtarget_target(curr, target, true_line, line_number, &num_lines);
-    if (status != RC_TARGET_NOT_FOUND) {
-      break;
+    line_number = target->rt[0].numeric_target;
+    if (line_number < 0L || line_number > CURRENT_FILE->number_lines + 1L || (target->rt[0].negative ? line_number > true_line : line_number < true_line)) {
+      status = RC_TARGET_NOT_FOUND;
+    } else {
+      curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, line_number, CURRENT_FILE->number_lines);
+      num_lines = (target->rt[0].negative) ? true_line - line_number : line_number - true_line;
+      status = RC_OK;
     }
+  } else {
     /*
-     * We can determine the direction of execution based on the first target,
-     * as all targets must have the same direction to have reached here.
+     * Locating forward, lines that can be tested independently are tested
+     * ahead in growing windows, possibly on several threads; the first line
+     * found in a window is then tested again here.
      */
-    if (target->rt[0].negative) {
+    scan_ahead = (!target->rt[0].negative && parallel_target(target));
+    for (;;) {
+      if (scan_ahead) {
+        count = min(window, CURRENT_FILE->number_lines + 2L - line_number);
+        skipped = find_rtarget_lines(target, curr, true_line, line_number, count, NULL, &num_lines);
+        window = min(window * 2, SCAN_WINDOW_LINES);
+        if (skipped) {
+          line_number += skipped;
+          if (line_number > CURRENT_FILE->number_lines + 1L) {
+            status = RC_TARGET_NOT_FOUND;
+            break;
+          }
+          curr = lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, line_number, CURRENT_FILE->number_lines);
+          if (skipped == count) {
+            continue;
+          }
+        }
+      }
       /*
-       * We didn't find the combined targets on this line, so get the previous line
+       * For all repeating targets,
+       * see if the combined targets are found on the line we are currently processing
        */
-      curr = curr->prev;
-      line_number--;
-      if (curr) {
+      status = find_rtarget_target(curr, target, true_line, line_number, &num_lines);
+      if (status != RC_TARGET_NOT_FOUND) {
+        break;
+      }
+      /*
+       * We can determine the direction of execution based on the first target,
+       * as all targets must have the same direction to have reached here.
+       */
+      if (target->rt[0].negative) {
         /*
-         * We have a real line,
-         * so set the target focus_column to after the end of the line (if SEARCHing)
-         * or to the start of the line (if LOCATEing)
-         *
-         * When setting "after the end of line", we have to take into consideration the length of the needle,
-         * in case it ends in space (we need to be able to find a string with a trailing space).
+         * We didn't find the combined targets on this line, so get the previous line
          */
-        if (target->search_semantics) {
-          target->focus_column = curr->length + 1;
-        } else {
-          target->focus_column = 0;
+        curr = curr->prev;
+        line_number--;
+        if (curr) {
+          /*
+           * We have a real line,
+           * so set the target focus_column to after the end of the line (if SEARCHing)
+           * or to the start of the line (if LOCATEing)
+           *
+           * When setting "after the end of line", we have to take into consideration the length of the needle,
+           * in case it ends in space (we need to be able to find a string with a trailing space).
+           */
+          if (target->search_semantics) {
+            target->focus_column = curr->length + 1;
+          } else {
+            target->focus_column = 0;
+          }
         }
+      } else {
+        /*
+         * Get the next line if locating/searching forward
+         */
+        curr = curr->next;
+        line_number++;
+      }
+      if (curr == NULL) {
+        break;
       }
-    } else {
-      /*
-       * Get the next line if locating/searching forward
-       */
-      curr = curr->next;
-      line_number++;
-    }
-    if (curr == NULL) {
-      break;
     }
   }
   if (status == RC_OK) {
@@ -1381,13 +1437,13 @@ static bool is_blank(LINE *curr) {
 THELIST *find_line_name(LINE *curr, uchar *name) {
   THELIST *list_curr = NULL;
 
-  if (curr == NULL || curr->first_name == NULL) {
+  if (curr == NULL || LINE_FIRST_NAME(curr) == NULL) {
     return ((THELIST *) NULL);
   }
   /*
    * Look for the passed in name...
    */
-  list_curr = curr->first_name;
+  list_curr = LINE_FIRST_NAME(curr);
   while (list_curr != NULL) {
     if (strcmp((char *) list_curr->data, (char *) name) == 0) {
       return (list_curr);
@@ -1413,7 +1469,7 @@ LINE *find_named_line(uchar *name, long *retline, bool respect_scope) {
       /*
        * If we don't have a first_name, ignore the line
        */
-      if (curr->first_name != NULL) {
+      if (LINE_FIRST_NAME(curr) != NULL) {
         if (find_line_name(curr, name) != NULL) {
           *retline = lineno;
           return (curr);
@@ -1427,81 +1483,92 @@ LINE *find_named_line(uchar *name, long *retline, bool respect_scope) {
 }
 
 /*
- * Finds a string (needle: in rt->string) in another string (haystack: in curr->line)
- * If SEARCHing backwards, we need to copy the string and reverse the needle and
- * the haystack.
- * e.g.
- * SEARCH -/abc/
- * where curr->line = "1234abc56" and current column position is 9 (start_col is 0 based)
- * needle becomes: "cba"
- * haystack becomes: "65cba4321"
- * and start_col becomes: 0 (len - start_col - 1)
+ * Prepares a string target for searching: converts it from HEX if HEX is on,
+ * and selects the search engine for the current CASE and ARBCHAR settings.
  */
-short find_string_target(LINE *curr, RTARGET *rt, long start_col, int search_semantics) {
-  uchar *haystack = curr->line;
+static short compile_string_target(RTARGET *rt, bool allow_error_display) {
   uchar *needle;
-  long needle_length = 0, haystack_length = 0;
-  long real_start = 0, real_end = 0;
-  bool use_trec = FALSE;
-  short rc = RC_OK;
-  long loc = (-1);
-  long str_length = 0;
+  long needle_length;
 
-  /*
-   * Allocate some temporary space
-   */
-  needle = (uchar *) alloca(rt->length + 1);
-  if (needle == NULL) {
-    display_error(30, (uchar *) "", FALSE);
+  if ((needle = (uchar *) malloc(strlen((char *) rt->string) + 1)) == NULL) {
+    if (allow_error_display) {
+      display_error(30, (uchar *) "", FALSE);
+    }
     return (RC_OUT_OF_MEMORY);
   }
-  /*
-   * Copy the supplied string target rather than point to it,
-   * as we don't want to change the value of the target if it is a HEX string.
-   */
   strcpy((char *) needle, (char *) rt->string);
-  /*
-   * If HEX is on, convert the target from a HEX format to uchar.
-   */
   if (CURRENT_VIEW->hex == TRUE) {
-    rc = convert_hex_strings(needle);
-    switch (rc) {
+    needle_length = convert_hex_strings(needle);
+    switch (needle_length) {
       case -1:                 /* invalid hex value */
-        display_error(32, needle, FALSE);
+        if (allow_error_display) {
+          display_error(32, needle, FALSE);
+        }
+        free(needle);
         return (RC_INVALID_OPERAND);
         break;
       case -2:                 /* memory exhausted */
-        display_error(30, (uchar *) "", FALSE);
+        if (allow_error_display) {
+          display_error(30, (uchar *) "", FALSE);
+        }
+        free(needle);
         return (RC_OUT_OF_MEMORY);
         break;
       default:
         break;
     }
-    needle_length = rc;
   } else {
     needle_length = strlen((char *) needle);
   }
+  rt->length = needle_length;
+  memfind_compile(&rt->finder, needle, needle, needle_length, (bool) ((CURRENT_VIEW->case_locate == CASE_IGNORE) ? TRUE : FALSE), CURRENT_VIEW->arbchar_status, CURRENT_VIEW->arbchar_single, CURRENT_VIEW->arbchar_multiple);
+  return (RC_OK);
+}
+
+/*
+ * Finds a string (needle: in rt->string) in another string (haystack: in curr->line)
+ * If SEARCHing backwards, we need to copy the string and reverse the needle and
+ * the haystack.
+ * e.g.
+ * SEARCH -/abc/
+ * where curr->line = "1234abc56" and current column position is 9 (start_col is 0 based)
+ * needle becomes: "cba"
+ * haystack becomes: "65cba4321"
+ * and start_col becomes: 0 (len - start_col - 1)
+ */
+short find_string_target(LINE *curr, RTARGET *rt, long start_col, int search_semantics, uchar *work) {
+  uchar *haystack = curr->line;
+  long needle_length = 0, haystack_length = 0;
+  long real_start = 0, real_end = 0, pad_end;
+  bool use_work = FALSE;
+  short rc = RC_OK;
+  long loc = (-1);
+  long str_length = 0;
+
   /*
-   * Set the length of the string to be the actual length of the string target.
+   * The string target is prepared by parse_target(); rt->length is the
+   * length of the string after any HEX conversion.
    */
-  rt->length = needle_length;
+  if (rt->finder.needle == NULL && (rc = compile_string_target(rt, TRUE)) != RC_OK) {
+    return (rc);
+  }
+  needle_length = rt->length;
   /*
-   * Determine if we need to copy the contents of the line into trec.
+   * Determine if we need to copy the contents of the line into work (trec, or a
+   * buffer of the same size for a thread testing lines in parallel).
    * The reasons we need to do this are:
    * - the length of the needle is 0
    * - the last character of needle is a space
    */
   if (needle_length == 0) {
-    use_trec = TRUE;
+    use_work = TRUE;
   } else {
-    if (*(needle + (needle_length - 1)) == ' ') {
-      use_trec = TRUE;
+    if (rt->finder.needle[rt->finder.length - 1] == ' ') {
+      use_work = TRUE;
     }
   }
-  if (use_trec) {
-    memset(trec, ' ', max_line_length);
-    memcpy(trec, curr->line, curr->length);
-    haystack = trec;
+  if (use_work) {
+    haystack = work;
     haystack_length = min(max_line_length, max(CURRENT_VIEW->zone_start, curr->length) + needle_length);
   } else {
     haystack = curr->line;
@@ -1523,9 +1590,19 @@ short find_string_target(LINE *curr, RTARGET *rt, long start_col, int search_sem
      * Find the needle in the haystack if real_end > real_start
      */
     if (real_end >= real_start) {
+      /*
+       * Only the part of work that can be searched is blanked past the line.
+       */
+      if (use_work) {
+        memcpy(work, curr->line, curr->length);
+        pad_end = min(max_line_length, max(haystack_length, real_end + 1));
+        if (pad_end > curr->length) {
+          memset(work + curr->length, ' ', pad_end - curr->length);
+        }
+      }
       if (search_semantics && rt->negative) {
         for (; loc == (-1) && real_start >= CURRENT_VIEW->zone_start - 1; real_start--) {
-          loc = memfind(haystack + real_start, needle, (real_end - real_start + 1), needle_length, (bool) ((CURRENT_VIEW->case_locate == CASE_IGNORE) ? TRUE : FALSE), CURRENT_VIEW->arbchar_status, CURRENT_VIEW->arbchar_single, CURRENT_VIEW->arbchar_multiple, &str_length);
+          loc = memfind_run(&rt->finder, haystack + real_start, (real_end - real_start + 1), &str_length);
           if (loc != (-1) && loc + real_start - 1 == start_col) {
             loc = -1;
           }
@@ -1534,7 +1611,7 @@ short find_string_target(LINE *curr, RTARGET *rt, long start_col, int search_sem
           real_start++;
         }
       } else {
-        loc = memfind(haystack + real_start, needle, (real_end - real_start + 1), needle_length, (bool) ((CURRENT_VIEW->case_locate == CASE_IGNORE) ? TRUE : FALSE), CURRENT_VIEW->arbchar_status, CURRENT_VIEW->arbchar_single, CURRENT_VIEW->arbchar_multiple, &str_length);
+        loc = memfind_run(&rt->finder, haystack + real_start, (real_end - real_start + 1), &str_length);
       }
     }
   }
@@ -1549,43 +1626,29 @@ short find_string_target(LINE *curr, RTARGET *rt, long start_col, int search_sem
 }
 
 short find_regexp(LINE *curr, RTARGET *rt) {
-  uchar *haystack = NULL;
-  long len, i, haystack_length = 0, real_start = 0, real_end = 0;
+  long real_start = 0, real_end = 0;
   regmatch_t match;
 
   /*
-   * Search for the compiled RE
+   * Search for the compiled RE in one pass over the part of the line within the ZONE.
+   * REG_STARTEND bounds the search, so the line needs no terminating nul, and the
+   * match offsets are relative to the start of the line.
+   * A line that ends before the ZONE cannot match.
    */
-  haystack = curr->line;
-  haystack_length = curr->length;
-  /*
-   * Calculate the bounds to search in based on length of haystack and ZONE settings.
-   * If the haystack is empty, no need to search.
-   */
-  if (haystack_length == 0) {
-    haystack = (uchar *) "";
-    real_end = real_start = 0;
-    len = 0;
-  } else {
-    real_end = min(haystack_length - 1, CURRENT_VIEW->zone_end - 1);
-    real_start = max(0, CURRENT_VIEW->zone_start - 1);
-    len = real_end - real_start + 1;
-  }
-  for (i = 0; i < len;) {
-    if (0 == regexec(&rt->pattern_buffer, (char *) haystack + i, 1, &match, 0)) {
-      if (match.rm_eo > (len - i)) {
-        break;                  // match but past limit
-      }
-      rt->length = match.rm_eo - match.rm_so;
-      rt->start = real_start + i;       /* ?? */
-      rt->found_length = rt->length;
-      return RC_OK;
-      break;
-    } else {
-      i++;
-    }
+  real_start = max(0, CURRENT_VIEW->zone_start - 1);
+  real_end = min(curr->length, CURRENT_VIEW->zone_end);
+  if (real_end < real_start) {
+    return RC_TARGET_NOT_FOUND;
+  }
+  match.rm_so = real_start;
+  match.rm_eo = real_end;
+  if (regexec(&rt->pattern_buffer, (curr->line == NULL) ? "" : (char *) curr->line, 1, &match, REG_STARTEND) != 0) {
+    return RC_TARGET_NOT_FOUND;
   }
-  return RC_TARGET_NOT_FOUND;
+  rt->length = match.rm_eo - match.rm_so;
+  rt->start = match.rm_so;
+  rt->found_length = rt->length;
+  return RC_OK;
 }
 
 short find_rtarget_target(LINE *curr, TARGET *target, long true_line, long line_number, long *num_lines) {
@@ -1691,7 +1754,7 @@ short find_rtarget_target(LINE *curr, TARGET *target, long true_line, long line_
         target_found = curr->flags.tag_flag;
         break;
       case TARGET_POINT:
-        if (curr->first_name == NULL) {
+        if (LINE_FIRST_NAME(curr) == NULL) {
           break;
         }
         if (find_line_name(curr, target->rt[i].string) != NULL) {
@@ -1747,7 +1810,7 @@ short find_rtarget_target(LINE *curr, TARGET *target, long true_line, long line_
         if (start_col == (-1)) {
           rc = RC_TARGET_NOT_FOUND;
         } else {
-          rc = find_string_target(curr, &target->rt[i], start_col, target->search_semantics);
+          rc = find_string_target(curr, &target->rt[i], start_col, target->search_semantics, (target->work) ? target->work : trec);
         }
         switch (rc) {
           case RC_OK:
@@ -1845,6 +1908,184 @@ short find_rtarget_target(LINE *curr, TARGET *target, long true_line, long line_
   return ((status) ? RC_OK : RC_TARGET_NOT_FOUND);
 }
 
+/*
+ * Only targets whose result for a line depends on nothing but that line can be
+ * tested on several threads at once; relative and absolute targets count lines,
+ * and SEARCH carries the focus column from line to line.
+ */
+static bool parallel_target(TARGET *target) {
+  short i;
+
+  if (load_threads < 2 || target->search_semantics) {
+    return (FALSE);
+  }
+  for (i = 0; i < target->num_targets - ((target->spare == (-1)) ? 0 : 1); i++) {
+    switch (target->rt[i].target_type) {
+      case TARGET_STRING:
+      case TARGET_REGEXP:
+      case TARGET_BLANK:
+      case TARGET_NEW:
+      case TARGET_CHANGED:
+      case TARGET_ALTERED:
+      case TARGET_TAGGED:
+      case TARGET_POINT:
+        break;
+      default:
+        return (FALSE);
+        break;
+    }
+  }
+  return (TRUE);
+}
+
+static void *scan_lines(void *arg) {
+  TARGET_SCAN *scan = (TARGET_SCAN *) arg;
+  LINE *curr = scan->curr;
+  long num_lines;
+  short rc;
+
+  for (scan->tested = 0; scan->tested < scan->count; scan->tested++, curr = curr->next) {
+    num_lines = scan->num_lines;
+    rc = find_rtarget_target(curr, scan->target, scan->true_line, scan->line_number + scan->tested, &scan->num_lines);
+    if (scan->status) {
+      scan->status[scan->tested] = rc;
+    } else if (rc != RC_TARGET_NOT_FOUND) {
+      scan->num_lines = num_lines;
+      break;
+    }
+  }
+  return (NULL);
+}
+
+/*
+ * Gives a thread its own copy of the target: the repeating targets record
+ * where they were found, regexec() serialises callers of one compiled RE,
+ * and string targets may need a line padded with blanks.
+ */
+static bool copy_scan_target(TARGET_SCAN *scan, TARGET *target) {
+  short i;
+
+  scan->copy = *target;
+  scan->copy.work = NULL;
+  if ((scan->copy.rt = (RTARGET *) malloc(target->num_targets * sizeof(RTARGET))) == NULL) {
+    return (FALSE);
+  }
+  memcpy(scan->copy.rt, target->rt, target->num_targets * sizeof(RTARGET));
+  for (i = 0; i < target->num_targets; i++) {
+    scan->copy.rt[i].have_compiled_re = FALSE;
+  }
+  if ((scan->copy.work = (uchar *) malloc(trec_len)) == NULL) {
+    return (FALSE);
+  }
+  for (i = 0; i < target->num_targets; i++) {
+    if (target->rt[i].have_compiled_re) {
+      if (regcomp(&scan->copy.rt[i].pattern_buffer, (char *) target->rt[i].string, 0) != 0) {
+        return (FALSE);
+      }
+      scan->copy.rt[i].have_compiled_re = TRUE;
+    }
+  }
+  scan->target = &scan->copy;
+  return (TRUE);
+}
+
+static void free_scan_target(TARGET_SCAN *scan) {
+  short i;
+
+  if (scan->copy.rt != NULL) {
+    for (i = 0; i < scan->copy.num_targets; i++) {
+      if (scan->copy.rt[i].have_compiled_re) {
+        regfree(&scan->copy.rt[i].pattern_buffer);
+      }
+    }
+    free(scan->copy.rt);
+  }
+  if (scan->copy.work != NULL) {
+    free(scan->copy.work);
+  }
+}
+
+/*
+ * Tests count lines, starting at curr, as calling find_rtarget_target() for
+ * each in turn would, sharing them among load_threads threads if possible.
+ * If status is not NULL, the result for each line is stored in it, otherwise
+ * testing stops at the first line not RC_TARGET_NOT_FOUND.
+ * Returns the number of lines tested, not including that first line.
+ */
+long find_rtarget_lines(TARGET *target, LINE *curr, long true_line, long line_number, long count, short *status, long *num_lines) {
+  TARGET_SCAN *scans = NULL;
+  TARGET_SCAN scan;
+  long threads = 1, start, tested = 0;
+  long i;
+  bool ok = TRUE;
+
+  if (parallel_target(target)) {
+    threads = min(load_threads, count / SCAN_THREAD_MINIMUM);
+  }
+  if (threads > 1) {
+    scans = (TARGET_SCAN *) calloc(threads, sizeof(TARGET_SCAN));
+    ok = (scans != NULL);
+  }
+  for (i = 0; scans != NULL && ok && i < threads; i++) {
+    start = count * i / threads;
+    scans[i].curr = (i == 0) ? curr : lll_find(CURRENT_FILE->first_line, CURRENT_FILE->last_line, line_number + start, CURRENT_FILE->number_lines);
+    scans[i].true_line = true_line;
+    scans[i].line_number = line_number + start;
+    scans[i].count = (count * (i + 1) / threads) - start;
+    scans[i].status = (status) ? status + start : NULL;
+    ok = copy_scan_target(&scans[i], target);
+  }
+  if (threads < 2 || !ok) {
+    /*
+     * Too few lines to share, or no memory to share them; test them here.
+     */
+    if (scans != NULL) {
+      for (i = 0; i < threads; i++) {
+        free_scan_target(&scans[i]);
+      }
+      free(scans);
+    }
+    memset(&scan, 0, sizeof(TARGET_SCAN));
+    scan.target = target;
+    scan.curr = curr;
+    scan.true_line = true_line;
+    scan.line_number = line_number;
+    scan.count = count;
+    scan.status = status;
+    scan.num_lines = *num_lines;
+    scan_lines(&scan);
+    *num_lines = scan.num_lines;
+    return (scan.tested);
+  }
+  for (i = 1; i < threads; i++) {
+    if (pthread_create(&scans[i].thread, NULL, scan_lines, &scans[i]) != 0) {
+      scans[i].thread = pthread_self();
+      scan_lines(&scans[i]);
+    }
+  }
+  scan_lines(&scans[0]);
+  for (i = 1; i < threads; i++) {
+    if (!pthread_equal(scans[i].thread, pthread_self())) {
+      pthread_join(scans[i].thread, NULL);
+    }
+  }
+  /*
+   * The lines tested are those up to the first line found by any thread.
+   */
+  for (i = 0; i < threads; i++) {
+    tested += scans[i].tested;
+    *num_lines += scans[i].num_lines;
+    if (scans[i].tested < scans[i].count) {
+      break;
+    }
+  }
+  for (i = 0; i < threads; i++) {
+    free_scan_target(&scans[i]);
+  }
+  free(scans);
+  return (tested);
+}
+
 bool find_rtarget_column_target(uchar *line, long len, TARGET *target, long true_column, long column_number, long *num_columns) {
   short i = 0;
   bool target_found = FALSE, status = FALSE;
@@ -1898,7 +2139,7 @@ bool find_rtarget_column_target(uchar *line, long len, TARGET *target, long true
         if (target->rt[i].negative) {
           true_column -= 2;
         }
-        if (find_string_target(&curr, &target->rt[i], true_column, THE_SEARCH_SEMANTICS) == RC_OK && target->rt[i].start + 1 == column_number) {
+        if (find_string_target(&curr, &target->rt[i], true_column, THE_SEARCH_SEMANTICS, trec) == RC_OK && target->rt[i].start + 1 == column_number) {
           target_found = TRUE;
         }
         break;
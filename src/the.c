@@ -165,6 +165,9 @@ struct stat stat_buf;
 
 long display_length = 0;
 
+int load_threads = 1;
+long sort_memory = 0L;
+
 short lastrc = 0;
 
 short compatible_look = COMPAT_THE;
@@ -380,7 +383,7 @@ int main(int argc, char *argv[]) {
   /*
    * Process the command line arguments.
    */
-  strcpy(mygetopt_opts, "Rqk::sSbmnrl:c:p:w:a:u:hH");
+  strcpy(mygetopt_opts, "Rqk::sSbmnrl:c:p:w:a:u:j:M:hH");
   strcat(mygetopt_opts, "1::");
   while ((c = getopt(my_argc, my_argv, mygetopt_opts)) != EOF) {
     switch ((char) c) {
@@ -512,6 +515,30 @@ int main(int argc, char *argv[]) {
           return (4);
         }
         break;
+      case 'j':                /* threads used to split files into lines */
+        load_threads = atoi(optarg);
+        if (load_threads < 1) {
+          cleanup();
+          display_error(5, (uchar *) "- threads MUST be >= 1", FALSE);
+          return (4);
+        }
+        if (load_threads > MAX_LOAD_THREADS) {
+          cleanup();
+          /* safe to use mygetopt_opts as we are bailing out */
+          sprintf(mygetopt_opts, "- threads MUST be <= %d", MAX_LOAD_THREADS);
+          display_error(6, (uchar *) mygetopt_opts, FALSE);
+          return (5);
+        }
+        break;
+      case 'M':                /* megabytes of keys sorted before using temporary files */
+        sort_memory = atol(optarg);
+        if (sort_memory < 1) {
+          cleanup();
+          display_error(5, (uchar *) "- sort memory MUST be >= 1", FALSE);
+          return (4);
+        }
+        sort_memory *= 1048576L;
+        break;
       case 'h':
         cleanup();
         display_info((uchar *) my_argv[0]);
@@ -894,10 +921,14 @@ int main(int argc, char *argv[]) {
   }
   if (screen[0].sl != NULL) {
     free(screen[0].sl);
+    screen[0].sl = NULL;
   }
   if (screen[1].sl != NULL) {
     free(screen[1].sl);
+    screen[1].sl = NULL;
   }
+  free_parsed_lines(0);
+  free_parsed_lines(1);
   if (the_macro_dir) {
     free(the_macro_dir);
   }
@@ -915,7 +946,7 @@ int main(int argc, char *argv[]) {
   if (prf_arg != NULL) {
     free(prf_arg);
   }
-  free_recovery_list();
+  journal_free();
   if (target_buffer != NULL) {
     free(target_buffer);
   }
@@ -1104,7 +1135,7 @@ static void display_info(uchar *argv0) {
   fprintf(stdout, "\nTHE %s %2s %s. All rights reserved.\n", the_version, the_release, the_copyright);
   fprintf(stdout, "THE is distributed under the terms of the GNU General Public License \n");
   fprintf(stdout, "and comes with NO WARRANTY. See the file COPYING for details.\n");
-  fprintf(stdout, "\nUsage:\n\n%s [-hnmrsbq] [-p profile] [-a profile_arg] [-l line_num] [-c col_num] [-w width] [-u display_length] [-k[fmt]] [[dir] [file [...]]]\n", argv0);
+  fprintf(stdout, "\nUsage:\n\n%s [-hnmrsbq] [-p profile] [-a profile_arg] [-l line_num] [-c col_num] [-w width] [-u display_length] [-j threads] [-M megabytes] [-k[fmt]] [[dir] [file [...]]]\n", argv0);
   fprintf(stdout, "\nwhere:\n\n");
   fprintf(stdout, "-h,--help              show this message\n");
   fprintf(stdout, "-n                     do not execute a profile file\n");
@@ -1120,6 +1151,8 @@ static void display_info(uchar *argv0) {
   fprintf(stdout, "-a profile_arg         argument(s) to profile file (only with Rexx)\n");
   fprintf(stdout, "-w width               maximum width of line (default 1000)\n");
   fprintf(stdout, "-u display_length      display length in non-line mode\n");
+  fprintf(stdout, "-j threads             threads used to split large files into lines, test targets and sort\n");
+  fprintf(stdout, "-M megabytes           memory for SORT keys before sorting through temporary files\n");
   fprintf(stdout, "[dir [file [...]]]     file(s) and/or directory to be edited\n\n");
   fflush(stdout);
   return;
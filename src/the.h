@@ -8,6 +8,7 @@
 #include <fcntl.h>
 #include <locale.h>
 #include <memory.h>
+#include <pthread.h>
 #include <regex.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -17,6 +18,7 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -344,6 +346,19 @@
 #define TARGET_ALTERED        0x40000
 #define TARGET_NORMAL         TARGET_ABSOLUTE|TARGET_RELATIVE|TARGET_STRING|TARGET_POINT|TARGET_BLANK|TARGET_NEW|TARGET_CHANGED|TARGET_TAGGED|TARGET_ALTERED
 
+/* string search engines */
+
+#define MEMFIND_PLAIN         0
+#define MEMFIND_CASELESS      1
+#define MEMFIND_ARBCHAR       2
+
+/* edits recorded in a journal for UNDO and REDO */
+
+#define JOURNAL_CHANGE        0
+#define JOURNAL_INSERT        1
+#define JOURNAL_DELETE        2
+#define JOURNAL_PERMUTE       3
+
 /* compatiblility modes */
 
 #define COMPAT_THE            1
@@ -482,30 +497,103 @@ struct pending_prefix_command {
 typedef struct pending_prefix_command THE_PPC;
 
 typedef struct {
-  unsigned int new_flag;
-  unsigned int changed_flag;
-  unsigned int tag_flag;
-  unsigned int save_tag_flag;
-  unsigned int unused1;
-  unsigned int unused2;
-  unsigned int unused3;
-  unsigned int unused4;
+  unsigned int new_flag:1;
+  unsigned int changed_flag:1;
+  unsigned int tag_flag:1;
+  unsigned int save_tag_flag:1;
+  unsigned int shared_flag:1;           /* contents are in a shared text block */
+  unsigned int slab_flag:1;             /* line is in a slab of its file */
+  unsigned int extra_flag:1;            /* line has a LINE_EXTRA */
 } lineflags;
 
+/* structures for the line position index (see linked.c) */
+
+struct line_chunk {
+  struct line *head;            /* first line in this chunk */
+  long count;                   /* number of lines in this chunk */
+  long slot;                    /* position of this chunk in the index */
+  struct line_index *index;     /* index this chunk belongs to */
+};
+typedef struct line_chunk LINE_CHUNK;
+
+struct line_index {
+  LINE_CHUNK **chunks;          /* chunks in list order */
+  long *tree;                   /* Fenwick tree of chunk line counts (1 based) */
+  long num_chunks;              /* number of chunks in use */
+  long max_chunks;              /* number of chunks allocated */
+  bool dirty;                   /* TRUE if tree must be rebuilt before use */
+};
+typedef struct line_index LINE_INDEX;
+
 struct line {
   struct line *prev;            /* pointer to previous line */
   struct line *next;            /* pointer to next line */
-  uchar *name;                  /* used for other structures; NOT for a LINE in THE */
-  THELIST *first_name;          /* pointer to first name for list of names */
   uchar *line;                  /* pointer to contents of line */
   long length;                  /* number of characters in line */
-  THE_PPC *pre;
   ushort select;                /* select level for each line */
   ushort save_select;           /* saved select level (used by ALL) */
   lineflags flags;
+  LINE_CHUNK *chunk;            /* position index chunk; NULL if list not indexed */
 };
 typedef struct line LINE;
 
+/* structure for the rarely used details of a line, kept aside from it (see linked.c) */
+
+struct line_extra {
+  struct line_extra *next;      /* pointer to next details in same hash chain */
+  LINE *owner;                  /* line these details belong to */
+  uchar *name;                  /* used for other structures; NOT for a LINE in THE */
+  THELIST *first_name;          /* pointer to first name for list of names */
+  THE_PPC *pre;                 /* pending prefix command */
+};
+typedef struct line_extra LINE_EXTRA;
+
+#define LINE_NAME(curr)       (((curr)->flags.extra_flag) ? lll_extra((curr), FALSE)->name : (uchar *) NULL)
+#define LINE_FIRST_NAME(curr) (((curr)->flags.extra_flag) ? lll_extra((curr), FALSE)->first_name : (THELIST *) NULL)
+#define LINE_PRE(curr)        (((curr)->flags.extra_flag) ? lll_extra((curr), FALSE)->pre : (THE_PPC *) NULL)
+
+/* structures for allocating the lines of a file from slabs (see linked.c) */
+
+struct line_pool {
+  struct line_slab *first_slab; /* newest slab; new lines are taken from it */
+  long used;                    /* number of lines taken from the newest slab */
+  LINE *free_lines;             /* lines deleted, for reuse */
+};
+typedef struct line_pool LINE_POOL;
+
+struct line_slab {
+  struct line_slab *next;       /* pointer to next (older) slab */
+  LINE_POOL *pool;              /* pool the slab belongs to */
+};
+typedef struct line_slab LINE_SLAB;
+
+/* structure for blocks of text shared by unchanged lines read from a file */
+
+struct text_block {
+  struct text_block *next;      /* pointer to next (older) block */
+  uchar *text;                  /* contents of block */
+  long size;                    /* number of bytes allocated for text */
+  long used;                    /* number of bytes of text in use */
+  bool in_place;                /* TRUE if lines were split from text where it lies */
+};
+typedef struct text_block TEXT_BLOCK;
+
+/* structure for a range of a file read whole and split into lines by one thread */
+
+struct load_range {
+  uchar *start;                 /* start of first line in range */
+  uchar *end;                   /* end of range; start of next range */
+  LINE *first;                  /* first line split from range */
+  LINE *last;                   /* last line split from range */
+  long lines;                   /* number of lines split from range */
+  long maxlen;                  /* length of longest line in range */
+  long too_long;                /* line in range that exceeds max. width; 0 if none */
+  bool no_memory;               /* TRUE if a line could not be allocated */
+  bool trim;                    /* TRUE if trailing spaces are removed from lines */
+  LINE_POOL pool;               /* storage for lines split from range */
+};
+typedef struct load_range LOAD_RANGE;
+
 struct colour_attr {
   int pair;                     /* pair number for colour */
   chtype mod;                   /* colour modifier */
@@ -605,6 +693,24 @@ struct parse_functions {
 };
 typedef struct parse_functions PARSE_FUNCTIONS;
 
+/* keywords or functions of a parser, hashed by construct_parser() for lookup (see parser.c) */
+
+struct parse_word {
+  uchar *word;                  /* in lower case if the parser is case insensitive */
+  short word_length;
+  uchar alternate;
+  int next;                     /* next word in the same bucket; -1 if none */
+};
+typedef struct parse_word PARSE_WORD;
+
+struct parse_word_table {
+  PARSE_WORD *words;
+  uchar *text;                  /* the words, one after another */
+  int *buckets;                 /* first word in each bucket; -1 if none */
+  int num_buckets;              /* a power of 2; 0 if no words */
+};
+typedef struct parse_word_table PARSE_WORD_TABLE;
+
 struct parse_extension {
   struct parse_extension *prev;
   struct parse_extension *next;
@@ -670,12 +776,15 @@ struct parser_details {
   PARSE_KEYWORDS *first_keyword;
   PARSE_KEYWORDS *current_keyword;
   short min_keyword_length;
+  PARSE_WORD_TABLE keyword_table;
+  PARSE_WORD_TABLE preprocessor_table; /* keywords starting with preprocessor_char, without it */
   /*
    * function features
    */
   PARSE_FUNCTIONS *first_function;
   PARSE_FUNCTIONS *current_function;
   short min_function_length;
+  PARSE_WORD_TABLE function_table;
   regex_t function_pattern_buffer;
   bool have_function_pattern_buffer;
   bool have_function_option_alternate;
@@ -776,6 +885,20 @@ struct parser_mapping {
 };
 typedef struct parser_mapping PARSER_MAPPING;
 
+/* structure for a string prepared for searching */
+
+struct memfind {
+  uchar *needle;                /* string searched for; folded if case_ignore */
+  long length;                  /* length of needle */
+  int type;                     /* search engine; MEMFIND_PLAIN etc */
+  bool case_ignore;             /* TRUE if case of letters is ignored */
+  uchar arb_single;             /* matches any one character if ARBCHAR */
+  uchar arb_multiple;           /* matches any characters if ARBCHAR */
+  bool use_skip;                /* TRUE if skip is set */
+  long skip[256];               /* distance to move for the last byte compared */
+};
+typedef struct memfind MEMFIND;
+
 /* structure for repeating targets */
 
 struct rtarget {
@@ -791,6 +914,7 @@ struct rtarget {
   bool found;                   /* TRUE if this repeating target was found */
   bool have_compiled_re;        /* TRUE if we have a compiled RE */
   regex_t pattern_buffer;       /* compiled RE for REGEXP */
+  MEMFIND finder;               /* prepared string target; needle allocated */
 };
 typedef struct rtarget RTARGET;
 
@@ -808,9 +932,67 @@ struct target {
   bool search_semantics;        /* TRUE if SEARCHing */
   long focus_column;            /* used when SEARCHing */
   bool all_tag_command;         /* true if finding rtargets with TAG or ALL */
+  uchar *work;                  /* line padded with blanks for string targets; trec if NULL */
 };
 typedef struct target TARGET;
 
+/* structure for a thread testing lines against a target */
+
+struct target_scan {
+  TARGET *target;               /* target tested; copy unless testing on the calling thread */
+  TARGET copy;                  /* private copy of target for this thread */
+  LINE *curr;                   /* first line tested */
+  long true_line;               /* line number the target is relative to */
+  long line_number;             /* line number of curr */
+  long count;                   /* number of lines to test */
+  short *status;                /* result for each line; NULL to stop at first line found */
+  long tested;                  /* lines tested; not including the first found if status NULL */
+  long num_lines;               /* lines counted by find_rtarget_target() in those */
+  pthread_t thread;
+};
+typedef struct target_scan TARGET_SCAN;
+
+/*
+ * An edit in a journal, as the change that undoes it: bytes of a line
+ * replaced, a line inserted with the contents it had when deleted,
+ * lines deleted that had been inserted, or lines moved back to where they
+ * were before they were sorted.
+ */
+struct journal_entry {
+  long sequence;                /* command whose edits are undone together */
+  long line_number;             /* line changed or inserted, or first line deleted or moved */
+  long offset;                  /* JOURNAL_CHANGE: first byte of the line replaced */
+  long length;                  /* JOURNAL_CHANGE: bytes replaced, or -1 for all; JOURNAL_DELETE, JOURNAL_PERMUTE: lines */
+  long data;                    /* offset of the replacing bytes, line contents or line order in data */
+  long data_length;             /* number of those bytes */
+  uchar type;                   /* JOURNAL_CHANGE, JOURNAL_INSERT, JOURNAL_DELETE or JOURNAL_PERMUTE */
+  bool recovered;               /* TRUE once the old contents have been RECOVERed */
+};
+typedef struct journal_entry JOURNAL_ENTRY;
+
+/* edits of a file in the order made, and the bytes they need */
+
+struct journal {
+  JOURNAL_ENTRY *entries;
+  long num_entries;
+  long max_entries;
+  uchar *data;
+  long data_length;
+  long max_data;
+  long overflow;                /* command whose edits were too many to keep */
+};
+typedef struct journal JOURNAL;
+
+/* paired comment open at every COMMENT_CHECKPOINT_LINES lines of a file (see parser.c) */
+
+struct comment_cache {
+  PARSER_DETAILS *parser;       /* parser the states were found with */
+  short *states;                /* comment open at the start of each checkpoint line; 0 if none */
+  long max_states;              /* number of states allocated */
+  long num_valid;               /* number of states still correct */
+};
+typedef struct comment_cache COMMENT_CACHE;
+
 typedef struct {
   uchar autosave;
   short backup;
@@ -867,6 +1049,8 @@ typedef struct {
   LINE *first_line;             /* pointer to first line */
   LINE *last_line;              /* pointer to last line */
   LINE *editv;                  /* pointer for EDITV variables */
+  TEXT_BLOCK *first_text_block; /* storage for lines read from file */
+  LINE_POOL line_pool;          /* storage for LINE structures of the file */
   long number_lines;            /* number of actual lines in file */
   long max_line_length;         /* Maximum line length in file */
   uchar file_views;             /* number of views of current file */
@@ -875,8 +1059,51 @@ typedef struct {
   THE_PPC *last_ppc;            /* last pending prefix command */
   uchar eolfirst;               /* indicates termination of first line read */
   int readonly;                 /* have we set the file to be readonly */
+  JOURNAL undo;                 /* edits undone by UNDO */
+  JOURNAL redo;                 /* edits undone by UNDO, redone by REDO */
+  long journal_altered;         /* last command that incremented the alteration count */
+  long journal_recorded;        /* last command whose edits were journalled */
+  COMMENT_CACHE comment_cache;  /* paired comment state at line checkpoints */
+  struct lazy_load *lazy_load;  /* rest of file being read in the background; NULL if none */
 } FILE_DETAILS;
 
+/* structure for the rest of a large file being read and split into lines in the background */
+
+struct lazy_load {
+  struct lazy_load *next;       /* pointer to next load */
+  FILE_DETAILS *file;           /* file being loaded */
+  int fd;                       /* descriptor the rest of the file is read from */
+  uchar *text;                  /* whole file, read into as it is split */
+  long size;                    /* number of bytes in the file */
+  long offset;                  /* number of bytes of the file read so far */
+  LOAD_RANGE *ranges;           /* lines split from each block read, in file order */
+  long max_ranges;              /* number of ranges allocated */
+  long num_ranges;              /* number of ranges split so far */
+  long next_range;              /* first range not yet added to the file */
+  long lines_read;              /* number of lines added to the file so far */
+  bool trim;                    /* TRUE if trailing spaces are removed from lines */
+  bool finished;                /* TRUE once the last range has been split */
+  bool stop;                    /* TRUE if the file is released before it is read */
+  bool started;                 /* TRUE if the thread reading the file was started */
+  pthread_t thread;             /* thread reading the file */
+  pthread_mutex_t mutex;        /* guards num_ranges, finished and stop */
+  pthread_cond_t cond;          /* signalled as each range is split */
+  uchar filename[MAX_FILE_NAME + 1];
+};
+typedef struct lazy_load LAZY_LOAD;
+
+/* structure for output gathered while a file is saved */
+
+struct save_buffer {
+  int fd;                       /* file descriptor being written */
+  int iovcnt;                   /* number of entries in iov */
+  struct iovec iov[SAVE_IOV_MAX];       /* pieces to be written */
+  long stage_start;             /* start of staged bytes not yet in iov */
+  long stage_used;              /* number of bytes staged */
+  uchar stage[SAVE_STAGE_SIZE]; /* copies of short pieces */
+};
+typedef struct save_buffer SAVE_BUFFER;
+
 typedef struct {
   struct view_details *prev;    /* pointer to previous view */
   struct view_details *next;    /* pointer to next view */
@@ -1060,6 +1287,28 @@ struct view_details {
 };
 typedef struct view_details VIEW_DETAILS;
 
+/* structure for what was last painted in a row of the filearea */
+
+struct shown_row {
+  bool valid;                   /* FALSE if the row must be repainted */
+  short line_type;              /* type of line */
+  long number_lines_excluded;   /* number of lines excluded */
+  chtype normal_colour;         /* normal colour for line */
+  chtype other_colour;          /* other colour for line */
+  long other_start_col;         /* start column of other colour from col 0 */
+  long other_end_col;           /* end column of other colour from col 0 */
+  chtype prefix_colour;         /* colour of prefix */
+  chtype gap_colour;            /* colour of prefix gap */
+  uchar prefix[MAX_PREFIX_WIDTH + 1];         /* contents of prefix area */
+  bool highlight;               /* TRUE if line is highlighted */
+  bool is_highlighting;         /* TRUE if the line contained syntax highlighting */
+  long length;                  /* number of characters in line; -1 if no contents */
+  uchar *contents;              /* copy of contents of line */
+  long contents_size;           /* size of contents */
+  chtype highlighting[THE_MAX_SCREEN_WIDTH];  /* colours for syntax highlighting */
+};
+typedef struct shown_row SHOWN_ROW;
+
 /* structure for each line to be displayed */
 
 struct show_line {
@@ -1099,9 +1348,26 @@ struct show_line {
   bool is_current_line;                   /* TRUE if this line is the current line */
   bool is_cursor_line;                    /* TRUE if this line is the cursor line of the filearea */
   bool is_cursor_line_filearea_different; /* TRUE if the filearea/cursorline colours are different */
+  SHOWN_ROW shown;                        /* what was last painted in the row */
 };
 typedef struct show_line SHOW_LINE;
 
+/*
+ * structure for a line parsed for syntax highlighting, kept for any row of
+ * the screen that shows the same contents in the same state
+ */
+struct parsed_line {
+  unsigned int signature;                 /* signature of the inputs of parse_line(); 0 if unused */
+  unsigned int used;                      /* display in which it was last used */
+  long length;                            /* length of the line */
+  uchar *contents;                        /* copy of the contents of the line */
+  bool is_current_line;                   /* is_current_line of the row it was parsed for */
+  bool is_cursor_line;                    /* TRUE if parsed as the cursor line in a different colour */
+  chtype *highlighting;                   /* highlighting as left by parse_line() */
+  unsigned char *highlight_type;          /* highlight_type as left by parse_line() */
+};
+typedef struct parsed_line PARSED_LINE;
+
 /* structure for each screen */
 
 typedef struct {
@@ -1116,6 +1382,9 @@ typedef struct {
   WINDOW *win[VIEW_WINDOWS];      /* curses windows for the screen display */
   VIEW_DETAILS *screen_view;      /* view being displayed in this screen */
   SHOW_LINE *sl;                  /* pointer to SHOW_DETAILS structure for screen */
+  PARSED_LINE *parsed;            /* lines parsed on and around the screen */
+  short num_parsed;               /* number of entries in parsed */
+  unsigned int displays;          /* number of displays of the screen */
 } SCREEN_DETAILS;
 
 /* structure for colour definitions */
@@ -9,11 +9,30 @@
 #define MAX_FILE_NAME             1000  /* maximum length of fully qualified file */
 #define MAX_LENGTH_OF_LINE        1000  /* default maximum length of a line */
 #define MAX_COMMANDS                10  /* default maximum number of commands allowed on command line */
-#define MAX_RECV                    20  /* number of lines that can be recovered */
 #define MAX_SAVED_COMMANDS          20  /* number of commands that can be retrieved */
 #define MAX_NUMTABS                 32  /* number of tab stops that can be defined */
 #define MAXIMUM_POPUP_KEYS          20  /* maximum number of keys in popup menu */
 #define MAXIMUM_DIALOG_LINES       100  /* maximum number of lines in a dailog */
+#define LINE_INDEX_STRIDE          256  /* lines per chunk of the line position index */
+#define LINE_INDEX_MINIMUM        1024  /* lines in a file before it is indexed */
+#define TEXT_BLOCK_SIZE        1048576  /* size of blocks holding lines read from a file */
+#define LINE_SLAB_SIZE           65536  /* size of slabs holding the lines of a file; a power of 2 */
+#define LINE_EXTRA_TABLE_SIZE       64  /* initial size of the table of line extras; a power of 2 */
+#define COMMENT_CHECKPOINT_LINES   256  /* lines between saved paired comment states */
+#define HIGHLIGHT_AHEAD_PAGES        1  /* screens of lines above and below the screen parsed while idle */
+#define REXX_VARIABLE_BATCH       1024  /* REXX variables queued for each call of RexxVariablePool() */
+#define MAX_LOAD_THREADS            64  /* maximum threads splitting a file into lines */
+#define LOAD_THREAD_MINIMUM    4194304  /* bytes of file for each of those threads */
+#define LAZY_LOAD_MINIMUM     67108864  /* bytes of file before the rest of it is read in the background */
+#define LAZY_LOAD_BLOCK        1048576  /* bytes of file read and split at a time in the background */
+#define LAZY_LOAD_TICK             100  /* milliseconds waited for a key before showing the size of a file being read */
+#define SAVE_IOV_MAX                64  /* pieces gathered for each write when saving */
+#define SAVE_STAGE_SIZE          65536  /* bytes of short pieces copied for each write when saving */
+#define SAVE_DIRECT_MINIMUM        256  /* pieces at least this long are written without copying */
+#define MEMFIND_SKIP_MINIMUM         4  /* length of string searched for with a skip table */
+#define SCAN_THREAD_MINIMUM      16384  /* lines of file for each thread testing a target */
+#define SCAN_WINDOW_LINES      1048576  /* most lines tested by threads before results are used */
+#define JOURNAL_MAX_SIZE      33554432  /* most bytes of edits kept for UNDO and REDO of each file */
 
 typedef unsigned char uchar;    /* additional typedef */
 
@@ -5,12 +5,6 @@
 #include "the.h"
 #include "proto.h"
 
-static uchar *rcvry[MAX_RECV];
-static long rcvry_len[MAX_RECV];
-static short add_rcvry = (-1);
-static short retr_rcvry = (-1);
-static short num_rcvry = 0;
-
 static int CompareLen = 0;
 static bool CompareExact;
 
@@ -300,96 +294,241 @@ uchar *strstrip(uchar *string, char option, char ch) {
   return (string);
 }
 
-long memfind(uchar *haystack, uchar *needle, long hay_len, long nee_len, bool case_ignore, bool arbsts, uchar arb_single, uchar arb_multiple, long *target_len) {
-  uchar c1 = 0, c2 = 0;
-  uchar *buf1 = NULL, *buf2 = NULL;
-  long i = 0, j = 0;
-  long matches = 0;
-  uchar *new_needle = needle;
-  bool need_free = FALSE;
+/*
+ * The string search engines below work on a needle prepared once by
+ * memfind_compile(); the needle is folded to lower case if case is to be
+ * ignored, and runs of arb_multiple are reduced to one.
+ */
+static uchar memfind_fold[256];
+static bool memfind_folded[256];
+static bool memfind_fold_ready = FALSE;
+
+static void memfind_init_fold(void) {
+  int i;
+
+  for (i = 0; i < 256; i++) {
+    memfind_fold[i] = (isupper(i)) ? tolower(i) : i;
+  }
+  for (i = 0; i < 256; i++) {
+    if (memfind_fold[i] != i) {
+      memfind_folded[i] = TRUE;
+      memfind_folded[memfind_fold[i]] = TRUE;
+    }
+  }
+  memfind_fold_ready = TRUE;
+}
+
+void memfind_compile(MEMFIND *mf, uchar *buf, uchar *needle, long nee_len, bool case_ignore, bool arbsts, uchar arb_single, uchar arb_multiple) {
+  long i, j;
+  uchar ch;
+  bool folded = FALSE;
 
+  if (!memfind_fold_ready) {
+    memfind_init_fold();
+  }
+  mf->needle = buf;
+  mf->case_ignore = case_ignore;
+  mf->arb_single = arb_single;
+  mf->arb_multiple = arb_multiple;
+  mf->type = MEMFIND_PLAIN;
   /*
-   * Strip any duplicate, contiguous occurrences of arb_multiple if we are handling arbchars.
+   * buf may be the same as needle; we never write ahead of what has been read.
    */
-  if (arbsts && strzeq(needle, arb_multiple) != (-1)) {
-    if ((new_needle = (uchar *) strdup((char*)needle)) == NULL) {
-      display_error(30, (uchar *) "", FALSE);
-      return (-1);
+  for (i = j = 0; i < nee_len; i++) {
+    ch = needle[i];
+    if (arbsts && (ch == arb_single || ch == arb_multiple)) {
+      mf->type = MEMFIND_ARBCHAR;
+      if (ch == arb_multiple && j > 0 && buf[j - 1] == arb_multiple) {
+        continue;
+      }
+      buf[j++] = ch;
+      continue;
     }
-    need_free = TRUE;
-    memrmdup(new_needle, &nee_len, arb_multiple);
-  }
-  for (i = 0; i < (hay_len - nee_len + 1); i++) {
-    buf1 = haystack + i;
-    buf2 = new_needle;
-    matches = 0;
-    for (j = 0; j < nee_len; j++) {
-      if (case_ignore) {
-        if (isupper(*buf1)) {
-          c1 = tolower(*buf1);
-        } else {
-          c1 = *buf1;
-        }
-        if (isupper(*buf2)) {
-          c2 = tolower(*buf2);
-        } else {
-          c2 = *buf2;
-        }
-      } else {
-        c1 = *buf1;
-        c2 = *buf2;
+    if (case_ignore && memfind_folded[ch]) {
+      folded = TRUE;
+      ch = memfind_fold[ch];
+    }
+    buf[j++] = ch;
+  }
+  buf[j] = '\0';
+  mf->length = j;
+  if (mf->type == MEMFIND_PLAIN && folded) {
+    mf->type = MEMFIND_CASELESS;
+  }
+  /*
+   * For longer strings, a skip table lets the search move on by up to the
+   * length of the string, based on the byte under its last character.
+   */
+  mf->use_skip = (mf->type != MEMFIND_ARBCHAR && j >= MEMFIND_SKIP_MINIMUM);
+  if (mf->use_skip) {
+    for (i = 0; i < 256; i++) {
+      mf->skip[i] = j;
+    }
+    for (i = 0; i < j - 1; i++) {
+      mf->skip[buf[i]] = j - 1 - i;
+    }
+  }
+}
+
+static long memfind_skip(MEMFIND *mf, uchar *haystack, long hay_len) {
+  uchar *needle = mf->needle, *fold = (mf->type == MEMFIND_CASELESS) ? memfind_fold : NULL;
+  long nee_len = mf->length, i, j, last = hay_len - mf->length;
+  uchar final = needle[nee_len - 1], ch;
+
+  for (i = 0; i <= last; i += mf->skip[ch]) {
+    ch = haystack[i + nee_len - 1];
+    if (fold) {
+      ch = fold[ch];
+    }
+    if (ch != final) {
+      continue;
+    }
+    if (fold) {
+      for (j = 0; j < nee_len - 1 && fold[haystack[i + j]] == needle[j]; j++);
+    } else {
+      for (j = 0; j < nee_len - 1 && haystack[i + j] == needle[j]; j++);
+    }
+    if (j == nee_len - 1) {
+      return (i);
+    }
+  }
+  return (-1);
+}
+
+static long memfind_plain(uchar *haystack, long hay_len, uchar *needle, long nee_len) {
+  uchar *pos = haystack, *last;
+
+  if (nee_len == 0) {
+    return ((hay_len >= 0) ? 0 : (-1));
+  }
+  if (hay_len < nee_len) {
+    return (-1);
+  }
+  /*
+   * memchr() finds candidates for the first byte a word at a time; the last
+   * byte is checked before comparing the rest.
+   */
+  last = haystack + (hay_len - nee_len);
+  while (pos <= last) {
+    pos = (uchar *) memchr(pos, needle[0], last - pos + 1);
+    if (pos == NULL) {
+      break;
+    }
+    if (pos[nee_len - 1] == needle[nee_len - 1] && memcmp(pos + 1, needle + 1, nee_len - 1) == 0) {
+      return (pos - haystack);
+    }
+    pos++;
+  }
+  return (-1);
+}
+
+static long memfind_caseless(uchar *haystack, long hay_len, uchar *needle, long nee_len) {
+  long i, j, last = hay_len - nee_len;
+  uchar first = needle[0], final = needle[nee_len - 1];
+
+  for (i = 0; i <= last; i++) {
+    if (memfind_fold[haystack[i]] != first || memfind_fold[haystack[i + nee_len - 1]] != final) {
+      continue;
+    }
+    for (j = 1; j < nee_len - 1; j++) {
+      if (memfind_fold[haystack[i + j]] != needle[j]) {
+        break;
       }
-      if (arbsts) {
-        if (c2 == arb_multiple) {
-          long new_hay_len = hay_len - (buf1 - haystack);
-          long new_nee_len = nee_len - (buf2 + 1 - new_needle);
-          long new_tar = 0;
-          long new_start;
-
-          *target_len = *target_len + matches;
-          new_start = memfind(buf1, buf2 + 1, new_hay_len, new_nee_len, case_ignore, arbsts, arb_single, arb_multiple, &new_tar);
-          if (new_start != (-1)) {
-            if (need_free) {
-              free(new_needle);
-            }
-            *target_len = *target_len + new_tar + new_start;
-            if (new_needle[nee_len - 1] == arb_multiple && new_start == 0) {
-              *target_len = hay_len - *target_len - 1;
-            }
-            return (i);
-          }
-        } else {
-          if (c1 != c2 && c2 != arb_single) {
+    }
+    if (j >= nee_len - 1) {
+      return (i);
+    }
+  }
+  return (-1);
+}
+
+static bool memfind_segment(MEMFIND *mf, uchar *haystack, uchar *segment, long seg_len) {
+  long i;
+
+  for (i = 0; i < seg_len; i++) {
+    if (segment[i] == mf->arb_single) {
+      continue;
+    }
+    if ((mf->case_ignore ? memfind_fold[haystack[i]] : haystack[i]) != segment[i]) {
+      return (FALSE);
+    }
+  }
+  return (TRUE);
+}
+
+static long memfind_arbchar(MEMFIND *mf, uchar *haystack, long hay_len, long *target_len) {
+  uchar *needle = mf->needle, *seg;
+  long nee_len = mf->length;
+  long first_len, seg_len, i, pos, end;
+
+  /*
+   * The needle is a series of segments separated by arb_multiple. The first
+   * segment is anchored at each column in turn; each later one is matched at
+   * its leftmost place after the one before. If a later segment cannot be
+   * placed, no match further right can place it either.
+   */
+  for (first_len = 0; first_len < nee_len && needle[first_len] != mf->arb_multiple; first_len++);
+  for (i = 0; i <= hay_len - first_len; i++) {
+    if (!memfind_segment(mf, haystack + i, needle, first_len)) {
+      continue;
+    }
+    pos = i + first_len;
+    seg = needle + first_len;
+    while (seg < needle + nee_len) {
+      seg++;
+      for (seg_len = 0; seg + seg_len < needle + nee_len && seg[seg_len] != mf->arb_multiple; seg_len++);
+      if (seg_len) {
+        for (; pos <= hay_len - seg_len; pos++) {
+          if (memfind_segment(mf, haystack + pos, seg, seg_len)) {
             break;
-          } else {
-            matches++;
           }
         }
-      }
-      else {
-        if (c1 != c2) {
-          break;
-        } else {
-          matches++;
+        if (pos > hay_len - seg_len) {
+          return (-1);
         }
+        pos += seg_len;
       }
-      ++buf1;
-      ++buf2;
-    }
-    if (matches == nee_len) {
-      if (need_free) {
-        free(new_needle);
-      }
-      *target_len = *target_len + matches;
-      return (i);
+      seg += seg_len;
     }
-  }
-  if (need_free) {
-    free(new_needle);
+    end = (nee_len && needle[nee_len - 1] == mf->arb_multiple) ? hay_len : pos;
+    *target_len = end - i;
+    return (i);
   }
   return (-1);
 }
 
+long memfind_run(MEMFIND *mf, uchar *haystack, long hay_len, long *target_len) {
+  long loc;
+
+  switch (mf->type) {
+    case MEMFIND_ARBCHAR:
+      return (memfind_arbchar(mf, haystack, hay_len, target_len));
+      break;
+    case MEMFIND_CASELESS:
+      loc = (mf->use_skip) ? memfind_skip(mf, haystack, hay_len) : memfind_caseless(haystack, hay_len, mf->needle, mf->length);
+      break;
+    default:
+      loc = (mf->use_skip) ? memfind_skip(mf, haystack, hay_len) : memfind_plain(haystack, hay_len, mf->needle, mf->length);
+      break;
+  }
+  if (loc != (-1)) {
+    *target_len = mf->length;
+  }
+  return (loc);
+}
+
+long memfind(uchar *haystack, uchar *needle, long hay_len, long nee_len, bool case_ignore, bool arbsts, uchar arb_single, uchar arb_multiple, long *target_len) {
+  MEMFIND mf;
+  uchar *buf;
+
+  if ((buf = (uchar *) alloca(nee_len + 1)) == NULL) {
+    display_error(30, (uchar *) "", FALSE);
+    return (-1);
+  }
+  memfind_compile(&mf, buf, needle, nee_len, case_ignore, arbsts, arb_single, arb_multiple);
+  return (memfind_run(&mf, haystack, hay_len, target_len));
+}
+
 void memrev(uchar *dest, uchar *src, long length) {
   long i, j;
 
@@ -560,7 +699,119 @@ uchar *strtrans(uchar *str, uchar oldch, uchar newch) {
   return (str);
 }
 
-LINE *add_LINE(LINE *first, LINE *curr, uchar *line, long len, ushort select, bool new_flag) {
+static uchar *store_text(FILE_DETAILS *cf, uchar *text, long len) {
+  TEXT_BLOCK *block = cf->first_text_block;
+  uchar *ptr = NULL;
+
+  /*
+   * Text that is already in a block read from a file, and has been nul
+   * terminated there by the caller, is used where it lies.
+   */
+  if (block && block->in_place && text >= block->text && text + len < block->text + block->size) {
+    return (text);
+  }
+  /*
+   * Lines are packed one after the other, each with a trailing nul,
+   * into the newest block; start a new block when that one is full.
+   */
+  if (block == NULL || block->size - block->used < len + 1) {
+    if ((block = (TEXT_BLOCK *) malloc(sizeof(TEXT_BLOCK))) == NULL) {
+      return (NULL);
+    }
+    block->size = max(TEXT_BLOCK_SIZE, len + 1);
+    block->used = 0;
+    block->in_place = FALSE;
+    if ((block->text = (uchar *) malloc(block->size * sizeof(uchar))) == NULL) {
+      free(block);
+      return (NULL);
+    }
+    block->next = cf->first_text_block;
+    cf->first_text_block = block;
+  }
+  ptr = block->text + block->used;
+  memcpy(ptr, text, len);
+  *(ptr + len) = '\0';
+  block->used += len + 1;
+  return (ptr);
+}
+
+void free_text_blocks(FILE_DETAILS *cf) {
+  TEXT_BLOCK *block = NULL;
+
+  while ((block = cf->first_text_block) != NULL) {
+    cf->first_text_block = block->next;
+    free(block->text);
+    free(block);
+  }
+  return;
+}
+
+uchar *read_text(FILE_DETAILS *cf, int fd, long *size) {
+  TEXT_BLOCK *block = NULL;
+  uchar *text = NULL;
+  ssize_t num = 0;
+  long len = 0;
+
+  if ((block = (TEXT_BLOCK *) malloc(sizeof(TEXT_BLOCK))) == NULL) {
+    return (NULL);
+  }
+  /*
+   * Read the whole file in one block, with a byte more than the file so
+   * that its last line can always be nul terminated. Should the file have
+   * shrunk since its size was found, only what could be read is used.
+   */
+  if ((text = (uchar *) malloc((*size + 1) * sizeof(uchar))) == NULL) {
+    free(block);
+    return (NULL);
+  }
+  while (len < *size) {
+    if ((num = read(fd, text + len, *size - len)) == (-1)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      free(text);
+      free(block);
+      lseek(fd, 0L, SEEK_SET);
+      return (NULL);
+    }
+    if (num == 0) {
+      break;
+    }
+    len += num;
+  }
+  *size = len;
+  block->text = text;
+  block->size = block->used = len + 1;
+  block->in_place = TRUE;
+  block->next = cf->first_text_block;
+  cf->first_text_block = block;
+  return (text);
+}
+
+uchar *alloc_text(FILE_DETAILS *cf, long size) {
+  TEXT_BLOCK *block = NULL;
+  uchar *text = NULL;
+
+  /*
+   * Allocate a block for a whole file that is read into it by the caller,
+   * with a byte more than the file, as read_text() does.
+   */
+  if ((block = (TEXT_BLOCK *) malloc(sizeof(TEXT_BLOCK))) == NULL) {
+    return (NULL);
+  }
+  if ((text = (uchar *) malloc((size + 1) * sizeof(uchar))) == NULL) {
+    free(block);
+    return (NULL);
+  }
+  block->text = text;
+  block->size = block->used = size + 1;
+  block->in_place = TRUE;
+  block->next = cf->first_text_block;
+  cf->first_text_block = block;
+  return (text);
+}
+
+static LINE *link_LINE(LINE *first, LINE *curr, FILE_DETAILS *cf, bool stored, uchar *line, long len, ushort select, bool new_flag) {
   /*
    * Validate that the line being added is shorter than the maximum line length
    */
@@ -568,23 +819,36 @@ LINE *add_LINE(LINE *first, LINE *curr, uchar *line, long len, ushort select, bo
     display_error(0, (uchar *) "Truncated", FALSE);
     len = max_line_length;
   }
-  next_line = lll_add(first, curr, sizeof(LINE));
+  if (cf) {
+    next_line = lll_add_to_pool(&cf->line_pool, first, curr);
+  } else {
+    next_line = lll_add(first, curr, sizeof(LINE));
+  }
   if (next_line == NULL) {
     return (NULL);
   }
   curr_line = next_line;
-  curr_line->line = (uchar *) malloc((len + 1) * sizeof(uchar));
+  /*
+   * If the line is to be stored, the line's contents go into the file's shared text blocks
+   * and are only copied to memory of their own if the line later grows.
+   */
+  if (stored) {
+    curr_line->line = store_text(cf, line, len);
+    curr_line->flags.shared_flag = TRUE;
+  } else {
+    curr_line->line = (uchar *) malloc((len + 1) * sizeof(uchar));
+    curr_line->flags.shared_flag = FALSE;
+  }
   if (curr_line->line == NULL) {
     return (NULL);
   }
-  memcpy(curr_line->line, line, len);
-  *(curr_line->line + len) = '\0';      /* for functions that expect ASCIIZ string */
+  if (!stored) {
+    memcpy(curr_line->line, line, len);
+    *(curr_line->line + len) = '\0';    /* for functions that expect ASCIIZ string */
+  }
   curr_line->length = len;
   curr_line->select = select;
   curr_line->save_select = select;
-  curr_line->pre = NULL;
-  curr_line->first_name = NULL;
-  curr_line->name = NULL; /* TODO - get rid of this when all uses of this structure for other purposes are changed */
   curr_line->flags.new_flag = new_flag;
   curr_line->flags.changed_flag = FALSE;
   curr_line->flags.tag_flag = FALSE;
@@ -599,8 +863,41 @@ LINE *add_LINE(LINE *first, LINE *curr, uchar *line, long len, ushort select, bo
   return (curr_line);
 }
 
+LINE *add_LINE(LINE *first, LINE *curr, uchar *line, long len, ushort select, bool new_flag) {
+  return (link_LINE(first, curr, NULL, FALSE, line, len, select, new_flag));
+}
+
+/*
+ * Adds a line to the lines of a file, allocating it from the file's pool;
+ * used for the first line of a file, as lines added next to it join its pool.
+ */
+LINE *add_pooled_LINE(FILE_DETAILS *cf, LINE *curr, uchar *line, long len, ushort select, bool new_flag) {
+  return (link_LINE(cf->first_line, curr, cf, FALSE, line, len, select, new_flag));
+}
+
+LINE *add_stored_LINE(FILE_DETAILS *cf, LINE *curr, uchar *line, long len) {
+  return (link_LINE(cf->first_line, curr, cf, TRUE, line, len, 0, FALSE));
+}
+
+uchar *resize_LINE(LINE *curr, long size) {
+  uchar *text = NULL;
+
+  /*
+   * Like realloc() of the line's contents, except that contents in a shared
+   * text block are copied to memory of their own rather than reallocated.
+   */
+  if (!curr->flags.shared_flag) {
+    return ((uchar *) realloc(curr->line, size * sizeof(uchar)));
+  }
+  if ((text = (uchar *) malloc(size * sizeof(uchar))) != NULL) {
+    memcpy(text, curr->line, min(size, curr->length + 1));
+    curr->flags.shared_flag = FALSE;
+  }
+  return (text);
+}
+
 LINE *append_LINE(LINE *curr, uchar *line, long len) {
-  curr->line = (uchar *) realloc(curr->line, (curr->length + len + 1) * sizeof(uchar));
+  curr->line = resize_LINE(curr, curr->length + len + 1);
   if (curr->line == NULL) {
     return (NULL);
   }
@@ -611,20 +908,17 @@ LINE *append_LINE(LINE *curr, uchar *line, long len) {
 }
 
 LINE *delete_LINE(LINE **first, LINE **last, LINE *curr, short direction, bool delete_names) {
-  if (delete_names) {
-    if (curr->first_name != (THELIST *) NULL) {
-      ll_free(curr->first_name, free);
-      curr->first_name = NULL;
-    }
-    if (curr->name) {
-      free(curr->name);
-      curr->name = NULL;
-    }
+  /*
+   * Any name of the line goes with its LINE_EXTRA in lll_del().
+   */
+  if (delete_names && LINE_FIRST_NAME(curr) != (THELIST *) NULL) {
+    ll_free(LINE_FIRST_NAME(curr), free);
+    lll_extra(curr, FALSE)->first_name = NULL;
   }
-  if (curr->line) {
+  if (curr->line && !curr->flags.shared_flag) {
     free(curr->line);
-    curr->line = NULL;
   }
+  curr->line = NULL;
   curr = lll_del(first, last, curr, direction);
   return (curr);
 }
@@ -679,7 +973,9 @@ short set_up_windows(short scrn) {
   /*
    * Save the position of the cursor in each window, and then delete the window.
    * Recreate each window, that has a valid size and move the cursor back to the position it had in each window.
+   * The new windows are blank, so every row of the file area has to be painted again.
    */
+  invalidate_screen_rows(scrn);
   for (i = 0; i < VIEW_WINDOWS; i++) {
     y = x = 0;
     if (screen[scrn].win[i] != (WINDOW *) NULL) {
@@ -835,12 +1131,12 @@ void pre_process_line(VIEW_DETAILS *the_view, long line_number, LINE *known_curr
   /*
    * Now set up the prefix command from the linked list...
    */
-  if (curr->pre == NULL) {
+  if (LINE_PRE(curr) == NULL) {
     memset(pre_rec, ' ', MAX_PREFIX_WIDTH);
     pre_rec_len = 0;
   } else {
     memset(pre_rec, ' ', MAX_PREFIX_WIDTH);
-    strcpy((char *) pre_rec, (char *) curr->pre->ppc_orig_command);
+    strcpy((char *) pre_rec, (char *) LINE_PRE(curr)->ppc_orig_command);
     pre_rec_len = strlen((char *) pre_rec);
     pre_rec[pre_rec_len] = ' ';
     pre_rec[MAX_PREFIX_WIDTH] = '\0';
@@ -888,16 +1184,14 @@ short post_process_line(VIEW_DETAILS *the_view, long line_number, LINE *known_cu
     increment_alt(the_view->file_for_view);
   }
   /*
-   * Add the old line contents to the line recovery list.
+   * Journal the change to the line.
    */
-  if (the_view->file_for_view->undoing) {
-    add_to_recovery_list(curr->line, curr->length);
-  }
+  journal_change(the_view->file_for_view, line_number, curr->line, curr->length, rec, rec_len);
   /*
    * Realloc the dynamic memory for the line if the line is now longer.
    */
   if (rec_len > curr->length) {
-    curr->line = (uchar *) realloc((void *) curr->line, (rec_len + 1) * sizeof(uchar));
+    curr->line = resize_LINE(curr, rec_len + 1);
     if (curr->line == NULL) {
       display_error(30, (uchar *) "", FALSE);
       return (RC_OUT_OF_MEMORY);
@@ -1043,94 +1337,6 @@ uchar case_translate(uchar key) {
   return (key);
 }
 
-void add_to_recovery_list(uchar *line, long len) {
-  short i = 0;
-
-  /*
-   * Ignore if running in batch.
-   */
-  if (batch_only) {
-    return;
-  }
-  /*
-   * First time through, set line array to NULL,  to indicated unused.
-   * This setup MUST occur before the freeing up code.
-   */
-  if (add_rcvry == (-1)) {
-    for (i = 0; i < MAX_RECV; i++) {
-      rcvry[i] = NULL;
-    }
-    add_rcvry = 0;              /* set to point to next available slot */
-  }
-  /*
-   * Now we are here, lets add to the array.
-   */
-  if (rcvry[add_rcvry] == NULL) {       /* haven't malloced yet */
-    if ((rcvry[add_rcvry] = (uchar *) malloc((len + 1) * sizeof(uchar))) == NULL) {
-      display_error(30, (uchar *) "", FALSE);
-      return;
-    }
-  } else {
-    if ((rcvry[add_rcvry] = (uchar *) realloc(rcvry[add_rcvry], (len + 1) * sizeof(uchar))) == NULL) {
-      display_error(30, (uchar *) "", FALSE);
-      return;
-    }
-  }
-  memcpy(rcvry[add_rcvry], line, len);
-  rcvry_len[add_rcvry] = len;
-  retr_rcvry = add_rcvry;
-  add_rcvry = (++add_rcvry >= MAX_RECV) ? 0 : add_rcvry;
-  num_rcvry = (++num_rcvry > MAX_RECV) ? MAX_RECV : num_rcvry;
-  return;
-}
-
-void get_from_recovery_list(short num) {
-  short i = 0;
-  short num_retr = min(num, num_rcvry);
-
-  /*
-   * Return error if nothing to recover.
-   */
-  if (retr_rcvry == (-1)) {
-    display_error(0, (uchar *) "0 line(s) recovered", TRUE);
-    return;
-  }
-  /*
-   * Retrieve each allocated recovery line and put back into the body.
-   */
-  post_process_line(CURRENT_VIEW, CURRENT_VIEW->focus_line, (LINE *) NULL, TRUE);
-  for (i = 0; i < num_retr; i++) {
-    if (rcvry[retr_rcvry] != NULL) {
-      insert_new_line(current_screen, CURRENT_VIEW, rcvry[retr_rcvry], rcvry_len[retr_rcvry], 1L, get_true_line(TRUE), TRUE, FALSE, FALSE, CURRENT_VIEW->display_low, TRUE, FALSE);
-      retr_rcvry = (--retr_rcvry < 0) ? num_rcvry - 1 : retr_rcvry;
-    }
-  }
-  /*
-   * If one or more lines were retrieved, increment the alteration counts
-   */
-  if (num_retr) {
-    increment_alt(CURRENT_FILE);
-  }
-  sprintf((char *) temp_cmd, "%d line(s) recovered", num_retr);
-  display_error(0, temp_cmd, TRUE);
-  return;
-}
-
-void free_recovery_list(void) {
-  short i = 0;
-
-  for (i = 0; i < MAX_RECV; i++) {
-    if (rcvry[i] != NULL) {
-      free(rcvry[i]);
-      rcvry[i] = NULL;
-    }
-  }
-  add_rcvry = (-1);
-  retr_rcvry = (-1);
-  num_rcvry = 0;
-  return;
-}
-
 short my_wclrtoeol(WINDOW *win) {
   short i = 0;
   short x = 0, y = 0, maxx = 0;
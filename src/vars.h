@@ -103,6 +103,8 @@ extern uchar tabkey_insert, tabkey_overwrite;
 extern uchar spooler_name[MAX_FILE_NAME + 1];
 extern struct stat stat_buf;
 extern long display_length;
+extern int load_threads;
+extern long sort_memory;
 extern short lastrc, compatible_look, compatible_feel, compatible_keys, prefix_width, prefix_gap;
 extern chtype etmode_table[256];
 extern bool etmode_flag[256];